@@ -0,0 +1,25 @@
+#version 450
+
+// Depth prepass of the float vertex layout: reads the position stream and nothing else.
+layout (location = 0) in vec3 in_position;
+
+layout (binding = 0) uniform Uniform_Buffer_Object
+{
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// See Draw_Constants in engine.hpp.
+layout (push_constant) uniform Draw_Constants
+{
+    mat4 node_matrix;
+} draw;
+
+// Must match triangle.vert exactly, the shading pass tests for equal depth.
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = ubo.proj * ubo.view * ubo.model * draw.node_matrix * vec4(in_position, 1.0);
+}
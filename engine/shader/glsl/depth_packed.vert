@@ -0,0 +1,29 @@
+#version 450
+
+// Depth prepass of the packed vertex layout: reads the position stream and nothing else.
+layout (location = 0) in uvec4 in_position_normal;
+
+layout (binding = 0) uniform Uniform_Buffer_Object
+{
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// See Draw_Constants in engine.hpp and Vertex_Quantization in vertex_packing.hpp.
+layout (push_constant) uniform Draw_Constants
+{
+    mat4 node_matrix;
+    vec4 position_offset;
+    vec4 position_scale;
+    vec4 tex_coord_transform;
+} draw;
+
+// Must match triangle_packed.vert exactly, the shading pass tests for equal depth.
+invariant gl_Position;
+
+void main()
+{
+    vec3 position = draw.position_offset.xyz + vec3(in_position_normal.xyz) * draw.position_scale.xyz;
+    gl_Position = ubo.proj * ubo.view * ubo.model * draw.node_matrix * vec4(position, 1.0);
+}
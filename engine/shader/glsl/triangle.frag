@@ -5,9 +5,10 @@ layout (location = 1) in vec2 frag_tex_coord;
 
 layout (location = 0) out vec4 out_color;
 
-layout (binding = 1) uniform sampler2D tex_sampler;
+// Set 1 is the material, bound once per material group.
+layout (set = 1, binding = 0) uniform sampler2D material_texture;
 
 void main()
 {
-    out_color = texture(tex_sampler, frag_tex_coord);
+    out_color = texture(material_texture, frag_tex_coord);
 }
@@ -14,9 +14,18 @@ layout (binding = 0) uniform Uniform_Buffer_Object
     mat4 proj;
 } ubo;
 
+// See Draw_Constants in engine.hpp.
+layout (push_constant) uniform Draw_Constants
+{
+    mat4 node_matrix;
+} draw;
+
+// The depth prepass computes the same position in depth.vert, the shading pass tests for equal depth.
+invariant gl_Position;
+
 void main()
 {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(in_position, 1.0);
+    gl_Position = ubo.proj * ubo.view * ubo.model * draw.node_matrix * vec4(in_position, 1.0);
     frag_color = in_color;
     frag_tex_coord = in_tex_coord;
 }
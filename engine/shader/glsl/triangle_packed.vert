@@ -0,0 +1,36 @@
+#version 450
+
+layout (location = 0) in uvec4 in_position_normal;
+layout (location = 1) in vec4 in_color;
+layout (location = 2) in vec2 in_tex_coord;
+
+layout (location = 0) out vec3 frag_color;
+layout (location = 1) out vec2 frag_tex_coord;
+
+layout (binding = 0) uniform Uniform_Buffer_Object
+{
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// See Draw_Constants in engine.hpp and Vertex_Quantization in vertex_packing.hpp.
+layout (push_constant) uniform Draw_Constants
+{
+    mat4 node_matrix;
+    vec4 position_offset;
+    vec4 position_scale;
+    vec4 tex_coord_transform;
+} draw;
+
+// Matches depth_packed.vert bit for bit, see triangle.vert.
+invariant gl_Position;
+
+void main()
+{
+    // w carries the octahedral normal, which the unlit triangle shading has no use for.
+    vec3 position = draw.position_offset.xyz + vec3(in_position_normal.xyz) * draw.position_scale.xyz;
+    gl_Position = ubo.proj * ubo.view * ubo.model * draw.node_matrix * vec4(position, 1.0);
+    frag_color = in_color.rgb;
+    frag_tex_coord = draw.tex_coord_transform.xy + in_tex_coord * draw.tex_coord_transform.zw;
+}
@@ -0,0 +1,539 @@
+#include "animation.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ANIMATION_USE_SSE2 1
+#else
+#define ANIMATION_USE_SSE2 0
+#endif
+
+inline namespace
+{
+    constexpr auto quat_component_max = 32767.0f;
+    constexpr auto sqrt_2 = 1.41421356f;
+
+    using Channel = Compressed_Animation::Channel;
+
+    // Four floats processed together, one per character of a batch.
+#if ANIMATION_USE_SSE2
+    struct Lanes final
+    {
+        __m128 v;
+    };
+
+    auto load(float const* values) -> Lanes { return {_mm_load_ps(values)}; }
+    auto store(float* values, Lanes a) -> void { _mm_store_ps(values, a.v); }
+    auto broadcast(float value) -> Lanes { return {_mm_set1_ps(value)}; }
+    auto operator+(Lanes a, Lanes b) -> Lanes { return {_mm_add_ps(a.v, b.v)}; }
+    auto operator-(Lanes a, Lanes b) -> Lanes { return {_mm_sub_ps(a.v, b.v)}; }
+    auto operator*(Lanes a, Lanes b) -> Lanes { return {_mm_mul_ps(a.v, b.v)}; }
+    auto inverse_sqrt(Lanes a) -> Lanes { return {_mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a.v))}; }
+
+    // value with its sign flipped in the lanes where sign is negative.
+    auto flip_where_negative(Lanes value, Lanes sign) -> Lanes
+    {
+        return {_mm_xor_ps(value.v, _mm_and_ps(sign.v, _mm_set1_ps(-0.0f)))};
+    }
+#else
+    struct Lanes final
+    {
+        float v[4];
+    };
+
+    template <typename Function>
+    auto per_lane(Function function) -> Lanes
+    {
+        auto result = Lanes{};
+        for (auto i = 0; i < 4; i++) result.v[i] = function(i);
+        return result;
+    }
+
+    auto load(float const* values) -> Lanes { return per_lane([&] (int i) { return values[i]; }); }
+    auto store(float* values, Lanes a) -> void { for (auto i = 0; i < 4; i++) values[i] = a.v[i]; }
+    auto broadcast(float value) -> Lanes { return per_lane([&] (int) { return value; }); }
+    auto operator+(Lanes a, Lanes b) -> Lanes { return per_lane([&] (int i) { return a.v[i] + b.v[i]; }); }
+    auto operator-(Lanes a, Lanes b) -> Lanes { return per_lane([&] (int i) { return a.v[i] - b.v[i]; }); }
+    auto operator*(Lanes a, Lanes b) -> Lanes { return per_lane([&] (int i) { return a.v[i] * b.v[i]; }); }
+    auto inverse_sqrt(Lanes a) -> Lanes { return per_lane([&] (int i) { return 1.0f / std::sqrt(a.v[i]); }); }
+
+    auto flip_where_negative(Lanes value, Lanes sign) -> Lanes
+    {
+        return per_lane([&] (int i) { return std::signbit(sign.v[i]) ? -value.v[i] : value.v[i]; });
+    }
+#endif
+
+    constexpr auto lane_count = (size_t) 4;
+
+    // The two keys around each character's time and how far along it is, transposed so every
+    // component of every key is one row of lanes.
+    struct alignas(16) Lane_Keys final
+    {
+        float translation_a[3][lane_count];
+        float translation_b[3][lane_count];
+        float translation_alpha[lane_count];
+        float rotation_a[4][lane_count];
+        float rotation_b[4][lane_count];
+        float rotation_alpha[lane_count];
+        float scale_a[3][lane_count];
+        float scale_b[3][lane_count];
+        float scale_alpha[lane_count];
+    };
+
+    auto wrap_time(float time, float duration) -> float
+    {
+        if (duration <= 0.0f) return 0.0f;
+        time = std::fmod(time, duration);
+        return time < 0.0f ? time + duration : time;
+    }
+
+    // Index of the last key at or before time; alpha blends it with the next one.
+    auto find_key(std::vector<float> const& times, float time, float& alpha) -> std::size_t
+    {
+        alpha = 0.0f;
+        if (times.size() <= 1 || time <= times.front()) return 0;
+        if (time >= times.back()) return times.size() - 1;
+
+        auto key = std::size_t(std::upper_bound(times.begin(), times.end(), time) - times.begin()) - 1;
+        auto span = times[key + 1] - times[key];
+        alpha = span > 0.0f ? (time - times[key]) / span : 0.0f;
+        return key;
+    }
+
+    auto next_key(std::vector<float> const& times, std::size_t key) -> std::size_t
+    {
+        return std::min(key + 1, times.size() - 1);
+    }
+
+    // Normalized lerp along the shorter arc; close enough to slerp between dense keys.
+    auto nlerp(glm::quat a, glm::quat b, float alpha) -> glm::quat
+    {
+        if (glm::dot(a, b) < 0.0f) b = -b;
+        return glm::normalize(glm::quat{
+            a.w + (b.w - a.w) * alpha,
+            a.x + (b.x - a.x) * alpha,
+            a.y + (b.y - a.y) * alpha,
+            a.z + (b.z - a.z) * alpha,
+        });
+    }
+
+    auto rotation_angle(glm::quat a, glm::quat b) -> float
+    {
+        return 2.0f * std::acos(std::min(std::abs(glm::dot(glm::normalize(a), glm::normalize(b))), 1.0f));
+    }
+
+    // Keys of one track that survive reduction: a key goes when linear interpolation between the
+    // kept keys around it stays within tolerance of every key they span. Constant tracks keep one key.
+    template <typename T, typename Lerp, typename Error>
+    auto reduce_keys(std::vector<float> const& times, std::vector<T> const& values, float tolerance, Lerp lerp, Error error) -> std::vector<std::size_t>
+    {
+        if (values.empty()) return {};
+        auto constant = std::all_of(values.begin(), values.end(), [&] (T const& value) { return error(value, values.front()) <= tolerance; });
+        if (values.size() == 1 || constant) return {0};
+
+        auto spans = [&] (std::size_t first, std::size_t last) {
+            for (auto key = first + 1; key < last; key++) {
+                auto span = times[last] - times[first];
+                auto alpha = span > 0.0f ? (times[key] - times[first]) / span : 0.0f;
+                if (error(lerp(values[first], values[last], alpha), values[key]) > tolerance) return false;
+            }
+            return true;
+        };
+
+        auto kept = std::vector<std::size_t>{0};
+        for (auto last = (size_t) 2; last < values.size(); last++) {
+            if (!spans(kept.back(), last)) kept.emplace_back(last - 1);
+        }
+        kept.emplace_back(values.size() - 1);
+        return kept;
+    }
+
+    // Splits a node transformation into the translation, rotation and scale a channel falls back to.
+    auto decompose(glm::mat4 const& transformation, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale) -> void
+    {
+        translation = glm::vec3{transformation[3]};
+        scale = glm::vec3{glm::length(glm::vec3{transformation[0]}), glm::length(glm::vec3{transformation[1]}), glm::length(glm::vec3{transformation[2]})};
+        auto basis = glm::mat3{
+            scale.x > 0.0f ? glm::vec3{transformation[0]} / scale.x : glm::vec3{1.0f, 0.0f, 0.0f},
+            scale.y > 0.0f ? glm::vec3{transformation[1]} / scale.y : glm::vec3{0.0f, 1.0f, 0.0f},
+            scale.z > 0.0f ? glm::vec3{transformation[2]} / scale.z : glm::vec3{0.0f, 0.0f, 1.0f},
+        };
+        rotation = glm::normalize(glm::quat_cast(basis));
+    }
+
+    auto gather_lane(Channel const& channel, float time, std::size_t lane, Lane_Keys& keys) -> void
+    {
+        auto alpha = 0.0f;
+        auto key = find_key(channel.translation_times, time, alpha);
+        auto a = channel.translations[key];
+        auto b = channel.translations[next_key(channel.translation_times, key)];
+        for (auto c = 0; c < 3; c++) {
+            keys.translation_a[c][lane] = a[c];
+            keys.translation_b[c][lane] = b[c];
+        }
+        keys.translation_alpha[lane] = alpha;
+
+        key = find_key(channel.rotation_times, time, alpha);
+        auto qa = unpack_quat(channel.rotations[key]);
+        auto qb = unpack_quat(channel.rotations[next_key(channel.rotation_times, key)]);
+        auto components_a = glm::vec4{qa.x, qa.y, qa.z, qa.w};
+        auto components_b = glm::vec4{qb.x, qb.y, qb.z, qb.w};
+        for (auto c = 0; c < 4; c++) {
+            keys.rotation_a[c][lane] = components_a[c];
+            keys.rotation_b[c][lane] = components_b[c];
+        }
+        keys.rotation_alpha[lane] = alpha;
+
+        key = find_key(channel.scale_times, time, alpha);
+        a = channel.scales[key];
+        b = channel.scales[next_key(channel.scale_times, key)];
+        for (auto c = 0; c < 3; c++) {
+            keys.scale_a[c][lane] = a[c];
+            keys.scale_b[c][lane] = b[c];
+        }
+        keys.scale_alpha[lane] = alpha;
+    }
+
+    // Blends the gathered keys of all lanes and composes translation * rotation * scale, written
+    // column-major as the top three rows of a mat4 per lane.
+    auto blend_lanes(Lane_Keys const& keys, float (&matrices)[12][lane_count]) -> void
+    {
+        auto lerp = [] (float const* a, float const* b, Lanes alpha) {
+            auto from = load(a);
+            return from + (load(b) - from) * alpha;
+        };
+
+        auto translation_alpha = load(keys.translation_alpha);
+        auto scale_alpha = load(keys.scale_alpha);
+        auto rotation_alpha = load(keys.rotation_alpha);
+
+        Lanes t[3], s[3], q[4];
+        for (auto c = 0; c < 3; c++) {
+            t[c] = lerp(keys.translation_a[c], keys.translation_b[c], translation_alpha);
+            s[c] = lerp(keys.scale_a[c], keys.scale_b[c], scale_alpha);
+        }
+
+        auto dot = broadcast(0.0f);
+        for (auto c = 0; c < 4; c++) dot = dot + load(keys.rotation_a[c]) * load(keys.rotation_b[c]);
+        auto length_squared = broadcast(0.0f);
+        for (auto c = 0; c < 4; c++) {
+            auto a = load(keys.rotation_a[c]);
+            auto b = flip_where_negative(load(keys.rotation_b[c]), dot);
+            q[c] = a + (b - a) * rotation_alpha;
+            length_squared = length_squared + q[c] * q[c];
+        }
+        auto inverse_length = inverse_sqrt(length_squared);
+        for (auto c = 0; c < 4; c++) q[c] = q[c] * inverse_length;
+
+        auto one = broadcast(1.0f);
+        auto two = broadcast(2.0f);
+        auto xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+        auto xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+        auto wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+
+        store(matrices[0], (one - two * (yy + zz)) * s[0]);
+        store(matrices[1], two * (xy + wz) * s[0]);
+        store(matrices[2], two * (xz - wy) * s[0]);
+        store(matrices[3], two * (xy - wz) * s[1]);
+        store(matrices[4], (one - two * (xx + zz)) * s[1]);
+        store(matrices[5], two * (yz + wx) * s[1]);
+        store(matrices[6], two * (xz + wy) * s[2]);
+        store(matrices[7], two * (yz - wx) * s[2]);
+        store(matrices[8], (one - two * (xx + yy)) * s[2]);
+        store(matrices[9], t[0]);
+        store(matrices[10], t[1]);
+        store(matrices[11], t[2]);
+    }
+
+    template <typename T>
+    auto track_bytes(std::vector<float> const& times, std::vector<T> const& values) -> std::size_t
+    {
+        return times.size() * sizeof(float) + values.size() * sizeof(T);
+    }
+}
+
+auto Animation_Size_Stats::operator+=(Animation_Size_Stats const& other) -> Animation_Size_Stats&
+{
+    raw_keys += other.raw_keys;
+    compressed_keys += other.compressed_keys;
+    raw_bytes += other.raw_bytes;
+    compressed_bytes += other.compressed_bytes;
+    return *this;
+}
+
+auto pack_quat(glm::quat q) -> Packed_Quat
+{
+    q = glm::normalize(q);
+    auto components = glm::vec4{q.x, q.y, q.z, q.w};
+
+    auto largest = 0;
+    for (auto c = 1; c < 4; c++) {
+        if (std::abs(components[c]) > std::abs(components[largest])) largest = c;
+    }
+
+    // q and -q are the same rotation, so the dropped component can always be positive.
+    auto sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+    std::uint16_t stored[3];
+    for (auto c = 0, i = 0; c < 4; c++) {
+        if (c == largest) continue;
+        auto unit = std::clamp(components[c] * sign * sqrt_2 * 0.5f + 0.5f, 0.0f, 1.0f);
+        stored[i++] = std::uint16_t(unit * quat_component_max + 0.5f);
+    }
+
+    return Packed_Quat{
+        std::uint16_t(stored[0] | ((largest & 1) << 15)),
+        std::uint16_t(stored[1] | ((largest >> 1) << 15)),
+        stored[2],
+    };
+}
+
+auto unpack_quat(Packed_Quat packed) -> glm::quat
+{
+    auto largest = (packed.a >> 15) | ((packed.b >> 15) << 1);
+    std::uint16_t const stored[3] = {std::uint16_t(packed.a & 0x7fff), std::uint16_t(packed.b & 0x7fff), std::uint16_t(packed.c & 0x7fff)};
+
+    auto components = glm::vec4{};
+    auto sum = 0.0f;
+    for (auto c = 0, i = 0; c < 4; c++) {
+        if (c == largest) continue;
+        components[c] = (float(stored[i++]) / quat_component_max * 2.0f - 1.0f) / sqrt_2;
+        sum += components[c] * components[c];
+    }
+    components[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+
+    return glm::quat{components.w, components.x, components.y, components.z};
+}
+
+auto compress_animation(
+    Assimp_Model::Animation const& animation,
+    std::vector<Assimp_Model::Node> const& nodes,
+    Animation_Compression_Options const& options
+) -> Compressed_Animation
+{
+    auto vector_error = [] (glm::vec3 a, glm::vec3 b) { return glm::length(a - b); };
+    auto vector_lerp = [] (glm::vec3 a, glm::vec3 b, float alpha) { return glm::mix(a, b, alpha); };
+
+    auto result = Compressed_Animation{};
+    result.duration = animation.duration;
+    result.name = animation.name;
+    result.channels.reserve(animation.channels.size());
+
+    for (auto const& src: animation.channels) {
+        if (src.node < 0 || std::size_t(src.node) >= nodes.size()) continue;
+
+        auto rest_translation = glm::vec3{};
+        auto rest_rotation = glm::quat{};
+        auto rest_scale = glm::vec3{};
+        decompose(nodes[src.node].transformation, rest_translation, rest_rotation, rest_scale);
+
+        auto channel = Channel{};
+        channel.node = src.node;
+
+        for (auto key: reduce_keys(src.translation_times, src.translations, options.translation_tolerance, vector_lerp, vector_error)) {
+            channel.translation_times.emplace_back(src.translation_times[key]);
+            channel.translations.emplace_back(src.translations[key]);
+        }
+        for (auto key: reduce_keys(src.rotation_times, src.rotations, options.rotation_tolerance, nlerp, rotation_angle)) {
+            channel.rotation_times.emplace_back(src.rotation_times[key]);
+            channel.rotations.emplace_back(pack_quat(src.rotations[key]));
+        }
+        for (auto key: reduce_keys(src.scale_times, src.scales, options.scale_tolerance, vector_lerp, vector_error)) {
+            channel.scale_times.emplace_back(src.scale_times[key]);
+            channel.scales.emplace_back(src.scales[key]);
+        }
+
+        if (channel.translations.empty()) {
+            channel.translation_times.emplace_back(0.0f);
+            channel.translations.emplace_back(rest_translation);
+        }
+        if (channel.rotations.empty()) {
+            channel.rotation_times.emplace_back(0.0f);
+            channel.rotations.emplace_back(pack_quat(rest_rotation));
+        }
+        if (channel.scales.empty()) {
+            channel.scale_times.emplace_back(0.0f);
+            channel.scales.emplace_back(rest_scale);
+        }
+        result.channels.emplace_back(std::move(channel));
+    }
+
+    return result;
+}
+
+auto measure_animation_size(Assimp_Model::Animation const& animation, Compressed_Animation const& compressed) -> Animation_Size_Stats
+{
+    auto stats = Animation_Size_Stats{};
+    for (auto const& channel: animation.channels) {
+        stats.raw_keys += channel.translations.size() + channel.rotations.size() + channel.scales.size();
+        stats.raw_bytes += sizeof(channel.node) + track_bytes(channel.translation_times, channel.translations)
+                         + track_bytes(channel.rotation_times, channel.rotations) + track_bytes(channel.scale_times, channel.scales);
+    }
+    for (auto const& channel: compressed.channels) {
+        stats.compressed_keys += channel.translations.size() + channel.rotations.size() + channel.scales.size();
+        stats.compressed_bytes += sizeof(channel.node) + track_bytes(channel.translation_times, channel.translations)
+                                + track_bytes(channel.rotation_times, channel.rotations) + track_bytes(channel.scale_times, channel.scales);
+    }
+    return stats;
+}
+
+auto measure_compression_error(Assimp_Model::Animation const& animation, Compressed_Animation const& compressed) -> Animation_Compression_Error
+{
+    auto error = Animation_Compression_Error{};
+
+    // Channels of nodes outside the model were dropped by compress_animation() and are skipped here too.
+    auto channel = compressed.channels.begin();
+    for (auto const& src: animation.channels) {
+        if (channel == compressed.channels.end() || channel->node != src.node) continue;
+
+        auto alpha = 0.0f;
+        for (auto key = (size_t) 0; key < src.translations.size(); key++) {
+            auto k = find_key(channel->translation_times, src.translation_times[key], alpha);
+            auto value = glm::mix(channel->translations[k], channel->translations[next_key(channel->translation_times, k)], alpha);
+            error.translation = std::max(error.translation, glm::length(value - src.translations[key]));
+        }
+        for (auto key = (size_t) 0; key < src.rotations.size(); key++) {
+            auto k = find_key(channel->rotation_times, src.rotation_times[key], alpha);
+            auto value = nlerp(unpack_quat(channel->rotations[k]), unpack_quat(channel->rotations[next_key(channel->rotation_times, k)]), alpha);
+            error.rotation_radians = std::max(error.rotation_radians, rotation_angle(value, src.rotations[key]));
+        }
+        for (auto key = (size_t) 0; key < src.scales.size(); key++) {
+            auto k = find_key(channel->scale_times, src.scale_times[key], alpha);
+            auto value = glm::mix(channel->scales[k], channel->scales[next_key(channel->scale_times, k)], alpha);
+            error.scale = std::max(error.scale, glm::length(value - src.scales[key]));
+        }
+        ++channel;
+    }
+
+    return error;
+}
+
+auto sample_animation(Compressed_Animation const& animation, float const* times, Transform_Hierarchy* hierarchies, std::size_t count) -> void
+{
+    if (count == 0) return;
+
+    auto keys = Lane_Keys{};
+    alignas(16) float matrices[12][lane_count];
+
+    for (auto const& channel: animation.channels) {
+        for (auto first = (size_t) 0; first < count; first += lane_count) {
+            // A short last batch repeats its final character in the unused lanes.
+            auto lanes = std::min(lane_count, count - first);
+            for (auto lane = (size_t) 0; lane < lane_count; lane++) {
+                auto character = first + std::min(lane, lanes - 1);
+                gather_lane(channel, wrap_time(times[character], animation.duration), lane, keys);
+            }
+
+            blend_lanes(keys, matrices);
+
+            for (auto lane = (size_t) 0; lane < lanes; lane++) {
+                auto local = glm::mat4{
+                    glm::vec4{matrices[0][lane], matrices[1][lane], matrices[2][lane], 0.0f},
+                    glm::vec4{matrices[3][lane], matrices[4][lane], matrices[5][lane], 0.0f},
+                    glm::vec4{matrices[6][lane], matrices[7][lane], matrices[8][lane], 0.0f},
+                    glm::vec4{matrices[9][lane], matrices[10][lane], matrices[11][lane], 1.0f},
+                };
+                hierarchies[first + lane].set_local(channel.node, local);
+            }
+        }
+    }
+}
+
+auto sample_animation_reference(Compressed_Animation const& animation, float time, Transform_Hierarchy& hierarchy) -> void
+{
+    time = wrap_time(time, animation.duration);
+
+    for (auto const& channel: animation.channels) {
+        auto alpha = 0.0f;
+        auto key = find_key(channel.translation_times, time, alpha);
+        auto translation = glm::mix(channel.translations[key], channel.translations[next_key(channel.translation_times, key)], alpha);
+
+        key = find_key(channel.rotation_times, time, alpha);
+        auto rotation = nlerp(unpack_quat(channel.rotations[key]), unpack_quat(channel.rotations[next_key(channel.rotation_times, key)]), alpha);
+
+        key = find_key(channel.scale_times, time, alpha);
+        auto scale = glm::mix(channel.scales[key], channel.scales[next_key(channel.scale_times, key)], alpha);
+
+        auto local = glm::translate(glm::mat4{1.0f}, translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4{1.0f}, scale);
+        hierarchy.set_local(channel.node, local);
+    }
+}
+
+auto benchmark_animation(std::string const& path, std::size_t character_count, Model_Load_Options const& options) -> void
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    auto model = load_model(path, options);
+    if (model.animations.empty()) {
+        std::cout << "No animations in " << path << std::endl;
+        return;
+    }
+
+    auto clips = std::vector<Compressed_Animation>{};
+    auto total = Animation_Size_Stats{};
+    auto start = Clock::now();
+    for (auto const& animation: model.animations) {
+        clips.emplace_back(compress_animation(animation, model.nodes));
+    }
+    auto compress_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    for (auto i = (size_t) 0; i < clips.size(); i++) {
+        auto stats = measure_animation_size(model.animations[i], clips[i]);
+        auto error = measure_compression_error(model.animations[i], clips[i]);
+        total += stats;
+        std::cout << "Animation " << clips[i].name << ": " << clips[i].channels.size() << " channels, " << clips[i].duration << " s, keys "
+                  << stats.raw_keys << " -> " << stats.compressed_keys << ", bytes " << stats.raw_bytes << " -> " << stats.compressed_bytes
+                  << ", error: translation " << error.translation << ", rotation " << glm::degrees(error.rotation_radians)
+                  << " degrees, scale " << error.scale << std::endl;
+    }
+    std::cout << "Compressed " << clips.size() << " animations in " << compress_ms << " ms: " << total.raw_bytes << " -> " << total.compressed_bytes
+              << " bytes (" << (total.raw_bytes ? double(total.compressed_bytes) * 100.0 / double(total.raw_bytes) : 0.0) << "%)" << std::endl;
+
+    // Every character plays the first clip at its own phase, over a couple of seconds at 60 Hz.
+    auto const& clip = clips.front();
+    auto const frame_count = (size_t) 240;
+    auto const frame_time = 1.0f / 60.0f;
+    auto hierarchies = std::vector<Transform_Hierarchy>(character_count, Transform_Hierarchy{model.nodes});
+    auto reference = std::vector<Transform_Hierarchy>(character_count, Transform_Hierarchy{model.nodes});
+    auto times = std::vector<float>(character_count);
+    auto set_times = [&] (std::size_t frame) {
+        for (auto i = (size_t) 0; i < character_count; i++) {
+            times[i] = float(frame) * frame_time + clip.duration * float(i) / float(character_count);
+        }
+    };
+
+    start = Clock::now();
+    for (auto frame = (size_t) 0; frame < frame_count; frame++) {
+        set_times(frame);
+        sample_animation(clip, times.data(), hierarchies.data(), character_count);
+    }
+    auto batched_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (auto frame = (size_t) 0; frame < frame_count; frame++) {
+        set_times(frame);
+        for (auto i = (size_t) 0; i < character_count; i++) sample_animation_reference(clip, times[i], reference[i]);
+    }
+    auto reference_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    auto difference = 0.0f;
+    for (auto i = (size_t) 0; i < character_count; i++) {
+        for (auto const& channel: clip.channels) {
+            auto const& a = hierarchies[i].local(channel.node);
+            auto const& b = reference[i].local(channel.node);
+            for (auto c = 0; c < 4; c++) difference = std::max(difference, glm::length(a[c] - b[c]));
+        }
+    }
+
+    auto bones = double(clip.channels.size() * character_count * frame_count);
+    std::cout << "Sampled " << clip.channels.size() << " bones of " << character_count << " characters for " << frame_count << " frames: "
+              << (batched_seconds > 0.0 ? bones / batched_seconds / 1e6 : 0.0) << " M bones/s batched ("
+              << (ANIMATION_USE_SSE2 ? "SSE2" : "scalar lanes") << "), "
+              << (reference_seconds > 0.0 ? bones / reference_seconds / 1e6 : 0.0) << " M bones/s reference, "
+              << "largest difference " << difference << std::endl;
+}
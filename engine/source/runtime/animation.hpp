@@ -0,0 +1,91 @@
+#pragma once
+#include "loader.hpp"
+#include "transform_hierarchy.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Unit quaternion in 48 bits, smallest three: the largest component is dropped and rebuilt from
+// the unit length, the other three lie in [-1/sqrt(2), 1/sqrt(2)] and keep 15 bits each. The top
+// bits of a and b hold the index of the dropped component.
+struct Packed_Quat final
+{
+    std::uint16_t a{};
+    std::uint16_t b{};
+    std::uint16_t c{};
+};
+
+auto pack_quat(glm::quat q) -> Packed_Quat;
+auto unpack_quat(Packed_Quat packed) -> glm::quat;
+
+// Largest deviation key reduction may introduce on each track.
+struct Animation_Compression_Options final
+{
+    float translation_tolerance{1e-4f};     // model units
+    float rotation_tolerance{1e-3f};        // radians
+    float scale_tolerance{1e-4f};
+};
+
+// An Animation after key reduction and rotation quantization, laid out for sampling. Every
+// channel has all three tracks; tracks the source leaves out hold the node's own transformation
+// as a single key, so sampling writes complete local transforms.
+struct Compressed_Animation final
+{
+    struct Channel final
+    {
+        Assimp_Model::Array_Index node{-1};     // index for nodes array
+        std::vector<float> translation_times;
+        std::vector<glm::vec3> translations;
+        std::vector<float> rotation_times;
+        std::vector<Packed_Quat> rotations;
+        std::vector<float> scale_times;
+        std::vector<glm::vec3> scales;
+    };
+
+    float duration{};
+    std::vector<Channel> channels;
+
+    std::string name;
+};
+
+struct Animation_Size_Stats final
+{
+    std::size_t raw_keys{};
+    std::size_t compressed_keys{};
+    std::size_t raw_bytes{};
+    std::size_t compressed_bytes{};
+
+    auto operator+=(Animation_Size_Stats const& other) -> Animation_Size_Stats&;
+};
+
+// Largest difference between the raw and the compressed clip, over every raw key time.
+struct Animation_Compression_Error final
+{
+    float translation{};
+    float rotation_radians{};
+    float scale{};
+};
+
+// Drops every key the neighbouring kept keys reproduce within the tolerances, then packs the rotations.
+auto compress_animation(
+    Assimp_Model::Animation const& animation,
+    std::vector<Assimp_Model::Node> const& nodes,
+    Animation_Compression_Options const& options = {}
+) -> Compressed_Animation;
+
+auto measure_animation_size(Assimp_Model::Animation const& animation, Compressed_Animation const& compressed) -> Animation_Size_Stats;
+auto measure_compression_error(Assimp_Model::Animation const& animation, Compressed_Animation const& compressed) -> Animation_Compression_Error;
+
+// Samples the clip for a batch of characters sharing one skeleton: character i at times[i],
+// wrapped into the clip, into the local transforms of hierarchies[i]. Characters are blended
+// four at a time in SIMD lanes, channel by channel.
+auto sample_animation(Compressed_Animation const& animation, float const* times, Transform_Hierarchy* hierarchies, std::size_t count) -> void;
+
+// Reference for sample_animation(): one character, plain glm.
+auto sample_animation_reference(Compressed_Animation const& animation, float time, Transform_Hierarchy& hierarchy) -> void;
+
+// Loads the model at path, compresses its clips, logs compressed against raw size and error and
+// times both samplers over character_count characters in sampled bones per second.
+auto benchmark_animation(std::string const& path, std::size_t character_count, Model_Load_Options const& options = {}) -> void;
@@ -0,0 +1,156 @@
+#include "asset_archive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+inline namespace
+{
+    struct Archive_Header final
+    {
+        std::uint32_t magic{};
+        std::uint32_t version{};
+        std::uint32_t entry_count{};
+        std::uint32_t reserved{};
+    };
+
+    auto align_up(std::uint64_t value) -> std::uint64_t
+    {
+        return (value + archive_alignment - 1) / archive_alignment * archive_alignment;
+    }
+
+    // The name an entry is stored and looked up under: relative, normalized, '/' separated.
+    auto entry_name(std::filesystem::path const& path, std::filesystem::path const& root) -> std::string
+    {
+        auto relative = path.lexically_normal().lexically_relative(root.lexically_normal());
+        if (relative.empty() || *relative.begin() == "..") return {};
+        return relative.generic_string();
+    }
+
+    template <typename T>
+    auto read_value(std::byte const*& cursor, std::byte const* end) -> T
+    {
+        if (sizeof(T) > std::size_t(end - cursor)) {
+            throw std::runtime_error("failed to read asset archive: truncated directory!");
+        }
+        auto value = T{};
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+}
+
+Asset_Archive::Asset_Archive(std::string const& archive_path, std::string const& mount_point)
+    : file{std::make_shared<Mapped_File const>(archive_path)}
+    , mount_point{mount_point}
+{
+    if (!file->valid() || file->size() < sizeof(Archive_Header)) {
+        throw std::runtime_error("failed to open asset archive: " + archive_path + "!");
+    }
+
+    auto cursor = file->data();
+    auto end = file->data() + file->size();
+    auto header = read_value<Archive_Header>(cursor, end);
+    if (header.magic != asset_archive_magic || header.version != asset_archive_version) {
+        throw std::runtime_error("failed to open asset archive: " + archive_path + " is not a version " + std::to_string(asset_archive_version) + " archive!");
+    }
+
+    entries.reserve(header.entry_count);
+    for (auto i = (size_t) 0; i < header.entry_count; i++) {
+        auto entry = Entry{};
+        entry.offset = read_value<std::uint64_t>(cursor, end);
+        entry.size = read_value<std::uint64_t>(cursor, end);
+        auto name_size = read_value<std::uint32_t>(cursor, end);
+        if (name_size > std::size_t(end - cursor)) {
+            throw std::runtime_error("failed to read asset archive: truncated directory!");
+        }
+        auto name = std::string{reinterpret_cast<char const*>(cursor), name_size};
+        cursor += name_size;
+
+        if (entry.offset > file->size() || entry.size > file->size() - entry.offset) {
+            throw std::runtime_error("failed to read asset archive: " + name + " lies outside of " + archive_path + "!");
+        }
+        entries.emplace(std::move(name), entry);
+    }
+}
+
+auto Asset_Archive::find(std::string const& path) const -> Mapped_Bytes
+{
+    auto name = entry_name(std::filesystem::path{path}, std::filesystem::path{mount_point});
+    if (name.empty()) return {};
+
+    auto entry = entries.find(name);
+    if (entry == entries.end()) return {};
+    return Mapped_Bytes{file, file->data() + entry->second.offset, std::size_t(entry->second.size)};
+}
+
+auto write_asset_archive(std::string const& archive_path, std::string const& directory) -> std::size_t
+{
+    auto root = std::filesystem::path{directory};
+    auto archive = std::filesystem::path{archive_path};
+
+    // Sorted, so packing the same directory twice gives the same archive.
+    auto files = std::vector<std::filesystem::path>{};
+    for (auto const& item: std::filesystem::recursive_directory_iterator{root}) {
+        if (!item.is_regular_file()) continue;
+        if (std::filesystem::exists(archive) && std::filesystem::equivalent(item.path(), archive)) continue;
+        files.emplace_back(item.path());
+    }
+    std::sort(files.begin(), files.end());
+
+    auto names = std::vector<std::string>{};
+    auto directory_size = std::uint64_t(sizeof(Archive_Header));
+    for (auto const& path: files) {
+        names.emplace_back(entry_name(path, root));
+        directory_size += 2 * sizeof(std::uint64_t) + sizeof(std::uint32_t) + names.back().size();
+    }
+
+    auto sources = std::vector<Mapped_File>{};
+    auto offsets = std::vector<std::uint64_t>{};
+    auto offset = align_up(directory_size);
+    for (auto const& path: files) {
+        sources.emplace_back(path.string());
+        if (!sources.back().valid() && std::filesystem::file_size(path) != 0) {
+            throw std::runtime_error("failed to read asset: " + path.string() + "!");
+        }
+        offsets.emplace_back(offset);
+        offset = align_up(offset + sources.back().size());
+    }
+
+    write_file_atomically(archive_path, [&] (std::ostream& out) {
+        auto header = Archive_Header{asset_archive_magic, asset_archive_version, std::uint32_t(files.size())};
+        out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        for (auto i = (size_t) 0; i < files.size(); i++) {
+            auto size = std::uint64_t(sources[i].size());
+            auto name_size = std::uint32_t(names[i].size());
+            out.write(reinterpret_cast<char const*>(&offsets[i]), sizeof(offsets[i]));
+            out.write(reinterpret_cast<char const*>(&size), sizeof(size));
+            out.write(reinterpret_cast<char const*>(&name_size), sizeof(name_size));
+            out.write(names[i].data(), std::streamsize(names[i].size()));
+        }
+
+        auto const padding = std::vector<char>(archive_alignment, 0);
+        auto position = directory_size;
+        for (auto i = (size_t) 0; i < files.size(); i++) {
+            out.write(padding.data(), std::streamsize(offsets[i] - position));
+            out.write(reinterpret_cast<char const*>(sources[i].data()), std::streamsize(sources[i].size()));
+            position = offsets[i] + sources[i].size();
+        }
+    });
+    return files.size();
+}
+
+auto map_asset(std::string const& path, Asset_Archive const* archive) -> Mapped_Bytes
+{
+    if (archive) {
+        auto bytes = archive->find(path);
+        if (bytes.valid()) return bytes;
+    }
+
+    auto file = std::make_shared<Mapped_File const>(path);
+    if (!file->valid()) return {};
+    return Mapped_Bytes{file, file->data(), file->size()};
+}
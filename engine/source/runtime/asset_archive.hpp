@@ -0,0 +1,58 @@
+#pragma once
+#include "mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// The bytes of one asset, straight out of a mapping that stays alive as long as they are held.
+struct Mapped_Bytes final
+{
+    std::shared_ptr<Mapped_File const> file{};
+    std::byte const* data{nullptr};
+    std::size_t size{0};
+
+    auto valid() const -> bool { return data != nullptr; }
+};
+
+// Many asset files packed into one, mapped as a whole. Entries are found by their path below the
+// mount point, so a loader asking for <mount point>/<entry> reads it from the archive.
+//
+// Layout: magic, version and entry count (three uint32_t, padded to 16 bytes), then per entry
+// its offset and size in bytes (two uint64_t), the length of its name (uint32_t) and the name
+// with '/' separators, then the file contents, each aligned to archive_alignment.
+class Asset_Archive final
+{
+public:
+    // Throws when the archive can not be read or is not one.
+    Asset_Archive(std::string const& archive_path, std::string const& mount_point);
+
+    // An invalid Mapped_Bytes when the path is not below the mount point or not in the archive.
+    auto find(std::string const& path) const -> Mapped_Bytes;
+
+    auto size() const -> std::size_t { return entries.size(); }
+
+private:
+    struct Entry final
+    {
+        std::uint64_t offset{};
+        std::uint64_t size{};
+    };
+
+    std::shared_ptr<Mapped_File const> file{};
+    std::string mount_point{};
+    std::unordered_map<std::string, Entry> entries{};
+};
+
+constexpr std::uint32_t asset_archive_magic = 0x4b415041; // "APAK"
+constexpr std::uint32_t asset_archive_version = 1;
+constexpr std::size_t archive_alignment = 16;
+
+// Packs every regular file below directory, named by its path relative to it, and returns how
+// many there were. Throws when a file can not be read or the archive not written.
+auto write_asset_archive(std::string const& archive_path, std::string const& directory) -> std::size_t;
+
+// The file from the archive when it holds it, otherwise mapped from the file system.
+auto map_asset(std::string const& path, Asset_Archive const* archive = nullptr) -> Mapped_Bytes;
@@ -0,0 +1,117 @@
+#include "asset_loader.hpp"
+#include "bounds.hpp"
+#include "thread_pool.hpp"
+
+#include <array>
+#include <iostream>
+#include <utility>
+
+auto make_placeholder_model() -> Assimp_Model
+{
+    auto model = Assimp_Model{};
+    auto root = Assimp_Model::Node{};
+    root.transformation = glm::mat4{1.0f};
+    root.name = "placeholder";
+    model.nodes.emplace_back(root);
+
+    auto mesh = Assimp_Model::Mesh{};
+    mesh.parent = 0;
+    mesh.name = "placeholder";
+
+    // Four corners per face, so every face gets its own normal and the whole texture.
+    auto const faces = std::array<std::pair<glm::vec3, glm::vec3>, 6>{{
+        {{ 1.0f,  0.0f,  0.0f}, {0.0f, 1.0f, 0.0f}},
+        {{-1.0f,  0.0f,  0.0f}, {0.0f, 0.0f, 1.0f}},
+        {{ 0.0f,  1.0f,  0.0f}, {0.0f, 0.0f, 1.0f}},
+        {{ 0.0f, -1.0f,  0.0f}, {1.0f, 0.0f, 0.0f}},
+        {{ 0.0f,  0.0f,  1.0f}, {1.0f, 0.0f, 0.0f}},
+        {{ 0.0f,  0.0f, -1.0f}, {0.0f, 1.0f, 0.0f}},
+    }};
+    auto const corners = std::array<glm::vec2, 4>{{{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}}};
+
+    auto& vertex_info = mesh.vertex_info;
+    for (auto const& face: faces) {
+        auto normal = face.first;
+        auto u = face.second;
+        auto v = glm::cross(normal, u);
+        auto first = static_cast<std::uint32_t>(vertex_info.position.size());
+        for (auto corner: corners) {
+            vertex_info.position.emplace_back(0.5f * (normal + (corner.x * 2.0f - 1.0f) * u + (corner.y * 2.0f - 1.0f) * v));
+            vertex_info.normal.emplace_back(normal);
+            vertex_info.texcoord.emplace_back(corner);
+            vertex_info.color.emplace_back(1.0f);
+        }
+        mesh.topology.push_back({first, first + 1, first + 2});
+        mesh.topology.push_back({first, first + 2, first + 3});
+    }
+
+    model.meshes.emplace_back(std::move(mesh));
+    compute_model_bounds(model);
+    return model;
+}
+
+auto make_placeholder_texture() -> Texture_Pixels
+{
+    auto texture = Texture_Pixels{};
+    texture.width = 8;
+    texture.height = 8;
+    texture.pixels.resize((size_t) texture.width * texture.height * 4);
+    for (auto y = (std::uint32_t) 0; y < texture.height; y++) {
+        for (auto x = (std::uint32_t) 0; x < texture.width; x++) {
+            auto value = static_cast<unsigned char>(((x ^ y) & 1) ? 96 : 160);
+            auto pixel = texture.pixels.data() + ((size_t) y * texture.width + x) * 4;
+            pixel[0] = value;
+            pixel[1] = value;
+            pixel[2] = value;
+            pixel[3] = 255;
+        }
+    }
+    return texture;
+}
+
+Asset_Loader::Asset_Loader(Thread_Pool& thread_pool)
+    : thread_pool{thread_pool}
+{
+}
+
+auto Asset_Loader::request_model(std::string path, Model_Load_Options const& options) -> void
+{
+    model_request.path = path;
+    model_request.start = Clock::now();
+    model_request.result = thread_pool.submit([path = std::move(path), options] { return load_model(path, options); });
+}
+
+auto Asset_Loader::request_texture(std::string path, Texture_Load_Options const& options) -> void
+{
+    texture_request.path = path;
+    texture_request.start = Clock::now();
+    texture_request.result = thread_pool.submit([path = std::move(path), options] { return load_texture(path, options); });
+}
+
+template <typename Asset>
+auto Asset_Loader::take(Request<Asset>& request) -> std::optional<Asset>
+{
+    if (!request.result.valid() || request.result.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+        return std::nullopt;
+    }
+
+    auto asset = request.result.get();
+    auto ms = std::chrono::duration<double, std::milli>(Clock::now() - request.start).count();
+    std::cout << "Loaded " << request.path << " in the background: ready after " << ms << " ms" << std::endl;
+    return asset;
+}
+
+auto Asset_Loader::take_model() -> std::optional<Assimp_Model>
+{
+    return take(model_request);
+}
+
+auto Asset_Loader::take_texture() -> std::optional<Cooked_Texture>
+{
+    return take(texture_request);
+}
+
+auto Asset_Loader::pending() const -> bool
+{
+    return model_request.result.valid() || texture_request.result.valid();
+}
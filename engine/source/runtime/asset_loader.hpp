@@ -0,0 +1,54 @@
+#pragma once
+#include "loader.hpp"
+#include "texture_cooker.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <optional>
+#include <string>
+#include <vector>
+
+class Thread_Pool;
+
+// Shown until the real assets arrive: a unit cube around the origin under a single root node,
+// and a small grey checkerboard.
+auto make_placeholder_model() -> Assimp_Model;
+auto make_placeholder_texture() -> Texture_Pixels;
+
+// Runs file I/O, importing and decoding on a thread pool. The render thread polls with take_*()
+// once a frame and does the GPU uploads itself, so the window keeps presenting meanwhile.
+class Asset_Loader final
+{
+public:
+    using Clock = std::chrono::high_resolution_clock;
+
+    explicit Asset_Loader(Thread_Pool& thread_pool);
+
+    // A new request replaces an earlier one of the same kind that was not taken yet.
+    auto request_model(std::string path, Model_Load_Options const& options) -> void;
+    auto request_texture(std::string path, Texture_Load_Options const& options) -> void;
+
+    // The finished asset, once per request, or nothing while the worker is still busy.
+    // Whatever the worker threw is rethrown here.
+    auto take_model() -> std::optional<Assimp_Model>;
+    auto take_texture() -> std::optional<Cooked_Texture>;
+
+    auto pending() const -> bool;
+
+private:
+    template <typename Asset>
+    struct Request final
+    {
+        std::future<Asset> result{};
+        std::string path{};
+        Clock::time_point start{};
+    };
+
+    template <typename Asset>
+    auto take(Request<Asset>& request) -> std::optional<Asset>;
+
+    Thread_Pool& thread_pool;
+    Request<Assimp_Model> model_request{};
+    Request<Cooked_Texture> texture_request{};
+};
@@ -0,0 +1,257 @@
+#include "bounds.hpp"
+#include "thread_pool.hpp"
+#include "transform_hierarchy.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOUNDS_USE_SSE2 1
+#else
+#define BOUNDS_USE_SSE2 0
+#endif
+
+inline namespace
+{
+    using Bounds = Assimp_Model::Bounds;
+
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "positions are read as packed float triples");
+
+    auto sphere_around(glm::vec3 center, float radius_squared) -> glm::vec4
+    {
+        return glm::vec4{center, std::sqrt(radius_squared)};
+    }
+
+#if BOUNDS_USE_SSE2
+    // Four positions fill three registers as x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3; they are
+    // transposed into one register per axis.
+    auto load_positions(float const* values, __m128& x, __m128& y, __m128& z) -> void
+    {
+        auto r0 = _mm_loadu_ps(values);
+        auto r1 = _mm_loadu_ps(values + 4);
+        auto r2 = _mm_loadu_ps(values + 8);
+
+        auto x23 = _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(0, 1, 0, 2));
+        x = _mm_shuffle_ps(r0, x23, _MM_SHUFFLE(2, 0, 3, 0));
+        auto y01 = _mm_shuffle_ps(r0, r1, _MM_SHUFFLE(0, 0, 0, 1));
+        auto y23 = _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(0, 2, 0, 3));
+        y = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0));
+        auto z01 = _mm_shuffle_ps(r0, r1, _MM_SHUFFLE(0, 1, 0, 2));
+        auto z23 = _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(0, 3, 0, 0));
+        z = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0));
+    }
+
+    auto horizontal_min(__m128 v) -> float
+    {
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(v);
+    }
+
+    auto horizontal_max(__m128 v) -> float
+    {
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(v);
+    }
+#endif
+}
+
+auto compute_bounds(glm::vec3 const* positions, std::size_t count) -> Assimp_Model::Bounds
+{
+#if BOUNDS_USE_SSE2
+    auto bounds = Bounds{};
+    if (count == 0) return bounds;
+
+    auto values = reinterpret_cast<float const*>(positions);
+    auto const simd_count = count & ~std::size_t{3};
+
+    auto min_x = _mm_set1_ps(bounds.min.x);
+    auto min_y = min_x;
+    auto min_z = min_x;
+    auto max_x = _mm_set1_ps(bounds.max.x);
+    auto max_y = max_x;
+    auto max_z = max_x;
+    for (auto i = (size_t) 0; i < simd_count; i += 4) {
+        auto x = __m128{};
+        auto y = __m128{};
+        auto z = __m128{};
+        load_positions(values + i * 3, x, y, z);
+        min_x = _mm_min_ps(min_x, x);
+        min_y = _mm_min_ps(min_y, y);
+        min_z = _mm_min_ps(min_z, z);
+        max_x = _mm_max_ps(max_x, x);
+        max_y = _mm_max_ps(max_y, y);
+        max_z = _mm_max_ps(max_z, z);
+    }
+    bounds.min = glm::vec3{horizontal_min(min_x), horizontal_min(min_y), horizontal_min(min_z)};
+    bounds.max = glm::vec3{horizontal_max(max_x), horizontal_max(max_y), horizontal_max(max_z)};
+    for (auto i = simd_count; i < count; i++) {
+        bounds.min = glm::min(bounds.min, positions[i]);
+        bounds.max = glm::max(bounds.max, positions[i]);
+    }
+
+    // Second pass: the largest squared distance to the box center.
+    auto center = (bounds.min + bounds.max) * 0.5f;
+    auto center_x = _mm_set1_ps(center.x);
+    auto center_y = _mm_set1_ps(center.y);
+    auto center_z = _mm_set1_ps(center.z);
+    auto farthest = _mm_setzero_ps();
+    for (auto i = (size_t) 0; i < simd_count; i += 4) {
+        auto x = __m128{};
+        auto y = __m128{};
+        auto z = __m128{};
+        load_positions(values + i * 3, x, y, z);
+        x = _mm_sub_ps(x, center_x);
+        y = _mm_sub_ps(y, center_y);
+        z = _mm_sub_ps(z, center_z);
+        auto distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        farthest = _mm_max_ps(farthest, distance);
+    }
+    auto radius_squared = horizontal_max(farthest);
+    for (auto i = simd_count; i < count; i++) {
+        auto offset = positions[i] - center;
+        radius_squared = std::max(radius_squared, offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+    }
+
+    bounds.sphere = sphere_around(center, radius_squared);
+    return bounds;
+#else
+    return compute_bounds_reference(positions, count);
+#endif
+}
+
+auto compute_bounds_reference(glm::vec3 const* positions, std::size_t count) -> Assimp_Model::Bounds
+{
+    auto bounds = Bounds{};
+    if (count == 0) return bounds;
+
+    for (auto i = (size_t) 0; i < count; i++) {
+        bounds.min = glm::min(bounds.min, positions[i]);
+        bounds.max = glm::max(bounds.max, positions[i]);
+    }
+
+    auto center = (bounds.min + bounds.max) * 0.5f;
+    auto radius_squared = 0.0f;
+    for (auto i = (size_t) 0; i < count; i++) {
+        auto offset = positions[i] - center;
+        radius_squared = std::max(radius_squared, offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+    }
+
+    bounds.sphere = sphere_around(center, radius_squared);
+    return bounds;
+}
+
+auto transform_bounds(Assimp_Model::Bounds const& bounds, glm::mat4 const& transformation) -> Assimp_Model::Bounds
+{
+    if (bounds.empty()) return bounds;
+
+    // Every output axis is a sum over the input axes, each contributing its smaller and larger end.
+    auto result = Bounds{};
+    result.min = glm::vec3{transformation[3]};
+    result.max = result.min;
+    for (auto column = 0; column < 3; column++) {
+        auto a = glm::vec3{transformation[column]} * bounds.min[column];
+        auto b = glm::vec3{transformation[column]} * bounds.max[column];
+        result.min += glm::min(a, b);
+        result.max += glm::max(a, b);
+    }
+
+    auto scale = std::max({
+        glm::length(glm::vec3{transformation[0]}),
+        glm::length(glm::vec3{transformation[1]}),
+        glm::length(glm::vec3{transformation[2]})
+    });
+    result.sphere = glm::vec4{glm::vec3{transformation * glm::vec4{glm::vec3{bounds.sphere}, 1.0f}}, bounds.sphere.w * scale};
+    return result;
+}
+
+auto merge_bounds(Assimp_Model::Bounds const& a, Assimp_Model::Bounds const& b) -> Assimp_Model::Bounds
+{
+    if (a.empty()) return b;
+    if (b.empty()) return a;
+
+    auto result = Bounds{};
+    result.min = glm::min(a.min, b.min);
+    result.max = glm::max(a.max, b.max);
+
+    auto offset = glm::vec3{b.sphere} - glm::vec3{a.sphere};
+    auto distance = glm::length(offset);
+    if (distance + b.sphere.w <= a.sphere.w) {
+        result.sphere = a.sphere;
+    } else if (distance + a.sphere.w <= b.sphere.w) {
+        result.sphere = b.sphere;
+    } else {
+        auto radius = (distance + a.sphere.w + b.sphere.w) * 0.5f;
+        result.sphere = glm::vec4{glm::vec3{a.sphere} + offset * ((radius - a.sphere.w) / distance), radius};
+    }
+    return result;
+}
+
+auto compute_model_bounds(Assimp_Model& model, Thread_Pool* thread_pool) -> void
+{
+    for_each_index(thread_pool, model.meshes.size(), [&] (std::size_t i) {
+        auto const& position = model.meshes[i].vertex_info.position;
+        model.meshes[i].bounds = compute_bounds(position.data(), position.size());
+    });
+
+    auto hierarchy = Transform_Hierarchy{model.nodes};
+    hierarchy.update();
+    for (auto& node: model.nodes) node.world_bounds = Bounds{};
+    for (auto const& mesh: model.meshes) {
+        if (mesh.parent < 0) continue;
+        auto& node_bounds = model.nodes[mesh.parent].world_bounds;
+        node_bounds = merge_bounds(node_bounds, transform_bounds(mesh.bounds, hierarchy.world(mesh.parent)));
+    }
+
+    // Children come after their parents, so a backward pass folds every subtree into its root.
+    for (auto i = model.nodes.size(); i-- > 0;) {
+        auto parent = model.nodes[i].parent;
+        if (parent >= 0) model.nodes[parent].world_bounds = merge_bounds(model.nodes[parent].world_bounds, model.nodes[i].world_bounds);
+    }
+}
+
+auto benchmark_bounds(std::size_t vertex_count) -> void
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    auto random = std::mt19937{42};
+    auto distribution = std::uniform_real_distribution<float>{-100.0f, 100.0f};
+    auto positions = std::vector<glm::vec3>(vertex_count);
+    for (auto& position: positions) position = glm::vec3{distribution(random), distribution(random), distribution(random)};
+
+    // Enough repetitions for roughly a gigabyte of positions per variant.
+    auto const bytes = double(vertex_count * sizeof(glm::vec3));
+    auto const repetitions = std::max<std::size_t>(1, std::size_t((1u << 30) / std::max(bytes, 1.0)));
+
+    auto time = [&] (auto&& compute, Bounds& result) {
+        auto start = Clock::now();
+        for (auto i = (size_t) 0; i < repetitions; i++) result = compute(positions.data(), positions.size());
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    auto simd = Bounds{};
+    auto reference = Bounds{};
+    auto simd_seconds = time(compute_bounds, simd);
+    auto reference_seconds = time(compute_bounds_reference, reference);
+
+    auto difference = std::max({
+        glm::length(simd.min - reference.min),
+        glm::length(simd.max - reference.max),
+        glm::length(simd.sphere - reference.sphere)
+    });
+    auto report = [&] (double seconds) {
+        auto total = double(repetitions) * bytes;
+        return seconds > 0.0 ? total / seconds / 1e9 : 0.0;
+    };
+    std::cout << "Bounds of " << vertex_count << " positions, " << repetitions << " times: "
+              << report(simd_seconds) << " GB/s (" << (BOUNDS_USE_SSE2 ? "SSE2" : "scalar") << "), "
+              << report(reference_seconds) << " GB/s reference, "
+              << (simd_seconds > 0.0 ? double(repetitions * vertex_count) / simd_seconds / 1e6 : 0.0) << " M positions/s, "
+              << "largest difference " << difference << std::endl;
+}
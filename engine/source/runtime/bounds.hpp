@@ -0,0 +1,26 @@
+#pragma once
+#include "loader.hpp"
+
+#include <cstddef>
+
+class Thread_Pool;
+
+// Box around the positions from a min/max reduction four positions at a time in SIMD lanes, and
+// the sphere around the box center through the farthest position.
+auto compute_bounds(glm::vec3 const* positions, std::size_t count) -> Assimp_Model::Bounds;
+
+// Reference for compute_bounds(): one position at a time, plain glm.
+auto compute_bounds_reference(glm::vec3 const* positions, std::size_t count) -> Assimp_Model::Bounds;
+
+// The box around the transformed box, and the sphere scaled by the longest axis of transformation.
+auto transform_bounds(Assimp_Model::Bounds const& bounds, glm::mat4 const& transformation) -> Assimp_Model::Bounds;
+
+// The smallest box and the smallest sphere around both.
+auto merge_bounds(Assimp_Model::Bounds const& a, Assimp_Model::Bounds const& b) -> Assimp_Model::Bounds;
+
+// Fills Mesh::bounds, in parallel when a pool is given, then Node::world_bounds from the rest pose.
+auto compute_model_bounds(Assimp_Model& model, Thread_Pool* thread_pool = nullptr) -> void;
+
+// Times compute_bounds() against the reference over vertex_count random positions and logs the
+// throughput of both in positions and bytes per second.
+auto benchmark_bounds(std::size_t vertex_count) -> void;
@@ -1,7 +1,14 @@
 #include "engine.hpp"
+#include "skinning.hpp"
 #include "triangle_vert.h"
 #include "triangle_frag.h"
+#include "triangle_packed_vert.h"
+#include "depth_vert.h"
+#include "depth_packed_vert.h"
 #include "compute_comp.h"
+#include "skinning_comp.h"
+#include "morph_comp.h"
+#include "mipgen_comp.h"
 #include "compute_vert.h"
 #include "compute_frag.h"
 
@@ -70,6 +77,17 @@ inline namespace
 
     auto asset_dir = source_dir + "Vulkan-Tutorial/engine/asset/";
 
+    auto cache_dir = source_dir + "Vulkan-Tutorial/engine/generated/cache/";
+
+    auto config_path = source_dir + "Vulkan-Tutorial/engine/config/global-config.ini";
+
+    auto const camera_position = glm::vec3{2.0f, 2.0f, 2.0f};
+    auto const camera_fov_y = glm::radians(45.0f);
+    auto const camera_near = 0.1f;
+
+    // The coarsest level whose error projects to at most this many pixels gets drawn.
+    auto const lod_error_threshold = 1.0f;
+
     struct Particle final
     {
         glm::vec2 position{};
@@ -106,10 +124,37 @@ inline namespace
 
     auto last_frame_time = 0.0f;
     auto last_time = (double) 0.0;
+
+    // Average frame time per vertex layout, reported every couple of seconds for A/B comparisons.
+    auto const frame_report_interval = 2.0;
+    auto frame_report_start = (double) 0.0;
+    auto frame_report_count = (size_t) 0;
+    auto frame_draw_count = (size_t) 0;
+    auto frame_bind_count = (size_t) 0;     // pipelines, vertex and index buffers and descriptor sets
+    auto vertex_toggle_held = false;
+    auto depth_prepass_toggle_held = false;
+
+    // GPU time of the morph and skinning passes over the same interval.
+    auto morph_report_ms = (double) 0.0;
+    auto morph_report_deltas = (size_t) 0;
+    auto skinning_report_ms = (double) 0.0;
+    auto skinning_report_vertices = (size_t) 0;
+    auto morph_toggle_held = false;
+
+    auto texture_vk_format(Texture_Format format) -> VkFormat
+    {
+        switch (format) {
+            case Texture_Format::bc1: return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+            case Texture_Format::bc3: return VK_FORMAT_BC3_SRGB_BLOCK;
+            default: return VK_FORMAT_R8G8B8A8_SRGB;
+        }
+    }
 }
 
 auto Hello_Triangle_Application::run() -> void
 {
+    startup_time = Asset_Loader::Clock::now();
+
     init_window();
 
     init_vulkan();
@@ -144,7 +189,12 @@ auto Hello_Triangle_Application::init_vulkan() -> void
 
     pick_physical_device();
 
+    // The workers read the assets while the device and the pipelines are set up. The texture is
+    // cooked for what the picked device can sample.
+    request_assets();
+
     create_logical_device();
+    query_timestamp_support();
 
     create_swap_chain();
 
@@ -158,8 +208,13 @@ auto Hello_Triangle_Application::init_vulkan() -> void
     create_graphics_pipeline();
     create_graphics_pipeline2();
     create_compute_pipeline();
+    create_skinning_pipeline();
+    create_morph_pipeline();
+    create_mip_generation_pipeline();
 
     create_command_pool();
+    create_staging_ring();
+    texture_residency = Texture_Residency{texture_budget, TEXTURE_TAIL_SIZE};
 
     create_shader_storage_buffers();
 
@@ -169,9 +224,12 @@ auto Hello_Triangle_Application::init_vulkan() -> void
 
     create_framebuffers();
 
-    load_models();
+    install_model(make_placeholder_model());
 
-    create_texture_image();
+    // Uncompressed, so cooking its few levels costs nothing before the first frame.
+    auto placeholder_options = Texture_Cook_Options{};
+    placeholder_options.compress = false;
+    create_texture_image(cook_texture(make_placeholder_texture(), placeholder_options));
 
     create_texture_image_view();
 
@@ -181,6 +239,8 @@ auto Hello_Triangle_Application::init_vulkan() -> void
 
     create_index_buffer();
 
+    create_vertex_animation_resources();
+
     create_uniform_buffers();
 
     create_descriptor_pool();
@@ -188,6 +248,7 @@ auto Hello_Triangle_Application::init_vulkan() -> void
 
     create_descriptor_sets();
     create_compute_descriptor_sets();
+    create_material_descriptor_sets();
 
     create_command_buffers();
     create_compute_command_buffers();
@@ -195,43 +256,747 @@ auto Hello_Triangle_Application::init_vulkan() -> void
     create_sync_objects();
 }
 
-auto Hello_Triangle_Application::load_models() -> void
+auto Hello_Triangle_Application::request_assets() -> void
+{
+    auto load_options = Model_Load_Options{};
+    load_options.cache_dir = cache_dir;
+    load_options.import_profile = load_import_profile(config_path);
+    load_options.thread_pool = &worker_pool;
+    load_options.lod_levels = 4;
+
+    // Packed with Engine --pack-assets engine/asset engine/asset/assets.pak; loose files are the fallback.
+    auto archive_path = asset_dir + "assets.pak";
+    if (Mapped_File{archive_path}.valid()) {
+        asset_archive.emplace(archive_path, asset_dir);
+        load_options.archive = &*asset_archive;
+        std::cout << "Reading models from " << archive_path << ", " << asset_archive->size() << " files" << std::endl;
+    }
+    asset_loader.request_model(asset_dir + model_file, load_options);
+
+    auto supported_features = VkPhysicalDeviceFeatures{};
+    vkGetPhysicalDeviceFeatures(physical_device, &supported_features);
+    texture_compression_bc = supported_features.textureCompressionBC == VK_TRUE;
+
+    auto texture_options = Texture_Load_Options{};
+    texture_options.cache_dir = cache_dir;
+    texture_options.archive = load_options.archive;
+    texture_options.cook.compress = texture_compression_bc;
+    texture_options.cook.thread_pool = &worker_pool;
+    if (texture_mips != Mip_Generation::cooked) {
+        // The GPU fills in the chain from an uncompressed top level.
+        texture_options.cook.compress = false;
+        texture_options.cook.build_mips = false;
+    }
+    asset_loader.request_texture(asset_dir + "viking_room.png", texture_options);
+}
+
+auto Hello_Triangle_Application::install_model(Assimp_Model loaded_model) -> void
+{
+    model = std::move(loaded_model);
+    model_hierarchy = Transform_Hierarchy{model.nodes};
+
+    model_animations.clear();
+    model_positions.clear();
+    model_attributes.clear();
+    model_indices.clear();
+    model_packed_positions.clear();
+    model_packed_attributes.clear();
+    model_draw_ranges.clear();
+    skin_vertices.clear();
+    skin_bone_count = 0;
+    morph_vertices.clear();
+    morph_deltas.clear();
+    morph_keys.clear();
+    morph_weights.clear();
+
+    auto animation_size = Animation_Size_Stats{};
+    for (auto const& animation: model.animations) {
+        model_animations.emplace_back(compress_animation(animation, model.nodes));
+        animation_size += measure_animation_size(animation, model_animations.back());
+    }
+    if (!model_animations.empty()) {
+        std::cout << "Animations: " << model_animations.size() << " clips, keys " << animation_size.raw_keys << " -> " << animation_size.compressed_keys
+                  << ", bytes " << animation_size.raw_bytes << " -> " << animation_size.compressed_bytes << std::endl;
+    }
+
+    // Every mesh goes into the same vertex and index buffers. Indices stay local to their mesh and
+    // the draw adds vertex_offset, so they only need to address the largest single mesh.
+    auto largest_mesh = (size_t) 0;
+    auto packing_error = Vertex_Packing_Error{};
+    auto dense_morph_bytes = (size_t) 0;
+    for (auto mesh_index = (size_t) 0; mesh_index < model.meshes.size(); mesh_index++) {
+        auto const& mesh = model.meshes[mesh_index];
+        auto const& position = mesh.vertex_info.position;
+        auto const& normal = mesh.vertex_info.normal;
+        auto const& tex_coord = mesh.vertex_info.texcoord;
+        auto const& color = mesh.vertex_info.color;
+
+        auto range = Draw_Range{};
+        range.mesh = static_cast<uint32_t>(mesh_index);
+        range.material = mesh.material;
+        range.first_index = static_cast<uint32_t>(model_indices.size());
+        range.index_count = static_cast<uint32_t>(mesh.topology.size() * 3);
+        range.vertex_offset = static_cast<int32_t>(model_positions.size());
+        range.quantization = compute_vertex_quantization(mesh);
+        range.bone_offset = skin_bone_count;
+
+        // Coarser levels follow the full mesh in the same index buffer.
+        for (auto triangle: mesh.topology) {
+            model_indices.emplace_back(triangle.a);
+            model_indices.emplace_back(triangle.b);
+            model_indices.emplace_back(triangle.c);
+        }
+        for (auto triangle: mesh.lod_topology) {
+            model_indices.emplace_back(triangle.a);
+            model_indices.emplace_back(triangle.b);
+            model_indices.emplace_back(triangle.c);
+        }
+
+        // Vertex_Info is already split by attribute, the streams only gather it across meshes.
+        model_positions.insert(model_positions.end(), position.begin(), position.end());
+        for (auto i = (size_t) 0; i < position.size(); i++) {
+            auto attributes = Vertex_Attributes{};
+            attributes.tex_coord = tex_coord.empty() ? glm::vec2{0.0f} : tex_coord[i];
+            model_attributes.emplace_back(attributes);
+
+            auto packed_position = pack_position(range.quantization, position[i]);
+            auto packed_normal = normal.empty() ? pack_normal(glm::vec3{0.0f, 0.0f, 1.0f}) : pack_normal(normal[i]);
+            model_packed_positions.emplace_back(packed_position, packed_normal);
+
+            auto packed_attributes = Packed_Vertex_Attributes{};
+            packed_attributes.color = color.empty() ? glm::u8vec4{0} : pack_color(color[i]);
+            packed_attributes.tex_coord = tex_coord.empty() ? glm::u16vec2{0} : pack_tex_coord(range.quantization, tex_coord[i]);
+            model_packed_attributes.emplace_back(packed_attributes);
+        }
+
+        auto mesh_error = measure_packing_error(mesh, range.quantization);
+        packing_error.position = std::max(packing_error.position, mesh_error.position);
+        packing_error.tex_coord = std::max(packing_error.tex_coord, mesh_error.tex_coord);
+        packing_error.normal_degrees = std::max(packing_error.normal_degrees, mesh_error.normal_degrees);
+
+        // Every vertex moved by at least one shape key gets a slot, shared by all keys of the mesh,
+        // so the morph pass only touches those and never the whole mesh.
+        auto morph_slots = std::vector<uint32_t>{};
+        if (!mesh.shape_keys.empty()) {
+            morph_slots.assign(position.size(), ~0u);
+            for (auto const& shape_key: mesh.shape_keys) {
+                auto key = Morph_Key{};
+                key.first_delta = static_cast<uint32_t>(morph_deltas.size());
+                key.delta_count = static_cast<uint32_t>(shape_key.vertices.size());
+                key.default_weight = shape_key.default_weight;
+                for (auto i = (size_t) 0; i < shape_key.vertices.size(); i++) {
+                    auto vertex = shape_key.vertices[i];
+                    if (morph_slots[vertex] == ~0u) {
+                        morph_slots[vertex] = static_cast<uint32_t>(morph_vertices.size());
+                        morph_vertices.emplace_back(Morph_Vertex{position[vertex], static_cast<uint32_t>(range.vertex_offset + vertex)});
+                    }
+                    morph_deltas.emplace_back(Morph_Delta{shape_key.position_deltas[i], morph_slots[vertex]});
+                }
+                morph_keys.emplace_back(key);
+                morph_weights.emplace_back(key.default_weight);
+                dense_morph_bytes += position.size() * sizeof(glm::vec3);
+            }
+        }
+
+        // Skinned vertices keep their bind pose here, the skinning pass writes the posed copy.
+        if (!mesh.bones.empty()) {
+            auto const& bone_indices = mesh.vertex_info.bone_indices;
+            auto const& bone_weights = mesh.vertex_info.bone_weights;
+            for (auto i = (size_t) 0; i < position.size(); i++) {
+                auto skin_vertex = Skin_Vertex{};
+                skin_vertex.position = position[i];
+                skin_vertex.morph_slot = morph_slots.empty() ? ~0u : morph_slots[i];
+                skin_vertex.target = static_cast<uint32_t>(range.vertex_offset + i);
+                memcpy(&skin_vertex.bone_indices, &bone_indices[i], sizeof(uint32_t));
+                memcpy(&skin_vertex.bone_weights, &bone_weights[i], sizeof(uint32_t));
+                skin_vertex.bone_offset = range.bone_offset;
+                skin_vertices.emplace_back(skin_vertex);
+            }
+            skin_bone_count += static_cast<uint32_t>(mesh.bones.size());
+        }
+
+        largest_mesh = std::max(largest_mesh, position.size());
+        model_draw_ranges.emplace_back(range);
+    }
+
+    // Draws sharing a material end up next to each other, so material state changes once per group.
+    std::stable_sort(model_draw_ranges.begin(), model_draw_ranges.end(), [](Draw_Range const& lhs, Draw_Range const& rhs) {
+        return lhs.material < rhs.material;
+    });
+
+    // The model only rotates around its origin, so the rest pose stays within extent of it; twice that
+    // leaves room for animation. Keeping the far plane tight keeps depth precision where the model is.
+    auto extent = 0.0f;
+    for (auto const& node: model.nodes) {
+        if (node.parent >= 0 || node.world_bounds.empty()) continue;
+        extent = std::max(extent, glm::length(glm::vec3{node.world_bounds.sphere}) + node.world_bounds.sphere.w);
+    }
+    if (extent > 0.0f) camera_far = glm::length(camera_position) + 2.0f * extent;
+    std::cout << "Model bounds: extent " << extent << " around the origin, far plane at " << camera_far << std::endl;
+
+    // 16 bit indices halve the index buffer whenever every vertex of a mesh is addressable with them.
+    model_index_type = largest_mesh <= 65536 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    auto index_size = model_index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    std::cout << "Model buffers: " << model_draw_ranges.size() << " meshes, " << model.materials.size() << " materials, " << model.textures.size() << " textures, "
+              << model_positions.size() << " vertices (" << model_positions.size() * (sizeof(glm::vec3) + sizeof(Vertex_Attributes)) << " bytes, packed "
+              << model_packed_positions.size() * (sizeof(glm::u16vec4) + sizeof(Packed_Vertex_Attributes)) << " bytes), "
+              << model_indices.size() << " indices (" << model_indices.size() * index_size << " bytes)" << std::endl;
+    std::cout << "Vertex streams: a depth prepass fetches " << sizeof(glm::vec3) << " of " << sizeof(glm::vec3) + sizeof(Vertex_Attributes)
+              << " bytes per float vertex and " << sizeof(glm::u16vec4) << " of " << sizeof(glm::u16vec4) + sizeof(Packed_Vertex_Attributes)
+              << " per packed vertex (" << model_positions.size() * sizeof(glm::vec3) << " and " << model_packed_positions.size() * sizeof(glm::u16vec4)
+              << " bytes for the whole model)" << std::endl;
+    std::cout << "Vertex packing error: position " << packing_error.position << ", tex coord " << packing_error.tex_coord
+              << ", normal " << packing_error.normal_degrees << " degrees" << std::endl;
+    if (!skin_vertices.empty()) {
+        std::cout << "Skinning: " << skin_vertices.size() << " vertices, " << skin_bone_count << " bones, "
+                  << skinning_instance_count << " instance(s), drawn with the float vertex layout" << std::endl;
+    }
+    if (!morph_vertices.empty()) {
+        std::cout << "Shape keys: " << morph_keys.size() << " keys moving " << morph_vertices.size() << " vertices, "
+                  << morph_deltas.size() << " deltas (" << morph_deltas.size() * sizeof(Morph_Delta) + morph_vertices.size() * sizeof(Morph_Vertex)
+                  << " bytes, dense " << dense_morph_bytes << " bytes), drawn with the float vertex layout" << std::endl;
+    }
+}
+
+// Replaces the placeholders with whatever the workers finished since the last frame. Everything
+// in flight may still read the old buffers and image, so the device is drained first.
+auto Hello_Triangle_Application::swap_in_loaded_assets() -> void
+{
+    auto loaded_model = asset_loader.take_model();
+    auto loaded_texture = asset_loader.take_texture();
+    if (!loaded_model && !loaded_texture) return;
+
+    vkDeviceWaitIdle(logical_device);
+
+    if (loaded_model) {
+        destroy_model_buffers();
+        install_model(std::move(*loaded_model));
+        create_vertex_buffer();
+        create_index_buffer();
+        create_vertex_animation_resources();
+        create_material_descriptor_sets();
+        start_texture_ingest();
+    }
+
+    if (loaded_texture) {
+        destroy_texture();
+        // Only the tail of a mip chain for now, stream_textures() adds finer levels as they are wanted.
+        texture_source = std::move(*loaded_texture);
+        texture_first_level = 0;
+        if (texture_source.levels.size() > 1) {
+            texture_residency_handle = texture_residency.add(texture_source);
+            texture_first_level = texture_residency.first_level(*texture_residency_handle);
+        }
+        create_texture_image(texture_source, texture_first_level);
+        create_texture_image_view();
+        create_texture_sampler();
+        update_texture_descriptors();
+    }
+
+    if (!asset_loader.pending()) {
+        auto ms = std::chrono::duration<double, std::milli>(Asset_Loader::Clock::now() - startup_time).count();
+        std::cout << "Startup: assets swapped in after " << ms << " ms" << std::endl;
+    }
+}
+
+auto Hello_Triangle_Application::create_staging_ring() -> void
+{
+    staging_ring.resize(STAGING_SLOT_COUNT);
+    for (auto& slot: staging_ring) {
+        create_buffer(
+            STAGING_SLOT_SIZE,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &slot.buffer,
+            &slot.memory
+        );
+        vkMapMemory(logical_device, slot.memory, 0, STAGING_SLOT_SIZE, 0, &slot.mapped);
+
+        auto command_buffer_allocate_info = VkCommandBufferAllocateInfo{};
+        command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        command_buffer_allocate_info.commandPool = command_pool;
+        command_buffer_allocate_info.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(logical_device, &command_buffer_allocate_info, &slot.command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate staging command buffer!");
+        }
+
+        auto fence_create_info = VkFenceCreateInfo{};
+        fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(logical_device, &fence_create_info, nullptr, &slot.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create staging fence!");
+        }
+    }
+}
+
+auto Hello_Triangle_Application::destroy_staging_ring() -> void
+{
+    for (auto const& slot: staging_ring) {
+        vkDestroyFence(logical_device, slot.fence, nullptr);
+        vkFreeCommandBuffers(logical_device, command_pool, 1, &slot.command_buffer);
+        vkDestroyBuffer(logical_device, slot.buffer, nullptr);
+        vkFreeMemory(logical_device, slot.memory, nullptr);
+    }
+    staging_ring.clear();
+}
+
+// Copies size bytes into the next staging slot, or into a buffer of their own when they do not
+// fit, and submits what record() records to upload them from that buffer at offset 0. Nothing is
+// waited for but the slot's previous upload; a buffer of its own is retired right away.
+auto Hello_Triangle_Application::submit_staged_upload(unsigned char const* bytes, VkDeviceSize size, std::function<void(VkCommandBuffer, VkBuffer)> const& record) -> void
+{
+    auto& slot = staging_ring[staging_ring_next];
+    staging_ring_next = (staging_ring_next + 1) % staging_ring.size();
+    if (slot.busy) {
+        vkWaitForFences(logical_device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+        slot.busy = false;
+    }
+    vkResetFences(logical_device, 1, &slot.fence);
+
+    auto buffer = slot.buffer;
+    if (size > STAGING_SLOT_SIZE) {
+        auto own = Retired_Resources{};
+        create_buffer(
+            size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &own.buffer,
+            &own.buffer_memory
+        );
+
+        auto data = (void*) nullptr;
+        vkMapMemory(logical_device, own.buffer_memory, 0, size, 0, &data);
+        memcpy(data, bytes, static_cast<size_t>(size));
+        vkUnmapMemory(logical_device, own.buffer_memory);
+        buffer = own.buffer;
+        retire(own);
+    } else if (size > 0) {
+        memcpy(slot.mapped, bytes, static_cast<size_t>(size));
+    }
+
+    vkResetCommandBuffer(slot.command_buffer, 0);
+    auto command_buffer_begin_info = VkCommandBufferBeginInfo{};
+    command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(slot.command_buffer, &command_buffer_begin_info);
+    record(slot.command_buffer, buffer);
+    vkEndCommandBuffer(slot.command_buffer);
+
+    auto submit_info = VkSubmitInfo{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &slot.command_buffer;
+    if (vkQueueSubmit(graphics_queue, 1, &submit_info, slot.fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit texture upload!");
+    }
+    slot.busy = true;
+}
+
+auto Hello_Triangle_Application::retire(Retired_Resources resources) -> void
+{
+    resources.frame = submitted_frames;
+    retired_resources.emplace_back(resources);
+}
+
+// Destroys what the frames in flight can no longer use: whatever was retired before a frame that
+// has finished since, or everything when the device is idle. Uploads are submitted to the same
+// queue as the frames, so a finished frame also means the uploads before it are done.
+auto Hello_Triangle_Application::destroy_retired_resources(bool all) -> void
+{
+    auto kept = std::vector<Retired_Resources>{};
+    for (auto const& resources: retired_resources) {
+        if (!all && resources.frame + MAX_FRAMES_IN_FLIGHT > submitted_frames) {
+            kept.emplace_back(resources);
+            continue;
+        }
+        vkDestroyImageView(logical_device, resources.view, nullptr);
+        vkDestroyImage(logical_device, resources.image, nullptr);
+        vkFreeMemory(logical_device, resources.image_memory, nullptr);
+        vkDestroyBuffer(logical_device, resources.buffer, nullptr);
+        vkFreeMemory(logical_device, resources.buffer_memory, nullptr);
+    }
+    retired_resources = std::move(kept);
+}
+
+// Loads the texture files the model's materials sample, once however many of its texture paths
+// lead to one; the others would take memory and residency budget without ever being drawn. By
+// default the workers decode and cook them within TEXTURE_INGEST_BUDGET while
+// update_texture_ingest() uploads the finished ones through the staging ring each frame. The
+// serial baseline does one texture after the other right here.
+auto Hello_Triangle_Application::start_texture_ingest() -> void
+{
+    model_texture_files.assign(model.textures.size(), std::numeric_limits<size_t>::max());
+    texture_ingest_bytes = 0;
+    texture_ingest_start = Asset_Loader::Clock::now();
+
+    auto sampled = std::vector<bool>(model.textures.size(), false);
+    for (auto material = (size_t) 0; material < model.materials.size(); material++) {
+        auto index = material_texture_index(static_cast<int32_t>(material));
+        if (index < sampled.size()) sampled[index] = true;
+    }
+
+    auto archive = asset_archive ? &*asset_archive : nullptr;
+    auto paths = std::vector<std::string>{};
+    for (auto i = (size_t) 0; i < model.textures.size(); i++) {
+        if (!sampled[i]) continue;
+        auto path = resolve_texture_path(asset_dir + model_file, model.textures[i], archive);
+        if (path.empty()) {
+            std::cout << "Texture " << model.textures[i] << " of " << model_file << " not found" << std::endl;
+            continue;
+        }
+        auto file = std::find(paths.begin(), paths.end(), path);
+        model_texture_files[i] = static_cast<size_t>(file - paths.begin());
+        if (file == paths.end()) paths.emplace_back(std::move(path));
+    }
+    model_textures.assign(paths.size(), Model_Texture{});
+    if (paths.empty()) return;
+
+    auto texture_options = Texture_Load_Options{};
+    texture_options.cache_dir = cache_dir;
+    texture_options.archive = archive;
+    texture_options.cook.compress = texture_compression_bc;
+
+    if (serial_texture_ingest) {
+        for (auto i = (size_t) 0; i < paths.size(); i++) {
+            auto texture = std::optional<Cooked_Texture>{};
+            try {
+                texture = load_texture(paths[i], texture_options);
+            } catch (std::exception const& e) {
+                std::cout << e.what() << std::endl;
+                continue;
+            }
+            upload_model_texture(i, std::move(*texture));
+            vkQueueWaitIdle(graphics_queue);
+        }
+        report_texture_ingest("serially");
+        return;
+    }
+
+    texture_options.cook.thread_pool = &worker_pool;
+    texture_ingest.emplace(worker_pool, std::move(paths), texture_options, TEXTURE_INGEST_BUDGET);
+}
+
+// Uploads whatever textures the workers finished, without waiting for the others.
+auto Hello_Triangle_Application::update_texture_ingest() -> void
+{
+    if (!texture_ingest) return;
+
+    while (auto loaded = texture_ingest->take()) {
+        if (loaded->texture) upload_model_texture(loaded->index, std::move(*loaded->texture));
+    }
+    if (!texture_ingest->done()) return;
+
+    // Done once the last upload finished on the GPU too.
+    for (auto const& slot: staging_ring) {
+        if (slot.busy && vkGetFenceStatus(logical_device, slot.fence) != VK_SUCCESS) return;
+    }
+    auto how = "in parallel, at most " + std::to_string(texture_ingest->peak_bytes_in_flight()) + " decoded bytes in flight,";
+    report_texture_ingest(how.c_str());
+    texture_ingest.reset();
+}
+
+auto Hello_Triangle_Application::report_texture_ingest(char const* how) -> void
+{
+    auto loaded = std::count_if(model_textures.begin(), model_textures.end(), [] (Model_Texture const& texture) { return texture.image != VK_NULL_HANDLE; });
+    auto ms = std::chrono::duration<double, std::milli>(Asset_Loader::Clock::now() - texture_ingest_start).count();
+    std::cout << "Model textures: " << loaded << " of " << model_textures.size() << " decoded and uploaded " << how << " in " << ms << " ms, "
+              << texture_ingest_bytes << " bytes" << std::endl;
+}
+
+// Creates the image of model_textures[index] with the tail of the texture's mip chain and submits
+// its upload through the staging ring; the texture is kept to stream finer levels from.
+auto Hello_Triangle_Application::upload_model_texture(size_t index, Cooked_Texture source) -> void
+{
+    auto& target = model_textures[index];
+    target.source = std::move(source);
+    auto const& texture = target.source;
+    target.residency = texture_residency.add(texture);
+    target.first_level = texture_residency.first_level(target.residency);
+
+    auto const& top = texture.levels[target.first_level];
+    auto format = texture_vk_format(texture.format);
+    auto mip_levels = static_cast<uint32_t>(texture.levels.size()) - target.first_level;
+    create_image(
+        top.width,
+        top.height,
+        mip_levels,
+        VK_SAMPLE_COUNT_1_BIT,
+        format,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &target.image,
+        &target.memory
+    );
+    target.view = create_image_view(target.image, format, VK_IMAGE_ASPECT_COLOR_BIT, mip_levels);
+    // Materials using it sample it from the next frame on: the upload is submitted before that frame.
+    update_texture_descriptors();
+
+    auto const& last = texture.levels.back();
+    auto size = (VkDeviceSize) (last.offset + last.size - top.offset);
+    texture_ingest_bytes += size;
+    submit_staged_upload(texture.data() + top.offset, size, [&] (VkCommandBuffer command_buffer, VkBuffer buffer) {
+        record_texture_upload(command_buffer, buffer, target.image, texture, target.first_level);
+    });
+}
+
+// The levels first_level and coarser of the texture from the buffer, which holds them from offset
+// 0, into the levels 0 and up of an image that ends up ready for the fragment shader.
+auto Hello_Triangle_Application::record_texture_upload(VkCommandBuffer command_buffer, VkBuffer buffer, VkImage image, Cooked_Texture const& texture, uint32_t first_level) -> void
+{
+    auto const& top = texture.levels[first_level];
+    auto mip_levels = static_cast<uint32_t>(texture.levels.size()) - first_level;
+
+    auto barrier = VkImageMemoryBarrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mip_levels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    auto regions = std::vector<VkBufferImageCopy>{};
+    for (auto i = first_level; i < texture.levels.size(); i++) {
+        auto const& level = texture.levels[i];
+        auto region = VkBufferImageCopy{};
+        region.bufferOffset = level.offset - top.offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = i - first_level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {level.width, level.height, 1};
+        regions.emplace_back(region);
+    }
+    vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+// Requests levels for the textures that are sampled, from the screen sizes select_model_lods()
+// estimated, and makes the images match what texture_residency decides. A texture changes by
+// replacing its image with one holding the new levels; the frames in flight keep sampling the old
+// one, which is retired, and the next frame samples the new one. Starting the level count at the
+// resident level clamps sampling to it without a minLod per texture.
+auto Hello_Triangle_Application::stream_textures() -> void
 {
-    auto model_path = asset_dir + "viking_room.obj";
-    model = load_model(model_path);
-    auto& first_mesh = *model.meshes.begin();
-    auto& position = first_mesh.vertex_info.position;
-    auto& tex_coord = first_mesh.vertex_info.texcoord;
-    auto& color = first_mesh.vertex_info.color;
-    auto& indices = first_mesh.topology;
-    // for (auto& mesh: changli.meshes) {
-    //     for (auto& indice: mesh.topology) {
-    //         std::cout << "tri idx: " << indice.a << ", " << indice.b << ", " << indice.c << std::endl;
-    //     }
-    // }
-    for (auto triangle: indices) {
-        model_indices.emplace_back(triangle.a);
-        model_indices.emplace_back(triangle.b);
-        model_indices.emplace_back(triangle.c);
+    texture_stream_frame++;
+
+    // Ranges whose material has no texture of its own sample the texture, wrapped around the whole model.
+    auto fallback_pixels = 0.0f;
+    for (auto const& range: model_draw_ranges) {
+        auto texture = loaded_model_texture(material_texture_index(range.material));
+        if (!texture) {
+            fallback_pixels = std::max(fallback_pixels, range.pixels);
+            continue;
+        }
+        auto level = wanted_mip_level(texture->source.width, texture->source.height, static_cast<uint32_t>(texture->source.levels.size()), range.pixels);
+        texture_residency.request(texture->residency, level, texture_stream_frame);
+    }
+    if (texture_residency_handle && fallback_pixels > 0.0f) {
+        auto level = wanted_mip_level(texture_source.width, texture_source.height, static_cast<uint32_t>(texture_source.levels.size()), fallback_pixels);
+        texture_residency.request(*texture_residency_handle, level, texture_stream_frame);
     }
 
-    for (auto i = (size_t) 0; i < position.size(); i++) {
-        auto vertex = Vertex{};
-        vertex.position = position[i];
-        vertex.tex_coord = tex_coord[i];
-        model_vertices.emplace_back(vertex);
+    auto changes = texture_residency.update(texture_stream_frame, TEXTURE_STREAM_UPLOADS_PER_FRAME);
+    for (auto const& change: changes) {
+        if (texture_residency_handle && change.texture == *texture_residency_handle) {
+            if (change.first_level == texture_first_level) continue;
+            auto old = Retired_Resources{};
+            old.view = texture_image_view;
+            replace_texture_levels(texture_source, texture_first_level, change.first_level, &texture_image, &texture_image_memory);
+            retire(old);
+            texture_first_level = change.first_level;
+            texture_mip_levels = static_cast<uint32_t>(texture_source.levels.size()) - texture_first_level;
+            create_texture_image_view();
+            update_texture_descriptors();
+            continue;
+        }
+
+        for (auto& texture: model_textures) {
+            if (texture.image == VK_NULL_HANDLE || texture.residency != change.texture || texture.first_level == change.first_level) continue;
+            auto old = Retired_Resources{};
+            old.view = texture.view;
+            replace_texture_levels(texture.source, texture.first_level, change.first_level, &texture.image, &texture.memory);
+            retire(old);
+            texture.first_level = change.first_level;
+            auto mip_levels = static_cast<uint32_t>(texture.source.levels.size()) - texture.first_level;
+            texture.view = create_image_view(texture.image, texture_vk_format(texture.source.format), VK_IMAGE_ASPECT_COLOR_BIT, mip_levels);
+            update_texture_descriptors();
+        }
     }
 }
 
+// Replaces *image with an image of the levels first_level and coarser of source, as its levels 0
+// and up. The levels the old image holds, old_first_level and coarser, are copied over on the GPU
+// and only the finer ones are uploaded from source, through the staging ring; everything is when
+// *image is null. Nothing is waited for: the old image is retired, its views are the caller's to
+// retire, and it is left in the transfer source layout since nothing samples it anymore.
+auto Hello_Triangle_Application::replace_texture_levels(Cooked_Texture const& source, uint32_t old_first_level, uint32_t first_level, VkImage* image, VkDeviceMemory* image_memory) -> void
+{
+    auto level_count = static_cast<uint32_t>(source.levels.size());
+    auto format = texture_vk_format(source.format);
+    auto const& top = source.levels[first_level];
+    auto const& last = source.levels.back();
+
+    auto kept = *image == VK_NULL_HANDLE ? level_count : std::max(first_level, old_first_level);
+    auto upload_end = kept < level_count ? source.levels[kept].offset : last.offset + last.size;
+    auto upload_size = (VkDeviceSize) (upload_end - top.offset);
+
+    auto new_image = VkImage{};
+    auto new_image_memory = VkDeviceMemory{};
+    create_image(
+        top.width,
+        top.height,
+        level_count - first_level,
+        VK_SAMPLE_COUNT_1_BIT,
+        format,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &new_image,
+        &new_image_memory
+    );
+
+    auto image_barrier = [] (VkImage barrier_image, uint32_t base_level, uint32_t levels, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access) {
+        auto barrier = VkImageMemoryBarrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = old_layout;
+        barrier.newLayout = new_layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = barrier_image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, base_level, levels, 0, 1};
+        barrier.srcAccessMask = src_access;
+        barrier.dstAccessMask = dst_access;
+        return barrier;
+    };
+
+    // The frames submitted before still sample the old image; the barrier waits for their
+    // fragment shaders, which run earlier on the same queue.
+    submit_staged_upload(source.data() + top.offset, upload_size, [&] (VkCommandBuffer command_buffer, VkBuffer staging_buffer) {
+        auto barriers = std::vector<VkImageMemoryBarrier>{};
+        barriers.emplace_back(image_barrier(new_image, 0, level_count - first_level, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+        if (kept < level_count) {
+            barriers.emplace_back(image_barrier(*image, kept - old_first_level, level_count - kept, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+        }
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+        if (upload_size > 0) {
+            auto regions = std::vector<VkBufferImageCopy>{};
+            for (auto i = first_level; i < kept; i++) {
+                auto const& level = source.levels[i];
+                auto region = VkBufferImageCopy{};
+                region.bufferOffset = level.offset - top.offset;
+                region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i - first_level, 0, 1};
+                region.imageOffset = {0, 0, 0};
+                region.imageExtent = {level.width, level.height, 1};
+                regions.emplace_back(region);
+            }
+            vkCmdCopyBufferToImage(command_buffer, staging_buffer, new_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+        }
+
+        if (kept < level_count) {
+            auto copies = std::vector<VkImageCopy>{};
+            for (auto i = kept; i < level_count; i++) {
+                auto const& level = source.levels[i];
+                auto copy = VkImageCopy{};
+                copy.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i - old_first_level, 0, 1};
+                copy.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i - first_level, 0, 1};
+                copy.extent = {level.width, level.height, 1};
+                copies.emplace_back(copy);
+            }
+            vkCmdCopyImage(command_buffer, *image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, new_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copies.size()), copies.data());
+        }
+
+        auto ready = image_barrier(new_image, 0, level_count - first_level, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &ready);
+    });
+
+    auto old = Retired_Resources{};
+    old.image = *image;
+    old.image_memory = *image_memory;
+    retire(old);
+    *image = new_image;
+    *image_memory = new_image_memory;
+}
+
 auto Hello_Triangle_Application::main_loop() -> void
 {
     while(!glfwWindowShouldClose(window)) {
         draw_frame();
         glfwPollEvents();
+        swap_in_loaded_assets();
+        update_texture_ingest();
+        stream_textures();
 
         auto current_time = glfwGetTime();
         last_frame_time = (current_time - last_time) * 1000.0f;
         last_time = current_time;
+
+        auto toggle_pressed = glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS;
+        if (toggle_pressed && !vertex_toggle_held) {
+            use_packed_vertices = !use_packed_vertices;
+            frame_report_start = current_time;
+            frame_report_count = 0;
+            frame_draw_count = 0;
+            frame_bind_count = 0;
+        }
+        vertex_toggle_held = toggle_pressed;
+
+        auto depth_prepass_pressed = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+        if (depth_prepass_pressed && !depth_prepass_toggle_held) {
+            use_depth_prepass = !use_depth_prepass;
+            frame_report_start = current_time;
+            frame_report_count = 0;
+            frame_draw_count = 0;
+            frame_bind_count = 0;
+        }
+        depth_prepass_toggle_held = depth_prepass_pressed;
+
+        auto morph_pressed = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+        if (morph_pressed && !morph_toggle_held) animate_morph_weights = !animate_morph_weights;
+        morph_toggle_held = morph_pressed;
+
+        frame_report_count++;
+        if (current_time - frame_report_start >= frame_report_interval) {
+            std::cout << "Frame time: " << (current_time - frame_report_start) * 1000.0 / double(frame_report_count) << " ms ("
+                      << (use_packed_vertices ? "packed" : "float") << " vertices" << (use_depth_prepass ? ", depth prepass" : "") << "), "
+                      << double(frame_draw_count) / double(frame_report_count) << " draws, "
+                      << double(frame_bind_count) / double(frame_report_count) << " binds per frame" << std::endl;
+            if (skinning_report_ms > 0.0) {
+                std::cout << "Skinning: " << skinning_report_ms / double(frame_report_count) << " ms GPU per frame, "
+                          << double(skinning_report_vertices) / skinning_report_ms << " vertices per ms" << std::endl;
+            }
+            if (morph_report_ms > 0.0) {
+                std::cout << "Shape keys: " << morph_report_ms / double(frame_report_count) << " ms GPU per frame, "
+                          << double(morph_report_deltas) / double(frame_report_count) << " deltas of "
+                          << morph_vertices.size() << " moved vertices per frame" << std::endl;
+            }
+            std::cout << "Textures: " << texture_residency.resident_bytes() << " of " << texture_residency.budget() << " bytes in VRAM, "
+                      << texture_residency.uploaded_levels() << " levels streamed in, " << texture_residency.evicted_levels() << " evicted so far" << std::endl;
+            morph_report_ms = 0.0;
+            morph_report_deltas = 0;
+            skinning_report_ms = 0.0;
+            skinning_report_vertices = 0;
+            frame_report_start = current_time;
+            frame_report_count = 0;
+            frame_draw_count = 0;
+            frame_bind_count = 0;
+        }
     }
 
     vkDeviceWaitIdle(logical_device);
@@ -249,6 +1014,7 @@ auto Hello_Triangle_Application::clean_up() -> void
 
     vkDestroyDescriptorPool(logical_device, descriptor_pool, nullptr);
     vkDestroyDescriptorPool(logical_device, compute_descriptor_pool, nullptr);
+    vkDestroyDescriptorPool(logical_device, material_descriptor_pool, nullptr);
 
     for (auto i = (size_t) 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         vkDestroyBuffer(logical_device, uniform_buffers[i], nullptr);
@@ -260,17 +1026,12 @@ auto Hello_Triangle_Application::clean_up() -> void
         vkFreeMemory(logical_device, shader_storage_buffers_memory[i], nullptr);
     }
 
-    vkFreeMemory(logical_device, index_buffer_memory, nullptr);
-    vkDestroyBuffer(logical_device, index_buffer, nullptr);
-
-    vkFreeMemory(logical_device, vertex_buffer_memory, nullptr);
-    vkDestroyBuffer(logical_device, vertex_buffer, nullptr);
+    destroy_model_buffers();
 
-    vkDestroySampler(logical_device, texture_sampler, nullptr);
+    destroy_texture();
 
-    vkDestroyImageView(logical_device, texture_image_view, nullptr);
-    vkDestroyImage(logical_device, texture_image, nullptr);
-    vkFreeMemory(logical_device, texture_image_memory, nullptr);
+    destroy_retired_resources(true);
+    destroy_staging_ring();
 
     vkDestroyImageView(logical_device, color_image_view, nullptr);
     vkDestroyImage(logical_device, color_image, nullptr);
@@ -287,15 +1048,30 @@ auto Hello_Triangle_Application::clean_up() -> void
     vkDestroyCommandPool(logical_device, command_pool, nullptr);
 
     vkDestroyPipeline(logical_device, graphics_pipeline, nullptr);
+    vkDestroyPipeline(logical_device, packed_graphics_pipeline, nullptr);
+    vkDestroyPipeline(logical_device, depth_prepass_pipeline, nullptr);
+    vkDestroyPipeline(logical_device, packed_depth_prepass_pipeline, nullptr);
     vkDestroyPipeline(logical_device, graphics_pipeline2, nullptr);
     vkDestroyPipeline(logical_device, compute_pipeline, nullptr);
+    vkDestroyPipeline(logical_device, skinning_pipeline, nullptr);
+    vkDestroyPipeline(logical_device, morph_pipeline, nullptr);
+    vkDestroyPipeline(logical_device, mip_generation_pipeline, nullptr);
 
     vkDestroyPipelineLayout(logical_device, pipeline_layout, nullptr);
     vkDestroyPipelineLayout(logical_device, pipeline_layout2, nullptr);
     vkDestroyPipelineLayout(logical_device, compute_pipeline_layout, nullptr);
+    vkDestroyPipelineLayout(logical_device, skinning_pipeline_layout, nullptr);
+    vkDestroyPipelineLayout(logical_device, morph_pipeline_layout, nullptr);
+    vkDestroyPipelineLayout(logical_device, mip_generation_pipeline_layout, nullptr);
 
     vkDestroyDescriptorSetLayout(logical_device, descriptor_set_layout, nullptr);
+    vkDestroyDescriptorSetLayout(logical_device, material_descriptor_set_layout, nullptr);
     vkDestroyDescriptorSetLayout(logical_device, compute_descriptor_set_layout, nullptr);
+    vkDestroyDescriptorSetLayout(logical_device, skinning_descriptor_set_layout, nullptr);
+    vkDestroyDescriptorSetLayout(logical_device, morph_descriptor_set_layout, nullptr);
+    vkDestroyDescriptorSetLayout(logical_device, mip_generation_descriptor_set_layout, nullptr);
+    vkDestroyDescriptorPool(logical_device, mip_generation_descriptor_pool, nullptr);
+    vkDestroyQueryPool(logical_device, mip_generation_query_pool, nullptr);
 
     vkDestroyRenderPass(logical_device, render_pass, nullptr);
 
@@ -320,6 +1096,68 @@ auto Hello_Triangle_Application::clean_up() -> void
     glfwTerminate();
 }
 
+auto Hello_Triangle_Application::destroy_model_buffers() -> void
+{
+    texture_ingest.reset();
+    for (auto const& texture: model_textures) {
+        if (texture.image == VK_NULL_HANDLE) continue;
+        texture_residency.remove(texture.residency);
+        vkDestroyImageView(logical_device, texture.view, nullptr);
+        vkDestroyImage(logical_device, texture.image, nullptr);
+        vkFreeMemory(logical_device, texture.memory, nullptr);
+    }
+    model_textures.clear();
+    model_texture_files.clear();
+
+    vkFreeMemory(logical_device, index_buffer_memory, nullptr);
+    vkDestroyBuffer(logical_device, index_buffer, nullptr);
+
+    vkFreeMemory(logical_device, position_buffer_memory, nullptr);
+    vkDestroyBuffer(logical_device, position_buffer, nullptr);
+    vkFreeMemory(logical_device, attribute_buffer_memory, nullptr);
+    vkDestroyBuffer(logical_device, attribute_buffer, nullptr);
+
+    vkFreeMemory(logical_device, packed_position_buffer_memory, nullptr);
+    vkDestroyBuffer(logical_device, packed_position_buffer, nullptr);
+    vkFreeMemory(logical_device, packed_attribute_buffer_memory, nullptr);
+    vkDestroyBuffer(logical_device, packed_attribute_buffer, nullptr);
+
+    if (animated()) {
+        vkDestroyDescriptorPool(logical_device, animation_descriptor_pool, nullptr);
+        vkDestroyQueryPool(logical_device, animation_query_pool, nullptr);
+        if (!skin_vertices.empty()) {
+            vkFreeMemory(logical_device, skin_vertex_buffer_memory, nullptr);
+            vkDestroyBuffer(logical_device, skin_vertex_buffer, nullptr);
+        }
+        if (!morph_vertices.empty()) {
+            vkFreeMemory(logical_device, morph_vertex_buffer_memory, nullptr);
+            vkDestroyBuffer(logical_device, morph_vertex_buffer, nullptr);
+            vkFreeMemory(logical_device, morph_delta_buffer_memory, nullptr);
+            vkDestroyBuffer(logical_device, morph_delta_buffer, nullptr);
+        }
+        for (auto i = (size_t) 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            vkDestroyBuffer(logical_device, bone_matrix_buffers[i], nullptr);
+            vkFreeMemory(logical_device, bone_matrix_buffers_memory[i], nullptr);
+            vkDestroyBuffer(logical_device, animated_position_buffers[i], nullptr);
+            vkFreeMemory(logical_device, animated_position_buffers_memory[i], nullptr);
+            vkDestroyBuffer(logical_device, morphed_position_buffers[i], nullptr);
+            vkFreeMemory(logical_device, morphed_position_buffers_memory[i], nullptr);
+        }
+    }
+}
+
+auto Hello_Triangle_Application::destroy_texture() -> void
+{
+    if (texture_residency_handle) texture_residency.remove(*texture_residency_handle);
+    texture_residency_handle.reset();
+
+    vkDestroySampler(logical_device, texture_sampler, nullptr);
+
+    vkDestroyImageView(logical_device, texture_image_view, nullptr);
+    vkDestroyImage(logical_device, texture_image, nullptr);
+    vkFreeMemory(logical_device, texture_image_memory, nullptr);
+}
+
 auto Hello_Triangle_Application::create_instance() -> void
 {
     if (enable_validation_layers && !check_validation_layers_support()) {
@@ -410,6 +1248,7 @@ auto Hello_Triangle_Application::create_logical_device() -> void
 
     auto device_features = VkPhysicalDeviceFeatures{};
     device_features.samplerAnisotropy = VK_TRUE;
+    device_features.textureCompressionBC = texture_compression_bc ? VK_TRUE : VK_FALSE;
     auto create_info = VkDeviceCreateInfo{};
     create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
@@ -434,6 +1273,22 @@ auto Hello_Triangle_Application::create_logical_device() -> void
     vkGetDeviceQueue(logical_device, indices.present_family.value(), 0, &present_queue);
 }
 
+// Vertex animation and mip generation both run on the graphics queue and time themselves with
+// timestamps when it can write them.
+auto Hello_Triangle_Application::query_timestamp_support() -> void
+{
+    auto properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    auto queue_family_count = (uint32_t) 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+    auto queue_families = std::vector<VkQueueFamilyProperties>{queue_family_count};
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+
+    auto queue_family = find_queue_families(physical_device).graphics_family.value();
+    timestamps_supported = queue_families[queue_family].timestampValidBits != 0;
+    timestamp_period = properties.limits.timestampPeriod;
+}
+
 auto Hello_Triangle_Application::create_swap_chain() -> void
 {
     auto swap_chain_support = query_swap_chain_support(physical_device);
@@ -584,23 +1439,28 @@ auto Hello_Triangle_Application::create_descriptor_set_layout() -> void
     ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     ubo_layout_binding.pImmutableSamplers = nullptr;
 
+    auto descriptor_set_layout_create_info = VkDescriptorSetLayoutCreateInfo{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = 1;
+    descriptor_set_layout_create_info.pBindings = &ubo_layout_binding;
+
+    auto result = vkCreateDescriptorSetLayout(logical_device, &descriptor_set_layout_create_info, nullptr, &descriptor_set_layout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout");
+    }
+
+    // Set 1 is bound once per material group: the material's texture.
     auto sampler_layout_binding = VkDescriptorSetLayoutBinding{};
-    sampler_layout_binding.binding = 1;
+    sampler_layout_binding.binding = 0;
     sampler_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     sampler_layout_binding.descriptorCount = 1;
     sampler_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
     sampler_layout_binding.pImmutableSamplers = nullptr;
 
-    auto bindings = std::array<VkDescriptorSetLayoutBinding, 2>{ubo_layout_binding, sampler_layout_binding};
-
-    auto descriptor_set_layout_create_info = VkDescriptorSetLayoutCreateInfo{};
-    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(bindings.size());
-    descriptor_set_layout_create_info.pBindings = bindings.data();
-
-    auto result = vkCreateDescriptorSetLayout(logical_device, &descriptor_set_layout_create_info, nullptr, &descriptor_set_layout);
+    descriptor_set_layout_create_info.pBindings = &sampler_layout_binding;
+    result = vkCreateDescriptorSetLayout(logical_device, &descriptor_set_layout_create_info, nullptr, &material_descriptor_set_layout);
     if (result != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor set layout");
+        throw std::runtime_error("failed to create material descriptor set layout");
     }
 }
 
@@ -642,6 +1502,7 @@ auto Hello_Triangle_Application::create_graphics_pipeline() -> void
 {
     auto vert_shader_module = create_shader_module(TRIANGLE_VERT);
     auto frag_shader_module = create_shader_module(TRIANGLE_FRAG);
+    auto packed_vert_shader_module = create_shader_module(TRIANGLE_PACKED_VERT);
 
     auto vert_shader_stage_info = VkPipelineShaderStageCreateInfo{};
     vert_shader_stage_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -682,13 +1543,13 @@ auto Hello_Triangle_Application::create_graphics_pipeline() -> void
     viewport_state_create_info.scissorCount = 1;
     viewport_state_create_info.pScissors = &scissor;
 
-    auto binding_description = Vertex::get_binding_description();
-    auto attribute_descriptions = Vertex::get_attribute_descriptions();
+    auto binding_descriptions = Vertex_Attributes::get_binding_descriptions();
+    auto attribute_descriptions = Vertex_Attributes::get_attribute_descriptions();
 
     auto vertex_input_info = VkPipelineVertexInputStateCreateInfo{};
     vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertex_input_info.vertexBindingDescriptionCount = 1;
-    vertex_input_info.pVertexBindingDescriptions = &binding_description;
+    vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(binding_descriptions.size());
+    vertex_input_info.pVertexBindingDescriptions = binding_descriptions.data();
     vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
     vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
 
@@ -744,7 +1605,7 @@ auto Hello_Triangle_Application::create_graphics_pipeline() -> void
     depth_stencil_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
     depth_stencil_state_create_info.depthTestEnable = VK_TRUE;
     depth_stencil_state_create_info.depthWriteEnable = VK_TRUE;
-    depth_stencil_state_create_info.depthCompareOp = VK_COMPARE_OP_LESS;
+    depth_stencil_state_create_info.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;     // passes again where the depth prepass already wrote
     depth_stencil_state_create_info.depthBoundsTestEnable = VK_FALSE;
     depth_stencil_state_create_info.minDepthBounds = 0.0f;
     depth_stencil_state_create_info.maxDepthBounds = 1.0f;
@@ -754,10 +1615,16 @@ auto Hello_Triangle_Application::create_graphics_pipeline() -> void
 
     auto pipeline_layout_create_info = VkPipelineLayoutCreateInfo{};
     pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipeline_layout_create_info.setLayoutCount = 1;
-    pipeline_layout_create_info.pSetLayouts = &descriptor_set_layout;
-    pipeline_layout_create_info.pushConstantRangeCount = 0;
-    pipeline_layout_create_info.pPushConstantRanges = nullptr;
+    auto set_layouts = std::array<VkDescriptorSetLayout, 2>{descriptor_set_layout, material_descriptor_set_layout};
+    pipeline_layout_create_info.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
+    pipeline_layout_create_info.pSetLayouts = set_layouts.data();
+    auto push_constant_range = VkPushConstantRange{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(Draw_Constants);
+
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
 
     auto layout_result = vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &pipeline_layout);
     if (layout_result != VK_SUCCESS) {
@@ -787,8 +1654,50 @@ auto Hello_Triangle_Application::create_graphics_pipeline() -> void
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
+    // Same state with the packed vertex layout, it only differs in the vertex stage.
+    auto packed_binding_descriptions = Packed_Vertex_Attributes::get_binding_descriptions();
+    auto packed_attribute_descriptions = Packed_Vertex_Attributes::get_attribute_descriptions();
+    vertex_input_info.pVertexBindingDescriptions = packed_binding_descriptions.data();
+    vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(packed_attribute_descriptions.size());
+    vertex_input_info.pVertexAttributeDescriptions = packed_attribute_descriptions.data();
+    shader_stages[0].module = packed_vert_shader_module;
+
+    auto packed_pipeline_result = vkCreateGraphicsPipelines(logical_device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &packed_graphics_pipeline);
+    if (packed_pipeline_result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create packed graphics pipeline!");
+    }
+
+    // Depth prepass for both layouts: the position stream alone, no fragment stage and no color writes.
+    auto depth_vert_shader_module = create_shader_module(DEPTH_VERT);
+    auto packed_depth_vert_shader_module = create_shader_module(DEPTH_PACKED_VERT);
+    color_blend_attachment.colorWriteMask = 0;
+    pipeline_create_info.stageCount = 1;
+    vertex_input_info.vertexBindingDescriptionCount = 1;
+    vertex_input_info.vertexAttributeDescriptionCount = 1;
+
+    vertex_input_info.pVertexBindingDescriptions = binding_descriptions.data();
+    vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
+    shader_stages[0].module = depth_vert_shader_module;
+
+    auto depth_pipeline_result = vkCreateGraphicsPipelines(logical_device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &depth_prepass_pipeline);
+    if (depth_pipeline_result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth prepass pipeline!");
+    }
+
+    vertex_input_info.pVertexBindingDescriptions = packed_binding_descriptions.data();
+    vertex_input_info.pVertexAttributeDescriptions = packed_attribute_descriptions.data();
+    shader_stages[0].module = packed_depth_vert_shader_module;
+
+    auto packed_depth_pipeline_result = vkCreateGraphicsPipelines(logical_device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &packed_depth_prepass_pipeline);
+    if (packed_depth_pipeline_result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create packed depth prepass pipeline!");
+    }
+
     vkDestroyShaderModule(logical_device, vert_shader_module, nullptr);
     vkDestroyShaderModule(logical_device, frag_shader_module, nullptr);
+    vkDestroyShaderModule(logical_device, packed_vert_shader_module, nullptr);
+    vkDestroyShaderModule(logical_device, depth_vert_shader_module, nullptr);
+    vkDestroyShaderModule(logical_device, packed_depth_vert_shader_module, nullptr);
 }
 
 auto Hello_Triangle_Application::create_graphics_pipeline2() -> void
@@ -957,18 +1866,225 @@ auto Hello_Triangle_Application::create_compute_pipeline() -> void
     vkDestroyShaderModule(logical_device, comp_shader_module, nullptr);
 }
 
-auto Hello_Triangle_Application::create_framebuffers() -> void
+auto Hello_Triangle_Application::create_skinning_pipeline() -> void
 {
-    swap_chain_framebuffers.resize(swap_chain_image_views.size());
+    auto bindings = std::array<VkDescriptorSetLayoutBinding, 4>{};
+    for (auto i = (size_t) 0; i < bindings.size(); i++) {
+        bindings[i].binding = static_cast<uint32_t>(i);
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[i].pImmutableSamplers = nullptr;
+    }
 
-    for (auto i = (size_t) 0; i < swap_chain_image_views.size(); i++) {
-        auto attachments = std::vector<VkImageView>{color_image_view, depth_image_view, swap_chain_image_views[i]};
+    auto descriptor_set_layout_create_info = VkDescriptorSetLayoutCreateInfo{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    descriptor_set_layout_create_info.pBindings = bindings.data();
 
-        auto framebuffer_create_info = VkFramebufferCreateInfo{};
-        framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebuffer_create_info.renderPass = render_pass;
-        framebuffer_create_info.attachmentCount = static_cast<uint32_t>(attachments.size());
-        framebuffer_create_info.pAttachments = attachments.data();
+    auto result = vkCreateDescriptorSetLayout(logical_device, &descriptor_set_layout_create_info, nullptr, &skinning_descriptor_set_layout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create skinning descriptor set layout!");
+    }
+
+    auto push_constant_range = VkPushConstantRange{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(Skinning_Constants);
+
+    auto pipeline_layout_create_info = VkPipelineLayoutCreateInfo{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &skinning_descriptor_set_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+    result = vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &skinning_pipeline_layout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create skinning pipeline layout!");
+    }
+
+    auto comp_shader_module = create_shader_module(SKINNING_COMP);
+
+    auto pipeline_create_info = VkComputePipelineCreateInfo{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_create_info.layout = skinning_pipeline_layout;
+    pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_create_info.stage.module = comp_shader_module;
+    pipeline_create_info.stage.pName = "main";
+
+    result = vkCreateComputePipelines(logical_device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &skinning_pipeline);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create skinning pipeline!");
+    }
+
+    vkDestroyShaderModule(logical_device, comp_shader_module, nullptr);
+}
+
+auto Hello_Triangle_Application::create_morph_pipeline() -> void
+{
+    auto bindings = std::array<VkDescriptorSetLayoutBinding, 4>{};
+    for (auto i = (size_t) 0; i < bindings.size(); i++) {
+        bindings[i].binding = static_cast<uint32_t>(i);
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[i].pImmutableSamplers = nullptr;
+    }
+
+    auto descriptor_set_layout_create_info = VkDescriptorSetLayoutCreateInfo{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    descriptor_set_layout_create_info.pBindings = bindings.data();
+
+    auto result = vkCreateDescriptorSetLayout(logical_device, &descriptor_set_layout_create_info, nullptr, &morph_descriptor_set_layout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create morph descriptor set layout!");
+    }
+
+    auto push_constant_range = VkPushConstantRange{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(Morph_Constants);
+
+    auto pipeline_layout_create_info = VkPipelineLayoutCreateInfo{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &morph_descriptor_set_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+    result = vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &morph_pipeline_layout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create morph pipeline layout!");
+    }
+
+    auto comp_shader_module = create_shader_module(MORPH_COMP);
+
+    auto pipeline_create_info = VkComputePipelineCreateInfo{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_create_info.layout = morph_pipeline_layout;
+    pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_create_info.stage.module = comp_shader_module;
+    pipeline_create_info.stage.pName = "main";
+
+    result = vkCreateComputePipelines(logical_device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &morph_pipeline);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create morph pipeline!");
+    }
+
+    vkDestroyShaderModule(logical_device, comp_shader_module, nullptr);
+}
+
+// The compute path of generate_mipmaps(), and the timestamps for both paths. mipgen.comp writes
+// RGBA8 UNORM storage images; on a device without them the blits are all there is.
+auto Hello_Triangle_Application::create_mip_generation_pipeline() -> void
+{
+    // Both paths are timed on the GPU when the queue supports timestamps.
+    if (timestamps_supported) {
+        auto query_pool_create_info = VkQueryPoolCreateInfo{};
+        query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_pool_create_info.queryCount = 2;
+
+        auto result = vkCreateQueryPool(logical_device, &query_pool_create_info, nullptr, &mip_generation_query_pool);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to create mip generation query pool!");
+        }
+    }
+
+    auto format_properties = VkFormatProperties{};
+    vkGetPhysicalDeviceFormatProperties(physical_device, VK_FORMAT_R8G8B8A8_UNORM, &format_properties);
+    if (!(format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)) {
+        std::cout << "Mip generation: RGBA8 storage images are not supported, mips will be blitted" << std::endl;
+        return;
+    }
+
+    auto bindings = std::array<VkDescriptorSetLayoutBinding, 2>{};
+    for (auto i = (size_t) 0; i < bindings.size(); i++) {
+        bindings[i].binding = static_cast<uint32_t>(i);
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[i].descriptorCount = i == 0 ? 1 : MIP_LEVELS_PER_DISPATCH;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[i].pImmutableSamplers = nullptr;
+    }
+
+    auto descriptor_set_layout_create_info = VkDescriptorSetLayoutCreateInfo{};
+    descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    descriptor_set_layout_create_info.pBindings = bindings.data();
+
+    auto result = vkCreateDescriptorSetLayout(logical_device, &descriptor_set_layout_create_info, nullptr, &mip_generation_descriptor_set_layout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mip generation descriptor set layout!");
+    }
+
+    auto push_constant_range = VkPushConstantRange{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(Mip_Generation_Constants);
+
+    auto pipeline_layout_create_info = VkPipelineLayoutCreateInfo{};
+    pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_create_info.setLayoutCount = 1;
+    pipeline_layout_create_info.pSetLayouts = &mip_generation_descriptor_set_layout;
+    pipeline_layout_create_info.pushConstantRangeCount = 1;
+    pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+    result = vkCreatePipelineLayout(logical_device, &pipeline_layout_create_info, nullptr, &mip_generation_pipeline_layout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mip generation pipeline layout!");
+    }
+
+    auto comp_shader_module = create_shader_module(MIPGEN_COMP);
+
+    auto pipeline_create_info = VkComputePipelineCreateInfo{};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_create_info.layout = mip_generation_pipeline_layout;
+    pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_create_info.stage.module = comp_shader_module;
+    pipeline_create_info.stage.pName = "main";
+
+    result = vkCreateComputePipelines(logical_device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &mip_generation_pipeline);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mip generation pipeline!");
+    }
+
+    vkDestroyShaderModule(logical_device, comp_shader_module, nullptr);
+
+    // Enough sets for the 32 levels a 32 bit extent can have.
+    auto const max_dispatches = (31 + MIP_LEVELS_PER_DISPATCH - 1) / MIP_LEVELS_PER_DISPATCH;
+    auto pool_size = VkDescriptorPoolSize{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    pool_size.descriptorCount = max_dispatches * (1 + MIP_LEVELS_PER_DISPATCH);
+
+    auto descriptor_pool_create_info = VkDescriptorPoolCreateInfo{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+    descriptor_pool_create_info.maxSets = max_dispatches;
+
+    result = vkCreateDescriptorPool(logical_device, &descriptor_pool_create_info, nullptr, &mip_generation_descriptor_pool);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mip generation descriptor pool!");
+    }
+}
+
+auto Hello_Triangle_Application::create_framebuffers() -> void
+{
+    swap_chain_framebuffers.resize(swap_chain_image_views.size());
+
+    for (auto i = (size_t) 0; i < swap_chain_image_views.size(); i++) {
+        auto attachments = std::vector<VkImageView>{color_image_view, depth_image_view, swap_chain_image_views[i]};
+
+        auto framebuffer_create_info = VkFramebufferCreateInfo{};
+        framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebuffer_create_info.renderPass = render_pass;
+        framebuffer_create_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebuffer_create_info.pAttachments = attachments.data();
         framebuffer_create_info.width = swap_chain_extent.width;
         framebuffer_create_info.height = swap_chain_extent.height;
         framebuffer_create_info.layers = 1;
@@ -1033,20 +2149,27 @@ auto Hello_Triangle_Application::create_depth_resources() -> void
     depth_image_view = create_image_view(depth_image, depth_format, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
 }
 
-auto Hello_Triangle_Application::create_texture_image() -> void
+// The levels first_level and coarser of the texture become texture_image's levels 0 and up.
+auto Hello_Triangle_Application::create_texture_image(Cooked_Texture const& texture, uint32_t first_level) -> void
 {
-    auto texture_width = 0;
-    auto texture_height = 0;
-    auto texture_channels = 0;
-    auto texture_path = asset_dir + "viking_room.png";
-    auto pixels = stbi_load(texture_path.c_str(), &texture_width, &texture_height, &texture_channels, STBI_rgb_alpha);
-    auto image_size = (VkDeviceSize) texture_width * texture_height * 4;
-    texture_mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(texture_width, texture_height)))) + 1;
-
-    if (!pixels) {
-        throw std::runtime_error("failed to load texture image!");
+    texture_format = texture_vk_format(texture.format);
+
+    // Cooked levels are copied as they are. A lone RGBA8 level, cooked without mips for
+    // --texture-mips compute or blit, gets its chain generated on the GPU.
+    auto runtime_mips = texture.levels.size() == 1 && texture.format == Texture_Format::rgba8 && (texture.width > 1 || texture.height > 1);
+    if (!runtime_mips) {
+        texture_mip_levels = static_cast<uint32_t>(texture.levels.size()) - first_level;
+        texture_image = VK_NULL_HANDLE;
+        texture_image_memory = VK_NULL_HANDLE;
+        replace_texture_levels(texture, first_level, first_level, &texture_image, &texture_image_memory);
+        return;
     }
 
+    auto texture_width = static_cast<int32_t>(texture.width);
+    auto texture_height = static_cast<int32_t>(texture.height);
+    auto image_size = (VkDeviceSize) texture.size();
+    texture_mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(texture_width, texture_height)))) + 1;
+
     auto staging_buffer = VkBuffer{};
     auto staging_buffer_memory = VkDeviceMemory{};
 
@@ -1060,17 +2183,15 @@ auto Hello_Triangle_Application::create_texture_image() -> void
 
     auto data = (void*) nullptr;
     vkMapMemory(logical_device, staging_buffer_memory, 0, image_size, 0, &data);
-    memcpy(data, pixels, static_cast<size_t>(image_size));
+    memcpy(data, texture.data(), static_cast<size_t>(image_size));
     vkUnmapMemory(logical_device, staging_buffer_memory);
 
-    stbi_image_free(pixels);
-
     create_image(
         texture_width,
         texture_height,
         texture_mip_levels,
         VK_SAMPLE_COUNT_1_BIT,
-        VK_FORMAT_R8G8B8A8_SRGB,
+        texture_format,
         VK_IMAGE_TILING_OPTIMAL,
         VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
@@ -1078,10 +2199,18 @@ auto Hello_Triangle_Application::create_texture_image() -> void
         &texture_image_memory
     );
 
-    transition_image_layout(texture_image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, texture_mip_levels);
-    copy_buffer_to_image(staging_buffer, texture_image, static_cast<uint32_t>(texture_width), static_cast<uint32_t>(texture_height));
-    //transition_image_layout(texture_image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, texture_mip_levels);
-    generate_mipmaps(texture_image, VK_FORMAT_R8G8B8A8_SRGB, texture_width, texture_height, texture_mip_levels);
+    auto region = VkBufferImageCopy{};
+    region.bufferOffset = texture.levels[0].offset;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {texture.width, texture.height, 1};
+
+    transition_image_layout(texture_image, texture_format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, texture_mip_levels);
+    copy_buffer_to_image(staging_buffer, texture_image, {region});
+    generate_mipmaps(texture_image, texture_format, texture_width, texture_height, texture_mip_levels);
 
     vkDestroyBuffer(logical_device, staging_buffer, nullptr);
     vkFreeMemory(logical_device, staging_buffer_memory, nullptr);
@@ -1089,7 +2218,7 @@ auto Hello_Triangle_Application::create_texture_image() -> void
 
 auto Hello_Triangle_Application::create_texture_image_view() -> void
 {
-    texture_image_view = create_image_view(texture_image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, texture_mip_levels);
+    texture_image_view = create_image_view(texture_image, texture_format, VK_IMAGE_ASPECT_COLOR_BIT, texture_mip_levels);
 }
 
 auto Hello_Triangle_Application::create_texture_sampler() -> void
@@ -1112,7 +2241,7 @@ auto Hello_Triangle_Application::create_texture_sampler() -> void
     sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
     sampler_create_info.mipLodBias = 0.0f;
     sampler_create_info.minLod = 0.0f;
-    sampler_create_info.maxLod = static_cast<float>(texture_mip_levels);
+    sampler_create_info.maxLod = VK_LOD_CLAMP_NONE;     // the material textures share it, each view limits its own levels
 
     auto result = vkCreateSampler(logical_device, &sampler_create_info, nullptr, &texture_sampler);
     if (result != VK_SUCCESS) {
@@ -1122,66 +2251,170 @@ auto Hello_Triangle_Application::create_texture_sampler() -> void
 
 auto Hello_Triangle_Application::create_vertex_buffer() -> void
 {
-    auto buffer_size = sizeof(model_vertices[0]) * model_vertices.size();
-
-    auto staging_buffer = VkBuffer{};
-    auto staging_buffer_memory = VkDeviceMemory{};
-    create_buffer(
-        buffer_size,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        &staging_buffer,
-        &staging_buffer_memory
-    );
-
-    auto data = (void*) nullptr;
-    vkMapMemory(logical_device, staging_buffer_memory, 0, buffer_size, 0, &data);
-    memcpy(data, model_vertices.data(), (size_t) buffer_size);
-    vkUnmapMemory(logical_device, staging_buffer_memory);
-
-    create_buffer(
-        buffer_size,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        &vertex_buffer,
-        &vertex_buffer_memory
-    );
-
-    copy_buffer(staging_buffer, vertex_buffer, buffer_size);
-    vkDestroyBuffer(logical_device, staging_buffer, nullptr);
-    vkFreeMemory(logical_device, staging_buffer_memory, nullptr);
+    auto position_buffer_size = sizeof(model_positions[0]) * model_positions.size();
+    create_device_local_buffer(model_positions.data(), position_buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &position_buffer, &position_buffer_memory);
+    auto attribute_buffer_size = sizeof(model_attributes[0]) * model_attributes.size();
+    create_device_local_buffer(model_attributes.data(), attribute_buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &attribute_buffer, &attribute_buffer_memory);
+
+    auto packed_position_buffer_size = sizeof(model_packed_positions[0]) * model_packed_positions.size();
+    create_device_local_buffer(model_packed_positions.data(), packed_position_buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &packed_position_buffer, &packed_position_buffer_memory);
+    auto packed_attribute_buffer_size = sizeof(model_packed_attributes[0]) * model_packed_attributes.size();
+    create_device_local_buffer(model_packed_attributes.data(), packed_attribute_buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &packed_attribute_buffer, &packed_attribute_buffer_memory);
 }
 
 auto Hello_Triangle_Application::create_index_buffer() -> void
 {
+    if (model_index_type == VK_INDEX_TYPE_UINT16) {
+        auto short_indices = std::vector<uint16_t>(model_indices.begin(), model_indices.end());
+        auto buffer_size = sizeof(short_indices[0]) * short_indices.size();
+        create_device_local_buffer(short_indices.data(), buffer_size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &index_buffer, &index_buffer_memory);
+        return;
+    }
+
     auto buffer_size = sizeof(model_indices[0]) * model_indices.size();
+    create_device_local_buffer(model_indices.data(), buffer_size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &index_buffer, &index_buffer_memory);
+}
 
-    auto staging_buffer = VkBuffer{};
-    auto staging_buffer_memory = VkDeviceMemory{};
-    create_buffer(
-        buffer_size,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        &staging_buffer,
-        &staging_buffer_memory
-    );
+auto Hello_Triangle_Application::create_vertex_animation_resources() -> void
+{
+    if (!animated()) return;
 
-    auto data = (void*) nullptr;
-    vkMapMemory(logical_device, staging_buffer_memory, 0, buffer_size, 0, &data);
-    memcpy(data, model_indices.data(), (size_t) buffer_size);
-    vkUnmapMemory(logical_device, staging_buffer_memory);
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "morph.comp and skinning.comp write positions as three floats");
 
-    create_buffer(
-        buffer_size,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        &index_buffer,
-        &index_buffer_memory
-    );
+    auto skinned = !skin_vertices.empty();
+    auto morphed = !morph_vertices.empty();
+    if (skinned) {
+        auto skin_buffer_size = sizeof(skin_vertices[0]) * skin_vertices.size();
+        create_device_local_buffer(skin_vertices.data(), skin_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &skin_vertex_buffer, &skin_vertex_buffer_memory);
+    }
+    if (morphed) {
+        auto morph_vertex_buffer_size = sizeof(morph_vertices[0]) * morph_vertices.size();
+        auto morph_delta_buffer_size = sizeof(morph_deltas[0]) * morph_deltas.size();
+        create_device_local_buffer(morph_vertices.data(), morph_vertex_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &morph_vertex_buffer, &morph_vertex_buffer_memory);
+        create_device_local_buffer(morph_deltas.data(), morph_delta_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &morph_delta_buffer, &morph_delta_buffer_memory);
+    }
 
-    copy_buffer(staging_buffer, index_buffer, buffer_size);
-    vkDestroyBuffer(logical_device, staging_buffer, nullptr);
-    vkFreeMemory(logical_device, staging_buffer_memory, nullptr);
+    // Every instance gets its own palette and output, only the first one is drawn. Positions no pass
+    // writes are uploaded once with the first instance and never touched again. The morphed positions
+    // exist even without shape keys, since skinning.comp always binds them.
+    auto bone_buffer_size = (VkDeviceSize) sizeof(glm::mat4) * std::max(skin_bone_count, 1u) * skinning_instance_count;
+    auto position_buffer_size = (VkDeviceSize) sizeof(model_positions[0]) * model_positions.size();
+    auto morphed_position_buffer_size = (VkDeviceSize) sizeof(glm::vec4) * std::max(morph_vertices.size(), (size_t) 1);
+    bone_matrix_buffers.resize(MAX_FRAMES_IN_FLIGHT);
+    bone_matrix_buffers_memory.resize(MAX_FRAMES_IN_FLIGHT);
+    bone_matrix_buffers_mapped.resize(MAX_FRAMES_IN_FLIGHT);
+    animated_position_buffers.resize(MAX_FRAMES_IN_FLIGHT);
+    animated_position_buffers_memory.resize(MAX_FRAMES_IN_FLIGHT);
+    morphed_position_buffers.resize(MAX_FRAMES_IN_FLIGHT);
+    morphed_position_buffers_memory.resize(MAX_FRAMES_IN_FLIGHT);
+    for (auto i = (size_t) 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        create_buffer(
+            bone_buffer_size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &bone_matrix_buffers[i],
+            &bone_matrix_buffers_memory[i]
+        );
+        vkMapMemory(logical_device, bone_matrix_buffers_memory[i], 0, bone_buffer_size, 0, &bone_matrix_buffers_mapped[i]);
+
+        create_device_local_buffer(
+            model_positions.data(),
+            position_buffer_size,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            &animated_position_buffers[i],
+            &animated_position_buffers_memory[i],
+            position_buffer_size * skinning_instance_count
+        );
+
+        create_buffer(
+            morphed_position_buffer_size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            &morphed_position_buffers[i],
+            &morphed_position_buffers_memory[i]
+        );
+    }
+
+    auto pool_size = VkDescriptorPoolSize{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_size.descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT * 8);
+
+    auto descriptor_pool_create_info = VkDescriptorPoolCreateInfo{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+    descriptor_pool_create_info.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT * 2);
+
+    auto result = vkCreateDescriptorPool(logical_device, &descriptor_pool_create_info, nullptr, &animation_descriptor_pool);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create vertex animation descriptor pool!");
+    }
+
+    auto allocate_descriptor_sets = [&](VkDescriptorSetLayout layout, std::vector<VkDescriptorSet>& descriptor_sets) {
+        auto layouts = std::vector<VkDescriptorSetLayout>{MAX_FRAMES_IN_FLIGHT, layout};
+        auto descriptor_set_allocate_info = VkDescriptorSetAllocateInfo{};
+        descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptor_set_allocate_info.descriptorPool = animation_descriptor_pool;
+        descriptor_set_allocate_info.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+        descriptor_set_allocate_info.pSetLayouts = layouts.data();
+
+        descriptor_sets.resize(MAX_FRAMES_IN_FLIGHT);
+        if (vkAllocateDescriptorSets(logical_device, &descriptor_set_allocate_info, descriptor_sets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate vertex animation descriptor sets!");
+        }
+    };
+
+    auto write_descriptor_sets = [&](VkDescriptorSet descriptor_set, std::array<VkBuffer, 4> const& buffers) {
+        auto buffer_infos = std::array<VkDescriptorBufferInfo, 4>{};
+        auto writes = std::array<VkWriteDescriptorSet, 4>{};
+        for (auto binding = (size_t) 0; binding < writes.size(); binding++) {
+            buffer_infos[binding].buffer = buffers[binding];
+            buffer_infos[binding].range = VK_WHOLE_SIZE;
+            writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[binding].dstSet = descriptor_set;
+            writes[binding].dstBinding = static_cast<uint32_t>(binding);
+            writes[binding].dstArrayElement = 0;
+            writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[binding].descriptorCount = 1;
+            writes[binding].pBufferInfo = &buffer_infos[binding];
+        }
+        vkUpdateDescriptorSets(logical_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    };
+
+    if (skinned) allocate_descriptor_sets(skinning_descriptor_set_layout, skinning_descriptor_sets);
+    if (morphed) allocate_descriptor_sets(morph_descriptor_set_layout, morph_descriptor_sets);
+    for (auto i = (size_t) 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        if (skinned) {
+            write_descriptor_sets(
+                skinning_descriptor_sets[i],
+                {skin_vertex_buffer, bone_matrix_buffers[i], animated_position_buffers[i], morphed_position_buffers[i]}
+            );
+        }
+        if (morphed) {
+            write_descriptor_sets(
+                morph_descriptor_sets[i],
+                {morph_vertex_buffer, morph_delta_buffer, morphed_position_buffers[i], animated_position_buffers[i]}
+            );
+        }
+    }
+
+    // The passes are timed on the GPU when the queue supports timestamps.
+    animation_queries_pending.assign(MAX_FRAMES_IN_FLIGHT, false);
+    animation_frame_deltas.assign(MAX_FRAMES_IN_FLIGHT, 0);
+    if (!timestamps_supported) {
+        std::cout << "Vertex animation: the compute queue has no timestamps, the passes will not be timed" << std::endl;
+        return;
+    }
+
+    auto query_pool_create_info = VkQueryPoolCreateInfo{};
+    query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    query_pool_create_info.queryCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT * 3);
+
+    result = vkCreateQueryPool(logical_device, &query_pool_create_info, nullptr, &animation_query_pool);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create vertex animation query pool!");
+    }
 }
 
 auto Hello_Triangle_Application::create_uniform_buffers() -> void
@@ -1257,16 +2490,14 @@ auto Hello_Triangle_Application::create_shader_storage_buffers() -> void
 
 auto Hello_Triangle_Application::create_descriptor_pool() -> void
 {
-    auto pool_sizes = std::array<VkDescriptorPoolSize, 2>{};
-    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    pool_sizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    pool_sizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+    auto pool_size = VkDescriptorPoolSize{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    pool_size.descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
 
     auto descriptor_pool_create_info = VkDescriptorPoolCreateInfo{};
     descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    descriptor_pool_create_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
-    descriptor_pool_create_info.pPoolSizes = pool_sizes.data();
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
     descriptor_pool_create_info.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
 
     auto result = vkCreateDescriptorPool(logical_device, &descriptor_pool_create_info, nullptr, &descriptor_pool);
@@ -1317,34 +2548,116 @@ auto Hello_Triangle_Application::create_descriptor_sets() -> void
         buffer_info.offset = 0;
         buffer_info.range = sizeof(Uniform_Buffer_Object);
 
-        auto image_info = VkDescriptorImageInfo{};
-        image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        image_info.imageView = texture_image_view;
-        image_info.sampler = texture_sampler;
+        auto write_descriptor_set = VkWriteDescriptorSet{};
+        write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write_descriptor_set.dstSet = descriptor_sets[i];
+        write_descriptor_set.dstBinding = 0;
+        write_descriptor_set.dstArrayElement = 0;
+        write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        write_descriptor_set.descriptorCount = 1;
+        write_descriptor_set.pBufferInfo = &buffer_info;
+        write_descriptor_set.pImageInfo = nullptr;
+        write_descriptor_set.pTexelBufferView = nullptr;
+
+        vkUpdateDescriptorSets(logical_device, 1, &write_descriptor_set, 0, nullptr);
+    }
 
-        auto write_descriptor_sets = std::array<VkWriteDescriptorSet, 2>{};
-        write_descriptor_sets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write_descriptor_sets[0].dstSet = descriptor_sets[i];
-        write_descriptor_sets[0].dstBinding = 0;
-        write_descriptor_sets[0].dstArrayElement = 0;
-        write_descriptor_sets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        write_descriptor_sets[0].descriptorCount = 1;
-        write_descriptor_sets[0].pBufferInfo = &buffer_info;
-        write_descriptor_sets[0].pImageInfo = nullptr;
-        write_descriptor_sets[0].pTexelBufferView = nullptr;
+    update_texture_descriptors();
+}
 
-        write_descriptor_sets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write_descriptor_sets[1].dstSet = descriptor_sets[i];
-        write_descriptor_sets[1].dstBinding = 1;
-        write_descriptor_sets[1].dstArrayElement = 0;
-        write_descriptor_sets[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        write_descriptor_sets[1].descriptorCount = 1;
-        write_descriptor_sets[1].pBufferInfo = nullptr;
-        write_descriptor_sets[1].pImageInfo = &image_info;
-        write_descriptor_sets[1].pTexelBufferView = nullptr;
+// The texture changed. Material sets may still be read by frames in flight, so each frame
+// rewrites its own before it records again, see update_material_descriptors().
+auto Hello_Triangle_Application::update_texture_descriptors() -> void
+{
+    material_descriptor_version++;
+}
 
-        vkUpdateDescriptorSets(logical_device, static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, nullptr);
+// One set per material and frame in flight, plus one for meshes without a material. Only called
+// while nothing is in flight, when the model changes.
+auto Hello_Triangle_Application::create_material_descriptor_sets() -> void
+{
+    vkDestroyDescriptorPool(logical_device, material_descriptor_pool, nullptr);
+
+    auto sets_per_frame = static_cast<uint32_t>(model.materials.size()) + 1;
+    auto set_count = sets_per_frame * static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+
+    auto pool_size = VkDescriptorPoolSize{};
+    pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_size.descriptorCount = set_count;
+
+    auto descriptor_pool_create_info = VkDescriptorPoolCreateInfo{};
+    descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptor_pool_create_info.poolSizeCount = 1;
+    descriptor_pool_create_info.pPoolSizes = &pool_size;
+    descriptor_pool_create_info.maxSets = set_count;
+    if (vkCreateDescriptorPool(logical_device, &descriptor_pool_create_info, nullptr, &material_descriptor_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create material descriptor pool!");
+    }
+
+    auto layouts = std::vector<VkDescriptorSetLayout>{set_count, material_descriptor_set_layout};
+    auto descriptor_set_allocate_info = VkDescriptorSetAllocateInfo{};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.descriptorPool = material_descriptor_pool;
+    descriptor_set_allocate_info.descriptorSetCount = set_count;
+    descriptor_set_allocate_info.pSetLayouts = layouts.data();
+
+    material_descriptor_sets.resize(set_count);
+    if (vkAllocateDescriptorSets(logical_device, &descriptor_set_allocate_info, material_descriptor_sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate material descriptor sets!");
+    }
+
+    for (auto frame = (uint32_t) 0; frame < MAX_FRAMES_IN_FLIGHT; frame++) update_material_descriptors(frame);
+}
+
+// Points every material set of the frame at the material's current image view. Called for a frame
+// whose last submission finished, so none of its sets is in use.
+auto Hello_Triangle_Application::update_material_descriptors(uint32_t frame) -> void
+{
+    auto sets_per_frame = model.materials.size() + 1;
+    auto image_infos = std::vector<VkDescriptorImageInfo>(sets_per_frame);
+    auto writes = std::vector<VkWriteDescriptorSet>(sets_per_frame);
+    for (auto i = (size_t) 0; i < sets_per_frame; i++) {
+        image_infos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        image_infos[i].imageView = material_image_view(i < model.materials.size() ? static_cast<int32_t>(i) : -1);
+        image_infos[i].sampler = texture_sampler;
+
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = material_descriptor_sets[frame * sets_per_frame + i];
+        writes[i].dstBinding = 0;
+        writes[i].dstArrayElement = 0;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[i].descriptorCount = 1;
+        writes[i].pImageInfo = &image_infos[i];
     }
+    vkUpdateDescriptorSets(logical_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    material_descriptors_written[frame] = material_descriptor_version;
+}
+
+// What a material samples: its texture once that is uploaded, the texture until then and for
+// meshes without material.
+auto Hello_Triangle_Application::material_image_view(int32_t material) const -> VkImageView
+{
+    auto texture = loaded_model_texture(material_texture_index(material));
+    return texture ? texture->view : texture_image_view;
+}
+
+// The one of model.textures a material samples, its base color or else its diffuse texture.
+auto Hello_Triangle_Application::material_texture_index(int32_t material) const -> Assimp_Model::Texture_Index
+{
+    if (material < 0 || size_t(material) >= model.materials.size()) return Assimp_Model::no_texture;
+
+    auto const& textures = model.materials[material].textures;
+    auto base_color = textures[size_t(Assimp_Model::Texture_Type::base_color)];
+    return base_color != Assimp_Model::no_texture ? base_color : textures[size_t(Assimp_Model::Texture_Type::diffuse)];
+}
+
+// The image behind one of model.textures, null when it was not found or has not been uploaded yet.
+auto Hello_Triangle_Application::loaded_model_texture(Assimp_Model::Texture_Index index) const -> Model_Texture const*
+{
+    if (index == Assimp_Model::no_texture || index >= model_texture_files.size()) return nullptr;
+    auto file = model_texture_files[index];
+    if (file >= model_textures.size() || model_textures[file].image == VK_NULL_HANDLE) return nullptr;
+    return &model_textures[file];
 }
 
 auto Hello_Triangle_Application::create_compute_descriptor_sets() -> void
@@ -1479,7 +2792,16 @@ auto Hello_Triangle_Application::draw_frame() -> void
 
     vkWaitForFences(logical_device, 1, &compute_in_flight_fences[current_frame], VK_TRUE, UINT64_MAX);
 
+    // The animated vertex buffer of this frame is only rewritten once the draw that last read it is done.
+    if (animated()) {
+        vkWaitForFences(logical_device, 1, &in_flight_fences[current_frame], VK_TRUE, UINT64_MAX);
+    }
+
     update_uniform_buffer(current_frame);
+    read_animation_time(current_frame);
+    update_morph_weights();
+    update_animation();
+    update_bone_matrices(current_frame);
 
     vkResetFences(logical_device, 1, &compute_in_flight_fences[current_frame]);
 
@@ -1498,6 +2820,7 @@ auto Hello_Triangle_Application::draw_frame() -> void
     }
 
     vkWaitForFences(logical_device, 1, &in_flight_fences[current_frame], VK_TRUE, UINT64_MAX);
+    destroy_retired_resources(false);
 
     auto image_index = (uint32_t) 0;
     auto next_image_result = vkAcquireNextImageKHR(logical_device, swap_chain, UINT64_MAX, image_available_semaphores[current_frame], VK_NULL_HANDLE, &image_index);
@@ -1513,6 +2836,7 @@ auto Hello_Triangle_Application::draw_frame() -> void
 
     vkResetCommandBuffer(command_buffers[current_frame], 0);
 
+    if (material_descriptors_written[current_frame] != material_descriptor_version) update_material_descriptors(current_frame);
     record_command_buffer(command_buffers[current_frame], image_index);
 
     auto wait_semaphores = std::vector<VkSemaphore>{compute_finished_semaphores[current_frame], image_available_semaphores[current_frame]};
@@ -1533,6 +2857,7 @@ auto Hello_Triangle_Application::draw_frame() -> void
     if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to submit queue!");
     }
+    submitted_frames++;
 
     auto present_info = VkPresentInfoKHR{};
     present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1554,6 +2879,12 @@ auto Hello_Triangle_Application::draw_frame() -> void
         throw std::runtime_error("failed to present swap chain image!");
     }
 
+    if (!first_frame_presented) {
+        first_frame_presented = true;
+        auto ms = std::chrono::duration<double, std::milli>(Asset_Loader::Clock::now() - startup_time).count();
+        std::cout << "Startup: time to first frame " << ms << " ms" << (asset_loader.pending() ? ", showing placeholders" : "") << std::endl;
+    }
+
     current_frame = (current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
@@ -1613,18 +2944,67 @@ auto Hello_Triangle_Application::record_command_buffer(VkCommandBuffer command_b
 
         auto offsets = std::vector<VkDeviceSize>{0};
 
-        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
+        // The model is bound once, every mesh is a range of the shared buffers.
+        // Animated positions only exist in the float layout, the packed one is quantized at load time.
+        auto packed = use_packed_vertices && !animated();
+        auto model_position_buffer = packed ? packed_position_buffer : position_buffer;
+        if (animated()) model_position_buffer = animated_position_buffers[current_frame];
+        auto vertex_buffers = std::vector<VkBuffer>{model_position_buffer, packed ? packed_attribute_buffer : attribute_buffer};
+        auto stream_offsets = std::vector<VkDeviceSize>{0, 0};
+
+        // The prepass only reads the position stream; the shading pass after it then passes the
+        // depth test once per pixel instead of once per overlapping triangle.
+        auto first_pipeline = packed ? packed_graphics_pipeline : graphics_pipeline;
+        if (use_depth_prepass) first_pipeline = packed ? packed_depth_prepass_pipeline : depth_prepass_pipeline;
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, first_pipeline);
         vkCmdSetViewport(command_buffer, 0, 1, &viewport);
         vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
-        auto vertex_buffers = std::vector<VkBuffer>{vertex_buffer};
-        vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers.data(), offsets.data());
+        vkCmdBindVertexBuffers(command_buffer, 0, static_cast<uint32_t>(vertex_buffers.size()), vertex_buffers.data(), stream_offsets.data());
 
-        vkCmdBindIndexBuffer(command_buffer, index_buffer, 0, VK_INDEX_TYPE_UINT32);
+        vkCmdBindIndexBuffer(command_buffer, index_buffer, 0, model_index_type);
 
         vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets[current_frame], 0, nullptr);
+        frame_bind_count += 4;
+
+        model_hierarchy.update();
+        select_model_lods();
+        // Ranges are sorted by material, so the shading pass binds each material's set once.
+        auto sets_per_frame = model.materials.size() + 1;
+        auto draw_model = [&] (bool shading) {
+            auto bound_material = sets_per_frame;
+            for (auto const& range: model_draw_ranges) {
+                auto material = range.material >= 0 && size_t(range.material) < model.materials.size() ? size_t(range.material) : model.materials.size();
+                if (shading && material != bound_material) {
+                    auto material_set = material_descriptor_sets[current_frame * sets_per_frame + material];
+                    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 1, 1, &material_set, 0, nullptr);
+                    bound_material = material;
+                    frame_bind_count++;
+                }
+
+                auto draw_constants = Draw_Constants{};
+                auto node = model.meshes[range.mesh].parent;
+                if (node >= 0) draw_constants.node_matrix = model_hierarchy.world(node);
+                draw_constants.quantization = range.quantization;
+                vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Draw_Constants), &draw_constants);
+
+                auto const& lods = model.meshes[range.mesh].lods;
+                if (lods.empty()) {
+                    vkCmdDrawIndexed(command_buffer, range.index_count, 1, range.first_index, range.vertex_offset, 0);
+                } else {
+                    auto const& lod = lods[range.lod];
+                    vkCmdDrawIndexed(command_buffer, lod.triangle_count * 3, 1, range.first_index + lod.first_triangle * 3, range.vertex_offset, 0);
+                }
+                frame_draw_count++;
+            }
+        };
 
-        vkCmdDrawIndexed(command_buffer, static_cast<uint32_t>(model_indices.size()), 1, 0, 0, 0);
+        draw_model(!use_depth_prepass);
+        if (use_depth_prepass) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packed ? packed_graphics_pipeline : graphics_pipeline);
+            frame_bind_count++;
+            draw_model(true);
+        }
 
         vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline2);
         vkCmdSetViewport(command_buffer, 0, 1, &viewport);
@@ -1632,6 +3012,8 @@ auto Hello_Triangle_Application::record_command_buffer(VkCommandBuffer command_b
 
         vkCmdBindVertexBuffers(command_buffer, 0, 1, &shader_storage_buffers[current_frame], offsets.data());
         vkCmdDraw(command_buffer, PARTICLE_COUNT, 1, 0, 0);
+        frame_bind_count += 2;
+        frame_draw_count++;
     }
     vkCmdEndRenderPass(command_buffer);
 
@@ -1641,6 +3023,52 @@ auto Hello_Triangle_Application::record_command_buffer(VkCommandBuffer command_b
     }
 }
 
+auto Hello_Triangle_Application::select_model_lods() -> void
+{
+    auto pixels_per_radian = float(swap_chain_extent.height) / (2.0f * std::tan(camera_fov_y * 0.5f));
+    auto changed = false;
+    auto triangle_count = (size_t) 0;
+
+    for (auto& range: model_draw_ranges) {
+        // Pixels per object space unit at the closest point of the bounding sphere, grown by the node transform.
+        // The model only rotates around its origin, so the sphere around the origin through the far side of
+        // the mesh's sphere bounds it in every frame.
+        auto const& sphere = model.meshes[range.mesh].bounds.sphere;
+        auto center = glm::vec3{sphere};
+        auto scale = 1.0f;
+        auto node = model.meshes[range.mesh].parent;
+        if (node >= 0) {
+            auto const& world = model_hierarchy.world(node);
+            scale = std::max({glm::length(glm::vec3{world[0]}), glm::length(glm::vec3{world[1]}), glm::length(glm::vec3{world[2]})});
+            center = glm::vec3{world * glm::vec4{center, 1.0f}};
+        }
+        auto radius = glm::length(center) + sphere.w * scale;
+        auto distance = std::max(glm::length(camera_position) - radius, camera_near);
+        auto pixels_per_unit = pixels_per_radian * scale / distance;
+        range.pixels = 2.0f * sphere.w * pixels_per_unit;
+
+        auto const& lods = model.meshes[range.mesh].lods;
+        if (lods.empty()) {
+            triangle_count += range.index_count / 3;
+            continue;
+        }
+
+        auto selected = (uint32_t) 0;
+        for (auto i = (uint32_t) 1; i < lods.size(); i++) {
+            if (lods[i].error * pixels_per_unit > lod_error_threshold) break;
+            selected = i;
+        }
+
+        changed = changed || selected != range.lod;
+        range.lod = selected;
+        triangle_count += lods[selected].triangle_count;
+    }
+
+    if (changed) {
+        std::cout << "Model LODs changed: " << triangle_count << " triangles" << std::endl;
+    }
+}
+
 auto Hello_Triangle_Application::record_compute_command_buffer(VkCommandBuffer command_buffer) -> void
 {
     auto command_buffer_begin_info = VkCommandBufferBeginInfo{};
@@ -1651,6 +3079,8 @@ auto Hello_Triangle_Application::record_compute_command_buffer(VkCommandBuffer c
         throw std::runtime_error("failed to begin recording command buffer");
     }
 
+    record_vertex_animation(command_buffer);
+
     vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipeline);
     vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipeline_layout, 0, 1, &compute_descriptor_sets[current_frame], 0, nullptr);
     vkCmdDispatch(command_buffer, PARTICLE_COUNT / 256, 1, 1);
@@ -1690,6 +3120,37 @@ auto Hello_Triangle_Application::create_buffer(VkDeviceSize size, VkBufferUsageF
     vkBindBufferMemory(logical_device, *buffer, *buffer_memory, 0);
 }
 
+auto Hello_Triangle_Application::create_device_local_buffer(void const* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer* buffer, VkDeviceMemory* buffer_memory, VkDeviceSize capacity) -> void
+{
+    auto staging_buffer = VkBuffer{};
+    auto staging_buffer_memory = VkDeviceMemory{};
+    create_buffer(
+        size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &staging_buffer,
+        &staging_buffer_memory
+    );
+
+    auto mapped = (void*) nullptr;
+    vkMapMemory(logical_device, staging_buffer_memory, 0, size, 0, &mapped);
+    memcpy(mapped, data, (size_t) size);
+    vkUnmapMemory(logical_device, staging_buffer_memory);
+
+    // A larger capacity leaves the rest of the buffer uninitialized.
+    create_buffer(
+        std::max(size, capacity),
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        buffer,
+        buffer_memory
+    );
+
+    copy_buffer(staging_buffer, *buffer, size);
+    vkDestroyBuffer(logical_device, staging_buffer, nullptr);
+    vkFreeMemory(logical_device, staging_buffer_memory, nullptr);
+}
+
 auto Hello_Triangle_Application::copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size) -> void
 {
     auto command_buffer = begin_single_time_commands();
@@ -1703,22 +3164,11 @@ auto Hello_Triangle_Application::copy_buffer(VkBuffer src_buffer, VkBuffer dst_b
     end_single_time_commands(command_buffer);
 }
 
-auto Hello_Triangle_Application::copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) -> void
+auto Hello_Triangle_Application::copy_buffer_to_image(VkBuffer buffer, VkImage image, std::vector<VkBufferImageCopy> const& regions) -> void
 {
     auto command_buffer = begin_single_time_commands();
 
-    auto buffer_image_copy = VkBufferImageCopy{};
-    buffer_image_copy.bufferOffset = 0;
-    buffer_image_copy.bufferRowLength = 0;
-    buffer_image_copy.bufferImageHeight = 0;
-    buffer_image_copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    buffer_image_copy.imageSubresource.mipLevel = 0;
-    buffer_image_copy.imageSubresource.baseArrayLayer = 0;
-    buffer_image_copy.imageSubresource.layerCount = 1;
-    buffer_image_copy.imageOffset = {0, 0, 0};
-    buffer_image_copy.imageExtent = {width, height, 1};
-
-    vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &buffer_image_copy);
+    vkCmdCopyBufferToImage(command_buffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
 
     end_single_time_commands(command_buffer);
 }
@@ -1730,14 +3180,154 @@ auto Hello_Triangle_Application::update_uniform_buffer(uint32_t current_image) -
 
     auto ubo = Uniform_Buffer_Object{};
     ubo.model_matrix = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.view_matrix = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    ubo.projection_matrix = glm::perspective(glm::radians(45.0f), swap_chain_extent.width / (float) swap_chain_extent.height, 0.1f, 10.0f);
+    ubo.view_matrix = glm::lookAt(camera_position, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    ubo.projection_matrix = glm::perspective(camera_fov_y, swap_chain_extent.width / (float) swap_chain_extent.height, camera_near, camera_far);
     ubo.projection_matrix[1][1] *= -1.0f;
     ubo.delta_time = glm::vec4{last_frame_time * 2.0f};
 
     memcpy(uniform_buffers_mapped[current_image], &ubo, sizeof(ubo));
 }
 
+auto Hello_Triangle_Application::update_animation() -> void
+{
+    if (model_animations.empty()) return;
+
+    auto time = static_cast<float>(glfwGetTime());
+    sample_animation(model_animations.front(), &time, &model_hierarchy, 1);
+}
+
+auto Hello_Triangle_Application::update_bone_matrices(uint32_t current_image) -> void
+{
+    if (skin_vertices.empty()) return;
+
+    model_hierarchy.update();
+
+    auto palette = static_cast<glm::mat4*>(bone_matrix_buffers_mapped[current_image]);
+    for (auto const& range: model_draw_ranges) {
+        auto const& mesh = model.meshes[range.mesh];
+        if (!mesh.bones.empty()) compute_skin_matrices(mesh, model_hierarchy, palette + range.bone_offset);
+    }
+
+    // The stress instances share the pose but still read their own copy of the palette.
+    for (auto instance = (uint32_t) 1; instance < skinning_instance_count; instance++) {
+        memcpy(palette + instance * skin_bone_count, palette, sizeof(glm::mat4) * skin_bone_count);
+    }
+}
+
+auto Hello_Triangle_Application::update_morph_weights() -> void
+{
+    if (morph_keys.empty()) return;
+
+    // M swings every key through its range, each with its own phase; otherwise the file's weights hold.
+    auto time = static_cast<float>(glfwGetTime());
+    for (auto key = (size_t) 0; key < morph_keys.size(); key++) {
+        morph_weights[key] = animate_morph_weights ? 0.5f + 0.5f * std::sin(time + float(key)) : morph_keys[key].default_weight;
+    }
+}
+
+auto Hello_Triangle_Application::record_vertex_animation(VkCommandBuffer command_buffer) -> void
+{
+    if (!animated()) return;
+
+    auto first_query = static_cast<uint32_t>(current_frame * 3);
+    if (animation_query_pool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(command_buffer, animation_query_pool, first_query, 3);
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, animation_query_pool, first_query);
+    }
+
+    auto memory_barrier = VkMemoryBarrier{};
+    memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    auto compute_barrier = [&] {
+        vkCmdPipelineBarrier(
+            command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memory_barrier, 0, nullptr, 0, nullptr
+        );
+    };
+
+    // Shape keys first: reset the moved vertices to the base mesh, add every key with a noticeable
+    // weight, one dispatch over only its own deltas, then write the result for the draw.
+    auto frame_deltas = (size_t) 0;
+    if (!morph_vertices.empty()) {
+        auto constants = Morph_Constants{};
+        constants.count = static_cast<uint32_t>(morph_vertices.size());
+        constants.vertex_stride = static_cast<uint32_t>(sizeof(glm::vec3) / sizeof(float));
+
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, morph_pipeline);
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, morph_pipeline_layout, 0, 1, &morph_descriptor_sets[current_frame], 0, nullptr);
+        vkCmdPushConstants(command_buffer, morph_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(command_buffer, (constants.count + 63) / 64, 1, 1);
+
+        for (auto key = (size_t) 0; key < morph_keys.size(); key++) {
+            if (std::abs(morph_weights[key]) <= 1e-4f || morph_keys[key].delta_count == 0) continue;
+            compute_barrier();
+            constants.mode = 1;
+            constants.first = morph_keys[key].first_delta;
+            constants.count = morph_keys[key].delta_count;
+            constants.weight = morph_weights[key];
+            vkCmdPushConstants(command_buffer, morph_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+            vkCmdDispatch(command_buffer, (constants.count + 63) / 64, 1, 1);
+            frame_deltas += constants.count;
+        }
+
+        compute_barrier();
+        constants.mode = 2;
+        constants.first = 0;
+        constants.count = static_cast<uint32_t>(morph_vertices.size());
+        constants.weight = 0.0f;
+        vkCmdPushConstants(command_buffer, morph_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(command_buffer, (constants.count + 63) / 64, 1, 1);
+    }
+
+    if (animation_query_pool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, animation_query_pool, first_query + 1);
+    }
+
+    // Skinning then reads the morphed positions and overwrites the vertices it poses.
+    if (!skin_vertices.empty()) {
+        compute_barrier();
+
+        auto constants = Skinning_Constants{};
+        constants.skin_vertex_count = static_cast<uint32_t>(skin_vertices.size());
+        constants.vertex_count = static_cast<uint32_t>(model_positions.size());
+        constants.vertex_stride = static_cast<uint32_t>(sizeof(glm::vec3) / sizeof(float));
+        constants.bone_count = skin_bone_count;
+
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, skinning_pipeline);
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, skinning_pipeline_layout, 0, 1, &skinning_descriptor_sets[current_frame], 0, nullptr);
+        vkCmdPushConstants(command_buffer, skinning_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(command_buffer, (constants.skin_vertex_count + 63) / 64, skinning_instance_count, 1);
+    }
+
+    if (animation_query_pool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, animation_query_pool, first_query + 2);
+        animation_queries_pending[current_frame] = true;
+        animation_frame_deltas[current_frame] = frame_deltas;
+    }
+}
+
+auto Hello_Triangle_Application::read_animation_time(uint32_t current_image) -> void
+{
+    if (animation_query_pool == VK_NULL_HANDLE || !animation_queries_pending[current_image]) return;
+
+    // The compute fence of this frame has signaled, so all three timestamps are available.
+    auto timestamps = std::array<uint64_t, 3>{};
+    auto result = vkGetQueryPoolResults(
+        logical_device, animation_query_pool, current_image * 3, 3, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT
+    );
+    if (result != VK_SUCCESS) return;
+
+    animation_queries_pending[current_image] = false;
+    if (!morph_vertices.empty()) {
+        morph_report_ms += double(timestamps[1] - timestamps[0]) * timestamp_period / 1e6;
+        morph_report_deltas += animation_frame_deltas[current_image];
+    }
+    if (!skin_vertices.empty()) {
+        skinning_report_ms += double(timestamps[2] - timestamps[1]) * timestamp_period / 1e6;
+        skinning_report_vertices += skin_vertices.size() * skinning_instance_count;
+    }
+}
+
 auto Hello_Triangle_Application::create_image(uint32_t width, uint32_t height, uint32_t mip_levels, VkSampleCountFlagBits num_samples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage* image, VkDeviceMemory* image_memory) -> void
 {
     auto image_info = VkImageCreateInfo{};
@@ -1891,16 +3481,102 @@ auto Hello_Triangle_Application::has_stencil_component(VkFormat format) -> bool
     return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 }
 
+// Fills in the levels below the top one, which was just copied into an image with every level in
+// TRANSFER_DST_OPTIMAL, and leaves all of them SHADER_READ_ONLY_OPTIMAL. Logs how long recording
+// took on the CPU and, with timestamps, how long the commands took on the GPU.
 auto Hello_Triangle_Application::generate_mipmaps(VkImage image, VkFormat image_format, int32_t tex_width, int32_t tex_height, uint32_t mip_levels) -> void
 {
-    auto format_properties = VkFormatProperties{};
-    vkGetPhysicalDeviceFormatProperties(physical_device, image_format, &format_properties);
-    if (!(format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
-        throw std::runtime_error("texture image format does not support liner blitting!");
+    using Clock = std::chrono::high_resolution_clock;
+
+    auto use_compute = texture_mips != Mip_Generation::blit && mip_generation_pipeline != VK_NULL_HANDLE && image_format == VK_FORMAT_R8G8B8A8_SRGB;
+    if (!use_compute) {
+        auto format_properties = VkFormatProperties{};
+        vkGetPhysicalDeviceFormatProperties(physical_device, image_format, &format_properties);
+        if (!(format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
+            throw std::runtime_error("texture image format does not support liner blitting!");
+        }
+    }
+
+    // The shader can not write the sRGB image, so it works on an RGBA8 UNORM copy holding the same
+    // bytes and the levels it wrote are copied back.
+    auto scratch_image = VkImage{};
+    auto scratch_image_memory = VkDeviceMemory{};
+    auto scratch_views = std::vector<VkImageView>{};
+    if (use_compute) {
+        create_image(
+            tex_width,
+            tex_height,
+            mip_levels,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_FORMAT_R8G8B8A8_UNORM,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            &scratch_image,
+            &scratch_image_memory
+        );
+        for (auto level = (uint32_t) 0; level < mip_levels; level++) {
+            auto image_view_create_info = VkImageViewCreateInfo{};
+            image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            image_view_create_info.image = scratch_image;
+            image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            image_view_create_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+            image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            image_view_create_info.subresourceRange.baseMipLevel = level;
+            image_view_create_info.subresourceRange.levelCount = 1;
+            image_view_create_info.subresourceRange.baseArrayLayer = 0;
+            image_view_create_info.subresourceRange.layerCount = 1;
+
+            auto image_view = VkImageView{};
+            if (vkCreateImageView(logical_device, &image_view_create_info, nullptr, &image_view) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create mip generation image view!");
+            }
+            scratch_views.emplace_back(image_view);
+        }
     }
 
+    auto record_start = Clock::now();
     auto command_buffer = begin_single_time_commands();
+    if (mip_generation_query_pool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(command_buffer, mip_generation_query_pool, 0, 2);
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mip_generation_query_pool, 0);
+    }
+
+    auto barrier_count = use_compute
+        ? record_compute_mipmaps(command_buffer, image, scratch_image, scratch_views, tex_width, tex_height, mip_levels)
+        : record_blit_mipmaps(command_buffer, image, tex_width, tex_height, mip_levels);
+
+    if (mip_generation_query_pool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mip_generation_query_pool, 1);
+    }
+    auto record_ms = std::chrono::duration<double, std::milli>(Clock::now() - record_start).count();
+    end_single_time_commands(command_buffer);
 
+    for (auto image_view: scratch_views) {
+        vkDestroyImageView(logical_device, image_view, nullptr);
+    }
+    if (use_compute) {
+        vkDestroyImage(logical_device, scratch_image, nullptr);
+        vkFreeMemory(logical_device, scratch_image_memory, nullptr);
+    }
+
+    std::cout << "Mip generation (" << (use_compute ? "compute" : "blit") << "): " << mip_levels << " levels of " << tex_width << "x" << tex_height
+              << ", " << barrier_count << " barriers, recorded in " << record_ms << " ms";
+    if (mip_generation_query_pool != VK_NULL_HANDLE) {
+        // end_single_time_commands() waited for the queue, so both timestamps are available.
+        auto timestamps = std::array<uint64_t, 2>{};
+        vkGetQueryPoolResults(
+            logical_device, mip_generation_query_pool, 0, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT
+        );
+        std::cout << ", " << double(timestamps[1] - timestamps[0]) * timestamp_period / 1e6 << " ms on the GPU";
+    }
+    std::cout << std::endl;
+}
+
+// One blit per level from the level above, with a barrier before each to make the level above a
+// transfer source and one after to hand it to the fragment shader. Returns the barriers recorded.
+auto Hello_Triangle_Application::record_blit_mipmaps(VkCommandBuffer command_buffer, VkImage image, int32_t tex_width, int32_t tex_height, uint32_t mip_levels) -> uint32_t
+{
     auto barrier = VkImageMemoryBarrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.image = image;
@@ -1982,7 +3658,133 @@ auto Hello_Triangle_Application::generate_mipmaps(VkImage image, VkFormat image_
         1, &barrier
     );
 
-    end_single_time_commands(command_buffer);
+    return (mip_levels - 1) * 2 + 1;
+}
+
+// Copies the top level into the scratch image, lets mipgen.comp write MIP_LEVELS_PER_DISPATCH
+// levels per dispatch with one barrier between dispatches, and copies the new levels back in a
+// single command. Returns the barriers recorded.
+auto Hello_Triangle_Application::record_compute_mipmaps(VkCommandBuffer command_buffer, VkImage image, VkImage scratch_image, std::vector<VkImageView> const& scratch_views, int32_t tex_width, int32_t tex_height, uint32_t mip_levels) -> uint32_t
+{
+    auto barrier_count = (uint32_t) 0;
+    auto image_barrier = [] (VkImage image, uint32_t base_level, uint32_t level_count, VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access, VkAccessFlags dst_access) {
+        auto barrier = VkImageMemoryBarrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.image = image;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = base_level;
+        barrier.subresourceRange.levelCount = level_count;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.oldLayout = old_layout;
+        barrier.newLayout = new_layout;
+        barrier.srcAccessMask = src_access;
+        barrier.dstAccessMask = dst_access;
+        return barrier;
+    };
+    auto pipeline_barrier = [&] (VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage, std::vector<VkImageMemoryBarrier> const& barriers) {
+        vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+        barrier_count++;
+    };
+    auto level_extent = [&] (uint32_t level) {
+        return VkExtent3D{std::max(uint32_t(tex_width) >> level, 1u), std::max(uint32_t(tex_height) >> level, 1u), 1};
+    };
+
+    // One descriptor set per dispatch. Slots past the last level repeat it; the shader never
+    // writes them.
+    vkResetDescriptorPool(logical_device, mip_generation_descriptor_pool, 0);
+    auto dispatch_count = (mip_levels - 1 + MIP_LEVELS_PER_DISPATCH - 1) / MIP_LEVELS_PER_DISPATCH;
+    auto layouts = std::vector<VkDescriptorSetLayout>{dispatch_count, mip_generation_descriptor_set_layout};
+    auto descriptor_set_allocate_info = VkDescriptorSetAllocateInfo{};
+    descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptor_set_allocate_info.descriptorPool = mip_generation_descriptor_pool;
+    descriptor_set_allocate_info.descriptorSetCount = dispatch_count;
+    descriptor_set_allocate_info.pSetLayouts = layouts.data();
+
+    auto descriptor_sets = std::vector<VkDescriptorSet>{dispatch_count};
+    if (vkAllocateDescriptorSets(logical_device, &descriptor_set_allocate_info, descriptor_sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate mip generation descriptor sets!");
+    }
+    for (auto dispatch = (uint32_t) 0; dispatch < dispatch_count; dispatch++) {
+        auto base = dispatch * MIP_LEVELS_PER_DISPATCH;
+        auto image_infos = std::array<VkDescriptorImageInfo, 1 + MIP_LEVELS_PER_DISPATCH>{};
+        for (auto i = (size_t) 0; i < image_infos.size(); i++) {
+            image_infos[i].imageView = scratch_views[std::min(base + uint32_t(i), mip_levels - 1)];
+            image_infos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        }
+
+        auto writes = std::array<VkWriteDescriptorSet, 2>{};
+        for (auto binding = (size_t) 0; binding < writes.size(); binding++) {
+            writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[binding].dstSet = descriptor_sets[dispatch];
+            writes[binding].dstBinding = static_cast<uint32_t>(binding);
+            writes[binding].dstArrayElement = 0;
+            writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[binding].descriptorCount = binding == 0 ? 1 : MIP_LEVELS_PER_DISPATCH;
+            writes[binding].pImageInfo = binding == 0 ? &image_infos[0] : &image_infos[1];
+        }
+        vkUpdateDescriptorSets(logical_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {
+        image_barrier(image, 0, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT),
+        image_barrier(scratch_image, 0, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT),
+    });
+
+    auto top_level = VkImageCopy{};
+    top_level.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    top_level.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    top_level.extent = level_extent(0);
+    vkCmdCopyImage(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, scratch_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &top_level);
+
+    pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
+        image_barrier(scratch_image, 0, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT),
+        image_barrier(scratch_image, 1, mip_levels - 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_WRITE_BIT),
+    });
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, mip_generation_pipeline);
+    for (auto dispatch = (uint32_t) 0; dispatch < dispatch_count; dispatch++) {
+        auto base = dispatch * MIP_LEVELS_PER_DISPATCH;
+        if (dispatch > 0) {
+            // The last level written is the next dispatch's source.
+            pipeline_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
+                image_barrier(scratch_image, base, 1, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT),
+            });
+        }
+
+        auto source = level_extent(base);
+        auto first = level_extent(base + 1);
+        auto constants = Mip_Generation_Constants{};
+        constants.source_size = glm::uvec2{source.width, source.height};
+        constants.level_count = std::min(MIP_LEVELS_PER_DISPATCH, mip_levels - 1 - base);
+
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, mip_generation_pipeline_layout, 0, 1, &descriptor_sets[dispatch], 0, nullptr);
+        vkCmdPushConstants(command_buffer, mip_generation_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(command_buffer, (first.width + 15) / 16, (first.height + 15) / 16, 1);
+    }
+
+    pipeline_barrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {
+        image_barrier(scratch_image, 1, mip_levels - 1, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT),
+    });
+
+    auto copies = std::vector<VkImageCopy>{};
+    for (auto level = (uint32_t) 1; level < mip_levels; level++) {
+        auto copy = VkImageCopy{};
+        copy.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        copy.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        copy.extent = level_extent(level);
+        copies.emplace_back(copy);
+    }
+    vkCmdCopyImage(command_buffer, scratch_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copies.size()), copies.data());
+
+    pipeline_barrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {
+        image_barrier(image, 0, 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT),
+        image_barrier(image, 1, mip_levels - 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT),
+    });
+
+    return barrier_count;
 }
 
 auto Hello_Triangle_Application::cleanup_swap_chain() -> void
@@ -1,12 +1,23 @@
 #pragma once
 #include "loader.hpp"
+#include "animation.hpp"
+#include "asset_archive.hpp"
+#include "asset_loader.hpp"
+#include "texture_ingest.hpp"
+#include "texture_streaming.hpp"
+#include "thread_pool.hpp"
+#include "transform_hierarchy.hpp"
+#include "vertex_packing.hpp"
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
 #include <iostream>
 #include <array>
+#include <functional>
+#include <chrono>
 #include <vector>
+#include <string>
 #include <optional>
 #include <stdexcept>
 #include <cstdlib>
@@ -16,50 +27,236 @@ const uint32_t WIDTH = 800;
 const uint32_t HEIGHT = 600;
 
 const int MAX_FRAMES_IN_FLIGHT = 2;
+const uint32_t MIP_LEVELS_PER_DISPATCH = 5;     // written by one dispatch of mipgen.comp
+const uint32_t STAGING_SLOT_COUNT = 3;
+const VkDeviceSize STAGING_SLOT_SIZE = VkDeviceSize(16) << 20;     // larger textures get a staging buffer of their own
+const size_t TEXTURE_INGEST_BUDGET = size_t(256) << 20;     // decoded bytes of model textures waiting for upload
+const uint32_t TEXTURE_TAIL_SIZE = 64;                      // levels this large and smaller are uploaded first and never evicted
+const size_t TEXTURE_STREAM_UPLOADS_PER_FRAME = 2;          // textures that get a finer level per frame
 
 const std::vector<const char*> validation_layers = {"VK_LAYER_KHRONOS_validation"};
 const std::vector<const char*> device_extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
-struct Vertex final
+// The float vertex layout comes in two streams. Binding 0 holds the positions alone, as glm::vec3,
+// so passes that read nothing else (depth.vert) fetch 12 bytes per vertex. Binding 1 holds the rest.
+struct Vertex_Attributes final
 {
-    glm::vec3 position{};
     glm::vec4 color{};
     glm::vec2 tex_coord{};
 
-    static auto get_binding_description() -> VkVertexInputBindingDescription
+    static auto get_binding_descriptions() -> std::array<VkVertexInputBindingDescription, 2>
     {
-        auto binding_description = VkVertexInputBindingDescription{};
-        binding_description.binding = 0;
-        binding_description.stride = sizeof(Vertex);
-        binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        auto binding_descriptions = std::array<VkVertexInputBindingDescription, 2>{};
+        binding_descriptions[0].binding = 0;
+        binding_descriptions[0].stride = sizeof(glm::vec3);
+        binding_descriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        binding_descriptions[1].binding = 1;
+        binding_descriptions[1].stride = sizeof(Vertex_Attributes);
+        binding_descriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-        return binding_description;
+        return binding_descriptions;
     }
 
+    // Position first, so the first binding and attribute alone describe the position stream.
     static auto get_attribute_descriptions() -> std::array<VkVertexInputAttributeDescription, 3>
     {
         auto attribute_descriptions = std::array<VkVertexInputAttributeDescription, 3>{};
         attribute_descriptions[0].binding = 0;
         attribute_descriptions[0].location = 0;
         attribute_descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attribute_descriptions[0].offset = offsetof(Vertex, position);
-        attribute_descriptions[1].binding = 0;
+        attribute_descriptions[0].offset = 0;
+        attribute_descriptions[1].binding = 1;
         attribute_descriptions[1].location = 1;
         attribute_descriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-        attribute_descriptions[1].offset = offsetof(Vertex, color);
-        attribute_descriptions[2].binding = 0;
+        attribute_descriptions[1].offset = offsetof(Vertex_Attributes, color);
+        attribute_descriptions[2].binding = 1;
         attribute_descriptions[2].location = 2;
         attribute_descriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-        attribute_descriptions[2].offset = offsetof(Vertex, tex_coord);
+        attribute_descriptions[2].offset = offsetof(Vertex_Attributes, tex_coord);
 
         return attribute_descriptions;
     }
 };
 
+// Counterpart of Vertex_Attributes for triangle_packed.vert, see vertex_packing.hpp for the encoding.
+// Binding 0 holds glm::u16vec4 positions, xyz quantized against the mesh bounds and w the octahedral
+// normal; binding 1 holds the rest. 16 bytes per vertex, of which a depth pass fetches 8.
+struct Packed_Vertex_Attributes final
+{
+    glm::u8vec4 color{};
+    glm::u16vec2 tex_coord{};           // unorm, quantized against the mesh texture coordinate range
+
+    static auto get_binding_descriptions() -> std::array<VkVertexInputBindingDescription, 2>
+    {
+        auto binding_descriptions = std::array<VkVertexInputBindingDescription, 2>{};
+        binding_descriptions[0].binding = 0;
+        binding_descriptions[0].stride = sizeof(glm::u16vec4);
+        binding_descriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        binding_descriptions[1].binding = 1;
+        binding_descriptions[1].stride = sizeof(Packed_Vertex_Attributes);
+        binding_descriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        return binding_descriptions;
+    }
+
+    static auto get_attribute_descriptions() -> std::array<VkVertexInputAttributeDescription, 3>
+    {
+        auto attribute_descriptions = std::array<VkVertexInputAttributeDescription, 3>{};
+        attribute_descriptions[0].binding = 0;
+        attribute_descriptions[0].location = 0;
+        attribute_descriptions[0].format = VK_FORMAT_R16G16B16A16_UINT;
+        attribute_descriptions[0].offset = 0;
+        attribute_descriptions[1].binding = 1;
+        attribute_descriptions[1].location = 1;
+        attribute_descriptions[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+        attribute_descriptions[1].offset = offsetof(Packed_Vertex_Attributes, color);
+        attribute_descriptions[2].binding = 1;
+        attribute_descriptions[2].location = 2;
+        attribute_descriptions[2].format = VK_FORMAT_R16G16_UNORM;
+        attribute_descriptions[2].offset = offsetof(Packed_Vertex_Attributes, tex_coord);
+
+        return attribute_descriptions;
+    }
+};
+
+// Push constant block of triangle.vert, triangle_packed.vert and their depth.vert counterparts.
+struct Draw_Constants final
+{
+    glm::mat4 node_matrix{1.0f};            // world transform of the mesh's node
+    Vertex_Quantization quantization{};     // only read by the packed vertex layout
+};
+
+// One skinned vertex as skinning.comp reads it.
+struct Skin_Vertex final
+{
+    glm::vec3 position{};           // bind pose
+    uint32_t morph_slot{~0u};       // index for morph_vertices when a shape key moves the vertex
+    uint32_t target{};              // index for the draw position stream
+    uint32_t bone_indices{};        // four u8, x in the low byte
+    uint32_t bone_weights{};        // four unorm8
+    uint32_t bone_offset{};         // first palette entry of the mesh
+};
+
+// Push constant block of skinning.comp.
+struct Skinning_Constants final
+{
+    uint32_t skin_vertex_count{};
+    uint32_t vertex_count{};        // vertices per instance in the output
+    uint32_t vertex_stride{};       // floats per output position
+    uint32_t bone_count{};          // palette entries per instance
+};
+
+// One vertex moved by any shape key, as morph.comp reads it.
+struct Morph_Vertex final
+{
+    glm::vec3 position{};           // base position
+    uint32_t target{};              // index for the draw position stream
+};
+
+// One vertex of one sparse shape key.
+struct Morph_Delta final
+{
+    glm::vec3 position{};
+    uint32_t slot{};                // index for morph_vertices
+};
+
+// A shape key of the model, as a range of morph_deltas.
+struct Morph_Key final
+{
+    uint32_t first_delta{};
+    uint32_t delta_count{};
+    float default_weight{};
+};
+
+// Push constant block of morph.comp.
+struct Morph_Constants final
+{
+    uint32_t mode{};                // 0 reset, 1 accumulate one key, 2 write into the draw position stream
+    uint32_t first{};
+    uint32_t count{};
+    uint32_t vertex_stride{};       // floats per output position
+    float weight{};
+};
+
+// Push constant block of mipgen.comp.
+struct Mip_Generation_Constants final
+{
+    glm::uvec2 source_size{};       // of the level the dispatch reads
+    uint32_t level_count{};         // levels below it to write, at most MIP_LEVELS_PER_DISPATCH
+};
+
+// Where the texture's mip chain comes from: cooked with it on the CPU, or generated on the GPU
+// from the uploaded top level, by mipgen.comp or by one blit per level.
+enum class Mip_Generation
+{
+    cooked,
+    compute,
+    blit,
+};
+
+// One slot of the staging ring. A texture is copied into a free slot and uploaded from it on the
+// slot's own command buffer, while the GPU may still read the other slots and the workers decode
+// the next textures.
+struct Staging_Slot final
+{
+    VkBuffer buffer{};
+    VkDeviceMemory memory{};
+    void* mapped{};                 // for as long as the slot lives
+    VkCommandBuffer command_buffer{};
+    VkFence fence{};
+    bool busy{false};               // submitted, fence not waited for yet
+};
+
+// Objects that frames already submitted may still use, such as the image a streamed texture had
+// before. They are destroyed once the frame submitted next has finished, which also covers the
+// uploads recorded before it.
+struct Retired_Resources final
+{
+    uint64_t frame{};               // submitted_frames when retired
+    VkImage image{};
+    VkDeviceMemory image_memory{};
+    VkImageView view{};
+    VkBuffer buffer{};
+    VkDeviceMemory buffer_memory{};
+};
+
+// The image of one of Assimp_Model::textures; null when it could not be loaded or has not arrived.
+// It holds the levels first_level and coarser of the source as its levels 0 and up; stream_textures()
+// moves first_level as the texture is wanted and the budget allows.
+struct Model_Texture final
+{
+    VkImage image{};
+    VkDeviceMemory memory{};
+    VkImageView view{};
+    Cooked_Texture source{};                    // every level, to stream finer ones in again later
+    Texture_Residency::Handle residency{};
+    uint32_t first_level{};
+};
+
+// Where one mesh lives inside the shared model vertex and index buffers.
+struct Draw_Range final
+{
+    uint32_t mesh{};                        // index for model.meshes
+    int32_t material{-1};                   // index for model.materials
+    uint32_t first_index{};                 // of the full mesh, coarser levels follow at lods[i].first_triangle * 3
+    uint32_t index_count{};                 // of the full mesh
+    int32_t vertex_offset{};                // added to every index of the mesh
+    uint32_t lod{};                         // level picked by select_model_lods()
+    float pixels{};                         // screen size of the mesh's bounds estimated by select_model_lods()
+    Vertex_Quantization quantization{};     // pushed for the packed vertex layout
+    uint32_t bone_offset{};                 // first palette entry when the mesh is skinned
+};
+
 struct Hello_Triangle_Application final
 {
     auto run() -> void;
 
+    std::string model_file{"viking_room.obj"};     // relative to the asset directory
+    uint32_t skinning_instance_count{1};            // skinned copies per frame, only the first is drawn
+    Mip_Generation texture_mips{Mip_Generation::cooked};
+    bool serial_texture_ingest{false};              // model textures one at a time, each upload waited for, as a baseline
+    uint64_t texture_budget{uint64_t(256) << 20};   // bytes of texture levels in VRAM before the least recently used go
+
 private:
     GLFWwindow* window{};
     VkSurfaceKHR surface{};
@@ -73,11 +270,19 @@ private:
     VkDescriptorPool descriptor_pool{};
     VkDescriptorSetLayout descriptor_set_layout{};
     std::vector<VkDescriptorSet> descriptor_sets{};
+    VkDescriptorSetLayout material_descriptor_set_layout{};
+    VkDescriptorPool material_descriptor_pool{};                // recreated with the model
+    std::vector<VkDescriptorSet> material_descriptor_sets{};    // per frame in flight one per material, then one for meshes without
+    uint64_t material_descriptor_version{1};                    // bumped whenever a material's image view changes
+    std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> material_descriptors_written{};     // version each frame's sets hold
     VkDescriptorPool compute_descriptor_pool{};
     VkDescriptorSetLayout compute_descriptor_set_layout{};
     std::vector<VkDescriptorSet> compute_descriptor_sets{};
     VkPipelineLayout pipeline_layout{};
     VkPipeline graphics_pipeline{};
+    VkPipeline packed_graphics_pipeline{};
+    VkPipeline depth_prepass_pipeline{};
+    VkPipeline packed_depth_prepass_pipeline{};
     VkPipelineLayout pipeline_layout2{};
     VkPipeline graphics_pipeline2{};
     VkPipelineLayout compute_pipeline_layout{};
@@ -100,19 +305,98 @@ private:
     VkImageView color_image_view{};
 
     uint32_t texture_mip_levels{};
+    VkFormat texture_format{VK_FORMAT_R8G8B8A8_SRGB};
+    bool texture_compression_bc{false};     // the device samples BC formats, so textures are cooked to them
     VkSampleCountFlagBits msaa_samples = VK_SAMPLE_COUNT_1_BIT;
 
+    std::optional<Asset_Archive> asset_archive{};     // asset/assets.pak when one was packed, outlives the loads reading it
+    Thread_Pool worker_pool{};
+    Asset_Loader asset_loader{worker_pool};     // the model and its texture, shown once they arrive
+    std::optional<Texture_Ingest> texture_ingest{};     // the model's textures while they are decoded and uploaded
+    Asset_Loader::Clock::time_point texture_ingest_start{};
+    size_t texture_ingest_bytes{};                      // uploaded so far
+    std::vector<Staging_Slot> staging_ring{};
+    size_t staging_ring_next{0};
+    std::vector<Retired_Resources> retired_resources{};
+    uint64_t submitted_frames{0};     // frames submitted to the graphics queue so far
+    Texture_Residency texture_residency{};     // of the texture and the model textures with mip chains
+    uint64_t texture_stream_frame{0};
+    Asset_Loader::Clock::time_point startup_time{};     // run() was entered
+    bool first_frame_presented{false};
     Assimp_Model model{};
-    std::vector<Vertex> model_vertices{};
-    std::vector<uint32_t> model_indices{};
-    VkBuffer vertex_buffer{};
-    VkDeviceMemory vertex_buffer_memory{};
+    Transform_Hierarchy model_hierarchy{};
+    std::vector<Compressed_Animation> model_animations{};     // the first one plays on model_hierarchy
+    std::vector<glm::vec3> model_positions{};
+    std::vector<Vertex_Attributes> model_attributes{};
+    std::vector<uint32_t> model_indices{};     // every mesh with all of its levels of detail, back to back
+    std::vector<glm::u16vec4> model_packed_positions{};
+    std::vector<Packed_Vertex_Attributes> model_packed_attributes{};
+    std::vector<Draw_Range> model_draw_ranges{};     // sorted by material
+    std::vector<Model_Texture> model_textures{};     // one per texture file the model references, in the order given to texture_ingest
+    std::vector<size_t> model_texture_files{};       // index for model_textures of every model.textures entry, SIZE_MAX when not found
+    float camera_far{10.0f};     // fitted to the model's bounds by install_model()
+    VkIndexType model_index_type{VK_INDEX_TYPE_UINT32};
+    bool use_packed_vertices{true};     // toggled with V to compare against the float layout
+    bool use_depth_prepass{false};      // toggled with P: positions only first, then shading at equal depth
+    std::vector<Skin_Vertex> skin_vertices{};
+    uint32_t skin_bone_count{};         // palette entries of all skinned meshes together
+    std::vector<Morph_Vertex> morph_vertices{};
+    std::vector<Morph_Delta> morph_deltas{};
+    std::vector<Morph_Key> morph_keys{};
+    std::vector<float> morph_weights{};     // per morph key, animated with M
+    bool animate_morph_weights{false};
+    VkBuffer position_buffer{};
+    VkDeviceMemory position_buffer_memory{};
+    VkBuffer attribute_buffer{};
+    VkDeviceMemory attribute_buffer_memory{};
+    VkBuffer packed_position_buffer{};
+    VkDeviceMemory packed_position_buffer_memory{};
+    VkBuffer packed_attribute_buffer{};
+    VkDeviceMemory packed_attribute_buffer_memory{};
     VkBuffer index_buffer{};
     VkDeviceMemory index_buffer_memory{};
+
+    // Skinned and morphed models take their positions from animated_position_buffers, which
+    // morph.comp and then skinning.comp rewrite every frame, and their attributes from attribute_buffer.
+    VkDescriptorSetLayout skinning_descriptor_set_layout{};
+    VkPipelineLayout skinning_pipeline_layout{};
+    VkPipeline skinning_pipeline{};
+    VkDescriptorPool animation_descriptor_pool{};
+    std::vector<VkDescriptorSet> skinning_descriptor_sets{};
+    VkBuffer skin_vertex_buffer{};
+    VkDeviceMemory skin_vertex_buffer_memory{};
+    VkDescriptorSetLayout morph_descriptor_set_layout{};
+    VkPipelineLayout morph_pipeline_layout{};
+    VkPipeline morph_pipeline{};
+    std::vector<VkDescriptorSet> morph_descriptor_sets{};
+    VkBuffer morph_vertex_buffer{};
+    VkDeviceMemory morph_vertex_buffer_memory{};
+    VkBuffer morph_delta_buffer{};
+    VkDeviceMemory morph_delta_buffer_memory{};
+    std::vector<VkBuffer> morphed_position_buffers{};
+    std::vector<VkDeviceMemory> morphed_position_buffers_memory{};
+    std::vector<VkBuffer> bone_matrix_buffers{};
+    std::vector<VkDeviceMemory> bone_matrix_buffers_memory{};
+    std::vector<void*> bone_matrix_buffers_mapped{};
+    std::vector<VkBuffer> animated_position_buffers{};
+    std::vector<VkDeviceMemory> animated_position_buffers_memory{};
+    VkQueryPool animation_query_pool{};     // three timestamps per frame in flight: start, after morphing, after skinning
+    std::vector<bool> animation_queries_pending{};
+    std::vector<size_t> animation_frame_deltas{};   // shape key deltas recorded for each frame in flight
+    bool timestamps_supported{false};      // the graphics queue, which also runs compute, can write timestamps
+    float timestamp_period{};              // nanoseconds per timestamp tick
+    VkDescriptorSetLayout mip_generation_descriptor_set_layout{};
+    VkPipelineLayout mip_generation_pipeline_layout{};
+    VkPipeline mip_generation_pipeline{};     // null when RGBA8 can not be a storage image, blits are used then
+    VkDescriptorPool mip_generation_descriptor_pool{};     // reset for every texture, one set per dispatch
+    VkQueryPool mip_generation_query_pool{};     // two timestamps around the mip generation commands
     VkImage texture_image{};
     VkDeviceMemory texture_image_memory{};
     VkImageView texture_image_view{};
     VkSampler texture_sampler{};
+    Cooked_Texture texture_source{};                                // streamed like a Model_Texture when it has a mip chain
+    std::optional<Texture_Residency::Handle> texture_residency_handle{};
+    uint32_t texture_first_level{};
 
     VkInstance instance{};
     VkPhysicalDevice physical_device{VK_NULL_HANDLE};
@@ -156,6 +440,7 @@ private:
     auto create_surface() -> void;
     auto pick_physical_device() -> void;
     auto create_logical_device() -> void;
+    auto query_timestamp_support() -> void;
     auto create_swap_chain() -> void;
     auto create_image_views() -> void;
     auto create_render_pass() -> void;
@@ -164,21 +449,47 @@ private:
     auto create_graphics_pipeline() -> void;
     auto create_graphics_pipeline2() -> void;
     auto create_compute_pipeline() -> void;
+    auto create_skinning_pipeline() -> void;
+    auto create_morph_pipeline() -> void;
+    auto create_mip_generation_pipeline() -> void;
     auto create_framebuffers() -> void;
     auto create_command_pool() -> void;
     auto create_color_resources() -> void;
     auto create_depth_resources() -> void;
-    auto create_texture_image() -> void;
+    auto create_texture_image(Cooked_Texture const& texture, uint32_t first_level = 0) -> void;
     auto create_texture_image_view() -> void;
     auto create_texture_sampler() -> void;
-    auto load_models() -> void;
+    auto request_assets() -> void;
+    auto install_model(Assimp_Model loaded_model) -> void;
+    auto swap_in_loaded_assets() -> void;
+    auto create_staging_ring() -> void;
+    auto destroy_staging_ring() -> void;
+    auto submit_staged_upload(unsigned char const* bytes, VkDeviceSize size, std::function<void(VkCommandBuffer, VkBuffer)> const& record) -> void;
+    auto retire(Retired_Resources resources) -> void;
+    auto destroy_retired_resources(bool all) -> void;
+    auto start_texture_ingest() -> void;
+    auto update_texture_ingest() -> void;
+    auto report_texture_ingest(char const* how) -> void;
+    auto upload_model_texture(size_t index, Cooked_Texture source) -> void;
+    auto loaded_model_texture(Assimp_Model::Texture_Index index) const -> Model_Texture const*;
+    auto material_texture_index(int32_t material) const -> Assimp_Model::Texture_Index;
+    auto record_texture_upload(VkCommandBuffer command_buffer, VkBuffer buffer, VkImage image, Cooked_Texture const& texture, uint32_t first_level) -> void;
+    auto stream_textures() -> void;
+    auto replace_texture_levels(Cooked_Texture const& source, uint32_t old_first_level, uint32_t first_level, VkImage* image, VkDeviceMemory* image_memory) -> void;
+    auto destroy_model_buffers() -> void;
+    auto destroy_texture() -> void;
     auto create_vertex_buffer() -> void;
     auto create_index_buffer() -> void;
+    auto create_vertex_animation_resources() -> void;
     auto create_uniform_buffers() -> void;
     auto create_shader_storage_buffers() -> void;
     auto create_descriptor_pool() -> void;
     auto create_compute_descriptor_pool() -> void;
     auto create_descriptor_sets() -> void;
+    auto update_texture_descriptors() -> void;
+    auto create_material_descriptor_sets() -> void;
+    auto update_material_descriptors(uint32_t frame) -> void;
+    auto material_image_view(int32_t material) const -> VkImageView;
     auto create_compute_descriptor_sets() -> void;
     auto create_command_buffers() -> void;
     auto create_compute_command_buffers() -> void;
@@ -188,11 +499,19 @@ private:
 
     auto create_shader_module(std::vector<unsigned char> const& code) -> VkShaderModule;
     auto record_command_buffer(VkCommandBuffer command_buffer, uint32_t image_index) -> void;
+    auto select_model_lods() -> void;
     auto record_compute_command_buffer(VkCommandBuffer command_buffer) -> void;
     auto create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, VkDeviceMemory* buffer_memory) -> void;
+    auto create_device_local_buffer(void const* data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer* buffer, VkDeviceMemory* buffer_memory, VkDeviceSize capacity = 0) -> void;
     auto copy_buffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size) -> void;
-    auto copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) -> void;
+    auto copy_buffer_to_image(VkBuffer buffer, VkImage image, std::vector<VkBufferImageCopy> const& regions) -> void;
     auto update_uniform_buffer(uint32_t current_image) -> void;
+    auto update_animation() -> void;
+    auto update_bone_matrices(uint32_t current_image) -> void;
+    auto read_animation_time(uint32_t current_image) -> void;
+    auto update_morph_weights() -> void;
+    auto record_vertex_animation(VkCommandBuffer command_buffer) -> void;
+    auto animated() const -> bool { return !skin_vertices.empty() || !morph_vertices.empty(); }
     auto create_image(uint32_t width, uint32_t height, uint32_t mip_levels, VkSampleCountFlagBits num_samples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage* image, VkDeviceMemory* image_memory) -> void;
     auto create_image_view(VkImage image, VkFormat format, VkImageAspectFlags aspect_flags, uint32_t mip_levels) -> VkImageView;
     auto begin_single_time_commands() -> VkCommandBuffer;
@@ -201,6 +520,8 @@ private:
     auto find_depth_format() -> VkFormat;
     auto has_stencil_component(VkFormat format) -> bool;
     auto generate_mipmaps(VkImage image, VkFormat image_format, int32_t tex_width, int32_t tex_height, uint32_t mip_levels) -> void;
+    auto record_blit_mipmaps(VkCommandBuffer command_buffer, VkImage image, int32_t tex_width, int32_t tex_height, uint32_t mip_levels) -> uint32_t;
+    auto record_compute_mipmaps(VkCommandBuffer command_buffer, VkImage image, VkImage scratch_image, std::vector<VkImageView> const& scratch_views, int32_t tex_width, int32_t tex_height, uint32_t mip_levels) -> uint32_t;
 
     auto cleanup_swap_chain() -> void;
     auto recreate_swap_chain() -> void;
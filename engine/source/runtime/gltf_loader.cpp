@@ -0,0 +1,456 @@
+#include "gltf_loader.hpp"
+#include "mapped_file.hpp"
+#include "skinning.hpp"
+#include "mesh_processing.hpp"
+#include "thread_pool.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <fastgltf/parser.hpp>
+#include <fastgltf/tools.hpp>
+#include <fastgltf/glm_element_traits.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+
+inline namespace
+{
+    using Array_Index = Assimp_Model::Array_Index;
+    using Texture_Type = Assimp_Model::Texture_Type;
+
+    // Resolves every glTF buffer to the bytes it already lives in: the GLB chunk inside the
+    // parser's data buffer, a decoded data URI, or a memory mapped external file.
+    struct Buffer_Data_Adapter final
+    {
+        fastgltf::Asset const* asset{};
+        std::vector<std::byte const*> buffer_data;
+
+        auto operator()(fastgltf::Buffer const& buffer) const -> std::byte const*
+        {
+            return buffer_data[std::size_t(&buffer - asset->buffers.data())];
+        }
+    };
+
+    auto map_buffers(fastgltf::Asset const& asset, std::filesystem::path const& directory, std::vector<Mapped_File>& mapped_files) -> Buffer_Data_Adapter
+    {
+        auto adapter = Buffer_Data_Adapter{&asset, std::vector<std::byte const*>(asset.buffers.size(), nullptr)};
+        mapped_files.resize(asset.buffers.size());
+
+        for (auto i = (size_t) 0; i < asset.buffers.size(); i++) {
+            auto const& source = asset.buffers[i].data;
+            if (auto view = std::get_if<fastgltf::sources::ByteView>(&source)) {
+                adapter.buffer_data[i] = view->bytes.data();
+            } else if (auto vector = std::get_if<fastgltf::sources::Vector>(&source)) {
+                adapter.buffer_data[i] = reinterpret_cast<std::byte const*>(vector->bytes.data());
+            } else if (auto uri = std::get_if<fastgltf::sources::URI>(&source)) {
+                auto buffer_path = (directory / uri->uri.fspath()).string();
+                mapped_files[i] = Mapped_File{buffer_path};
+                if (!mapped_files[i].valid() || mapped_files[i].size() < uri->fileByteOffset + asset.buffers[i].byteLength) {
+                    throw std::runtime_error("failed to map glTF buffer: " + buffer_path);
+                }
+                adapter.buffer_data[i] = mapped_files[i].data() + uri->fileByteOffset;
+            } else {
+                throw std::runtime_error("unsupported glTF buffer source");
+            }
+        }
+
+        return adapter;
+    }
+
+    // Copies an accessor into a model stream. Matching layouts are a single memcpy; everything
+    // else, including normalized integers, is converted element by element.
+    template <typename T>
+    auto read_accessor(fastgltf::Asset const& asset, fastgltf::Accessor const& accessor, Buffer_Data_Adapter const& adapter, std::vector<T>& values) -> void
+    {
+        values.resize(accessor.count);
+        if (accessor.normalized) {
+            fastgltf::iterateAccessorWithIndex<T>(asset, accessor, [&] (T value, std::size_t index) {
+                values[index] = value;
+            }, adapter);
+        } else {
+            fastgltf::copyFromAccessor<T>(asset, accessor, values.data(), adapter);
+        }
+    }
+
+    auto node_transformation(fastgltf::Node const& node) -> glm::mat4
+    {
+        if (auto matrix = std::get_if<fastgltf::Node::TransformMatrix>(&node.transform)) {
+            auto result = glm::mat4{};
+            for (auto i = 0; i < 16; i++) glm::value_ptr(result)[i] = float((*matrix)[std::size_t(i)]);
+            return result;
+        }
+
+        auto const& trs = std::get<fastgltf::Node::TRS>(node.transform);
+        auto translation = glm::vec3{float(trs.translation[0]), float(trs.translation[1]), float(trs.translation[2])};
+        auto rotation = glm::quat{float(trs.rotation[3]), float(trs.rotation[0]), float(trs.rotation[1]), float(trs.rotation[2])};
+        auto scale = glm::vec3{float(trs.scale[0]), float(trs.scale[1]), float(trs.scale[2])};
+        return glm::translate(glm::mat4{1.0f}, translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4{1.0f}, scale);
+    }
+
+    // External images keep their relative path; embedded ones use Assimp's "*<index>" convention.
+    auto texture_path(fastgltf::Asset const& asset, std::size_t texture_index) -> std::string
+    {
+        auto const& texture = asset.textures[texture_index];
+        if (!texture.imageIndex) return {};
+
+        auto image_index = *texture.imageIndex;
+        if (auto uri = std::get_if<fastgltf::sources::URI>(&asset.images[image_index].data)) {
+            return std::string{uri->uri.path()};
+        }
+        return "*" + std::to_string(image_index);
+    }
+
+    auto load_materials(fastgltf::Asset const& asset, Assimp_Model& model) -> void
+    {
+        model.materials.resize(asset.materials.size());
+        auto interner = Texture_Interner{model.textures};
+
+        for (auto i = (size_t) 0; i < asset.materials.size(); i++) {
+            auto const& src = asset.materials[i];
+            auto& material = model.materials[i];
+
+            auto const& base_color = src.pbrData.baseColorFactor;
+            material.diffuse_color = glm::vec4{float(base_color[0]), float(base_color[1]), float(base_color[2]), float(base_color[3])};
+            material.emissive_color = glm::vec4{float(src.emissiveFactor[0]), float(src.emissiveFactor[1]), float(src.emissiveFactor[2]), 1.0f};
+            material.opacity = float(base_color[3]);
+            material.shininess = 0.0f;
+            material.name = src.name.empty() ? "material" + std::to_string(i) : std::string{src.name};
+
+            auto add_texture = [&] (Texture_Type type, std::size_t texture_index) {
+                auto path = texture_path(asset, texture_index);
+                if (path.empty()) return;
+                material.textures[std::size_t(type)] = interner.intern(path);
+            };
+
+            // Same slots the Assimp glTF importer fills.
+            if (auto const& info = src.pbrData.baseColorTexture) {
+                add_texture(Texture_Type::base_color, info->textureIndex);
+                add_texture(Texture_Type::diffuse, info->textureIndex);
+            }
+            if (auto const& info = src.pbrData.metallicRoughnessTexture) {
+                add_texture(Texture_Type::metalness, info->textureIndex);
+                add_texture(Texture_Type::diffuse_roughness, info->textureIndex);
+            }
+            if (auto const& info = src.normalTexture) add_texture(Texture_Type::normal, info->textureIndex);
+            if (auto const& info = src.occlusionTexture) add_texture(Texture_Type::ambient_occlusion, info->textureIndex);
+            if (auto const& info = src.emissiveTexture) add_texture(Texture_Type::emissive, info->textureIndex);
+        }
+    }
+
+    struct Primitive_Slot final
+    {
+        std::size_t mesh{};
+        std::size_t primitive{};
+    };
+
+    // Bones take the joint names and inverse bind matrices of the skin; their nodes are bound
+    // once the hierarchy exists.
+    auto load_skin(fastgltf::Asset const& asset, fastgltf::Skin const& skin, Buffer_Data_Adapter const& adapter, Assimp_Model::Mesh& mesh) -> void
+    {
+        auto inverse_bind = std::vector<glm::mat4>(skin.joints.size(), glm::mat4{1.0f});
+        if (skin.inverseBindMatrices) {
+            read_accessor(asset, asset.accessors[*skin.inverseBindMatrices], adapter, inverse_bind);
+            inverse_bind.resize(skin.joints.size(), glm::mat4{1.0f});
+        }
+
+        mesh.bones.reserve(skin.joints.size());
+        for (auto j = (size_t) 0; j < skin.joints.size(); j++) {
+            mesh.bones.push_back({Array_Index(-1), inverse_bind[j], std::string{asset.nodes[skin.joints[j]].name}});
+        }
+    }
+
+    auto load_primitive(fastgltf::Asset const& asset, fastgltf::Primitive const& primitive, Buffer_Data_Adapter const& adapter, Assimp_Model::Mesh& mesh) -> void
+    {
+        auto attribute = [&] (std::string_view name) -> fastgltf::Accessor const* {
+            auto it = primitive.findAttribute(name);
+            return it == primitive.attributes.end() ? nullptr : &asset.accessors[it->second];
+        };
+
+        auto& vertex_info = mesh.vertex_info;
+        if (auto accessor = attribute("POSITION")) read_accessor(asset, *accessor, adapter, vertex_info.position);
+        if (auto accessor = attribute("NORMAL")) read_accessor(asset, *accessor, adapter, vertex_info.normal);
+        if (auto accessor = attribute("TEXCOORD_0")) read_accessor(asset, *accessor, adapter, vertex_info.texcoord);
+
+        if (auto accessor = attribute("COLOR_0")) {
+            if (accessor->type == fastgltf::AccessorType::Vec3) {
+                auto color = std::vector<glm::vec3>{};
+                read_accessor(asset, *accessor, adapter, color);
+                vertex_info.color.reserve(color.size());
+                for (auto const& c: color) vertex_info.color.emplace_back(c, 1.0f);
+            } else {
+                read_accessor(asset, *accessor, adapter, vertex_info.color);
+            }
+        }
+
+        // glTF stores the bitangent sign in tangent.w.
+        if (auto accessor = attribute("TANGENT")) {
+            auto tangent = std::vector<glm::vec4>{};
+            read_accessor(asset, *accessor, adapter, tangent);
+            vertex_info.tangent.reserve(tangent.size());
+            for (auto const& t: tangent) vertex_info.tangent.emplace_back(t);
+            if (vertex_info.normal.size() == tangent.size()) {
+                vertex_info.bitangent.reserve(tangent.size());
+                for (auto v = (size_t) 0; v < tangent.size(); v++) {
+                    vertex_info.bitangent.emplace_back(glm::cross(vertex_info.normal[v], glm::vec3{tangent[v]}) * tangent[v].w);
+                }
+            }
+        }
+
+        auto joints_accessor = attribute("JOINTS_0");
+        auto weights_accessor = attribute("WEIGHTS_0");
+        if (!mesh.bones.empty() && joints_accessor && weights_accessor) {
+            auto joints = std::vector<glm::u16vec4>{};
+            auto joint_weights = std::vector<glm::vec4>{};
+            read_accessor(asset, *joints_accessor, adapter, joints);
+            read_accessor(asset, *weights_accessor, adapter, joint_weights);
+
+            auto weights = std::vector<Bone_Weight>{};
+            weights.reserve(joints.size() * max_bone_influences);
+            for (auto v = (size_t) 0; v < std::min(joints.size(), joint_weights.size()); v++) {
+                for (auto i = 0; i < 4; i++) {
+                    weights.push_back({std::uint32_t(v), std::uint32_t(joints[v][i]), joint_weights[v][i]});
+                }
+            }
+            pack_bone_influences(mesh, weights);
+        } else {
+            mesh.bones.clear();
+        }
+
+        // Morph targets are delta accessors, dense or sparse; one key per target keeps the
+        // key order in line with the mesh weights.
+        mesh.shape_keys.reserve(primitive.targets.size());
+        for (auto t = (size_t) 0; t < primitive.targets.size(); t++) {
+            auto position_deltas = std::vector<glm::vec3>{};
+            auto position_it = primitive.findTargetAttribute(t, "POSITION");
+            if (position_it != primitive.targets[t].cend()) read_accessor(asset, asset.accessors[position_it->second], adapter, position_deltas);
+
+            mesh.shape_keys.emplace_back(make_shape_key(position_deltas));
+            mesh.shape_keys.back().name = "shape" + std::to_string(t);
+        }
+
+        auto vertex_count = vertex_info.position.size();
+        if (primitive.indicesAccessor) {
+            auto const& accessor = asset.accessors[*primitive.indicesAccessor];
+            // copyFromAccessor writes every index, so a partial triangle would land past the end.
+            if (accessor.count % 3 != 0) {
+                throw std::runtime_error("glTF triangle list with " + std::to_string(accessor.count) + " indices in mesh " + mesh.name);
+            }
+            mesh.topology.resize(accessor.count / 3);
+            // Triangle is three packed uint32, so the index list lands in the topology directly.
+            static_assert(sizeof(Assimp_Model::Mesh::Triangle) == 3 * sizeof(std::uint32_t));
+            if (!mesh.topology.empty()) fastgltf::copyFromAccessor<std::uint32_t>(asset, accessor, mesh.topology.data(), adapter);
+        } else {
+            mesh.topology.resize(vertex_count / 3);
+            for (auto t = (size_t) 0; t < mesh.topology.size(); t++) {
+                auto first = std::uint32_t(t * 3);
+                mesh.topology[t] = {first, first + 1, first + 2};
+            }
+        }
+
+        for (auto const& triangle: mesh.topology) {
+            if (triangle.a >= vertex_count || triangle.b >= vertex_count || triangle.c >= vertex_count) {
+                throw std::runtime_error("glTF primitive index out of range in mesh " + mesh.name);
+            }
+        }
+    }
+
+    // Level-order walk below a synthetic root, which stands in for Assimp's scene root node.
+    // Returns the model node of every glTF node, -1 for nodes outside the scene.
+    auto load_hierarchy(fastgltf::Asset const& asset, std::vector<std::vector<std::size_t>> const& mesh_slots, Assimp_Model& model) -> std::vector<Array_Index>
+    {
+        auto roots = std::vector<std::size_t>{};
+        if (!asset.scenes.empty()) {
+            auto const& scene = asset.scenes[asset.defaultScene ? *asset.defaultScene : 0];
+            roots.assign(scene.nodeIndices.begin(), scene.nodeIndices.end());
+        } else {
+            auto has_parent = std::vector<bool>(asset.nodes.size(), false);
+            for (auto const& node: asset.nodes) {
+                for (auto child: node.children) has_parent[child] = true;
+            }
+            for (auto i = (size_t) 0; i < asset.nodes.size(); i++) {
+                if (!has_parent[i]) roots.emplace_back(i);
+            }
+        }
+
+        model.nodes.push_back({-1, glm::mat4{1.0f}, "root"});
+
+        auto next_node_name_id = 0;
+        auto node_map = std::vector<Array_Index>(asset.nodes.size(), Array_Index(-1));
+        auto pending = std::deque<std::pair<std::size_t, Array_Index>>{};
+        for (auto root: roots) pending.emplace_back(root, 0);
+
+        while (!pending.empty()) {
+            auto [gltf_index, parent] = pending.front();
+            pending.pop_front();
+
+            auto const& node = asset.nodes[gltf_index];
+            auto node_index = Array_Index(model.nodes.size());
+            node_map[gltf_index] = node_index;
+
+            if (node.meshIndex) {
+                for (auto slot: mesh_slots[*node.meshIndex]) model.meshes[slot].parent = node_index;
+            }
+            for (auto child: node.children) pending.emplace_back(child, node_index);
+
+            auto name = node.name.empty() ? "node" + std::to_string(next_node_name_id++) : std::string{node.name};
+            model.nodes.push_back({parent, node_transformation(node), std::move(name)});
+        }
+
+        return node_map;
+    }
+
+    // Channels targeting the same node share one Animation::Channel. Step and cubic spline
+    // samplers are read as linear ones through their keyframe values; morph weights are skipped.
+    auto load_animations(fastgltf::Asset const& asset, Buffer_Data_Adapter const& adapter, std::vector<Array_Index> const& node_map, Assimp_Model& model) -> void
+    {
+        model.animations.resize(asset.animations.size());
+        for (auto a = (size_t) 0; a < asset.animations.size(); a++) {
+            auto const& src = asset.animations[a];
+            auto& animation = model.animations[a];
+            animation.name = src.name.empty() ? "animation" + std::to_string(a) : std::string{src.name};
+
+            auto channel_of_node = std::unordered_map<Array_Index, std::size_t>{};
+            for (auto const& src_channel: src.channels) {
+                if (src_channel.path == fastgltf::AnimationPath::Weights || node_map[src_channel.nodeIndex] < 0) continue;
+
+                auto node = node_map[src_channel.nodeIndex];
+                auto [slot, inserted] = channel_of_node.emplace(node, animation.channels.size());
+                if (inserted) {
+                    auto new_channel = Assimp_Model::Animation::Channel{};
+                    new_channel.node = node;
+                    animation.channels.push_back(std::move(new_channel));
+                }
+                auto& channel = animation.channels[slot->second];
+
+                auto const& sampler = src.samplers[src_channel.samplerIndex];
+                auto times = std::vector<float>{};
+                read_accessor(asset, asset.accessors[sampler.inputAccessor], adapter, times);
+                if (!times.empty()) animation.duration = std::max(animation.duration, times.back());
+
+                // Cubic splines store in-tangent, value and out-tangent per key; only the value is kept.
+                auto keep_values = [&] (auto& values) {
+                    if (sampler.interpolation != fastgltf::AnimationInterpolation::CubicSpline) return;
+                    for (auto k = (size_t) 0; k * 3 + 1 < values.size(); k++) values[k] = values[k * 3 + 1];
+                    values.resize(values.size() / 3);
+                };
+
+                auto const& output = asset.accessors[sampler.outputAccessor];
+                if (src_channel.path == fastgltf::AnimationPath::Rotation) {
+                    auto values = std::vector<glm::vec4>{};
+                    read_accessor(asset, output, adapter, values);
+                    keep_values(values);
+                    values.resize(std::min(values.size(), times.size()));
+                    channel.rotation_times.assign(times.begin(), times.begin() + std::ptrdiff_t(values.size()));
+                    channel.rotations.reserve(values.size());
+                    for (auto const& q: values) channel.rotations.emplace_back(q.w, q.x, q.y, q.z);
+                } else {
+                    auto values = std::vector<glm::vec3>{};
+                    read_accessor(asset, output, adapter, values);
+                    keep_values(values);
+                    values.resize(std::min(values.size(), times.size()));
+                    auto translation = src_channel.path == fastgltf::AnimationPath::Translation;
+                    (translation ? channel.translation_times : channel.scale_times).assign(times.begin(), times.begin() + std::ptrdiff_t(values.size()));
+                    (translation ? channel.translations : channel.scales) = std::move(values);
+                }
+            }
+        }
+    }
+}
+
+auto is_gltf_path(std::string const& path) -> bool
+{
+    auto extension = std::filesystem::path{path}.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [] (unsigned char c) { return char(std::tolower(c)); });
+    return extension == ".gltf" || extension == ".glb";
+}
+
+auto import_gltf(std::string const& path, Thread_Pool* thread_pool) -> Assimp_Model
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    // Parsed where it is mapped, with the padding simdjson wants behind it, so a GLB binary chunk
+    // is never read into memory. Should the file not map that way, fastgltf reads it in once.
+    auto padding = fastgltf::getGltfBufferPadding();
+    auto file = Mapped_File{path, padding};
+    auto data = fastgltf::GltfDataBuffer{};
+    auto viewed = file.writable_data() != nullptr
+        && data.fromByteView(reinterpret_cast<std::uint8_t*>(file.writable_data()), file.size(), file.size() + padding);
+    if (!viewed && !data.loadFromFile(path)) {
+        throw std::runtime_error("failed to open model file: " + path);
+    }
+
+    auto parse_start = Clock::now();
+    auto directory = std::filesystem::path{path}.parent_path();
+    auto parser = fastgltf::Parser{};
+    auto type = fastgltf::determineGltfFileType(&data);
+    // Neither LoadGLBBuffers nor LoadExternalBuffers: both would copy the buffers into vectors.
+    auto loaded = type == fastgltf::GltfType::GLB ? parser.loadBinaryGLTF(&data, directory) : parser.loadGLTF(&data, directory);
+    if (loaded.error() != fastgltf::Error::None) {
+        throw std::runtime_error("failed to parse glTF " + path + ": " + std::string{fastgltf::getErrorMessage(loaded.error())});
+    }
+    auto& asset = loaded.get();
+
+    auto mapped_files = std::vector<Mapped_File>{};
+    auto adapter = map_buffers(asset, directory, mapped_files);
+    auto parse_ms = std::chrono::duration<double, std::milli>(Clock::now() - parse_start).count();
+
+    auto model = Assimp_Model{};
+    auto extract_start = Clock::now();
+    load_materials(asset, model);
+
+    auto slots = std::vector<Primitive_Slot>{};
+    auto mesh_slots = std::vector<std::vector<std::size_t>>(asset.meshes.size());
+    for (auto m = (size_t) 0; m < asset.meshes.size(); m++) {
+        for (auto p = (size_t) 0; p < asset.meshes[m].primitives.size(); p++) {
+            if (asset.meshes[m].primitives[p].type != fastgltf::PrimitiveType::Triangles) {
+                std::cout << "Skipping non-triangle primitive " << p << " of glTF mesh " << m << std::endl;
+                continue;
+            }
+            mesh_slots[m].emplace_back(slots.size());
+            slots.push_back({m, p});
+        }
+    }
+
+    // A skin belongs to the node instancing a mesh; the first skinned instance decides.
+    auto mesh_skins = std::vector<std::optional<std::size_t>>(asset.meshes.size());
+    for (auto const& node: asset.nodes) {
+        if (node.meshIndex && node.skinIndex && !mesh_skins[*node.meshIndex]) mesh_skins[*node.meshIndex] = *node.skinIndex;
+    }
+
+    model.meshes.resize(slots.size());
+    for_each_index(thread_pool, slots.size(), [&] (std::size_t i) {
+        auto const& src = asset.meshes[slots[i].mesh];
+        auto const& primitive = src.primitives[slots[i].primitive];
+        auto& mesh = model.meshes[i];
+
+        mesh.name = src.name.empty() ? "mesh" + std::to_string(i) : std::string{src.name};
+        if (primitive.materialIndex) mesh.material = Array_Index(*primitive.materialIndex);
+        if (auto skin = mesh_skins[slots[i].mesh]) load_skin(asset, asset.skins[*skin], adapter, mesh);
+        load_primitive(asset, primitive, adapter, mesh);
+        for (auto t = (size_t) 0; t < std::min(mesh.shape_keys.size(), src.weights.size()); t++) {
+            mesh.shape_keys[t].default_weight = float(src.weights[t]);
+        }
+    });
+
+    auto node_map = load_hierarchy(asset, mesh_slots, model);
+    for (auto i = (size_t) 0; i < slots.size(); i++) {
+        auto skin = mesh_skins[slots[i].mesh];
+        auto& bones = model.meshes[i].bones;
+        for (auto j = (size_t) 0; j < bones.size(); j++) bones[j].node = node_map[asset.skins[*skin].joints[j]];
+    }
+    load_animations(asset, adapter, node_map, model);
+    auto extract_ms = std::chrono::duration<double, std::milli>(Clock::now() - extract_start).count();
+
+    std::cout << "Parsed glTF in " << parse_ms << " ms, extracted " << model.meshes.size() << " meshes and "
+              << model.materials.size() << " materials in " << extract_ms << " ms on "
+              << (thread_pool ? thread_pool->size() + 1 : 1) << " thread(s)" << std::endl;
+    return model;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "loader.hpp"
+
+// Whether path names a glTF 2.0 file, .gltf or .glb, that import_gltf reads.
+auto is_gltf_path(std::string const& path) -> bool;
+
+// Imports a glTF 2.0 / GLB file through fastgltf, straight from its buffer views. The file itself
+// and external buffers are memory mapped and the GLB binary chunk is read where it is mapped, so
+// vertex and index data is copied exactly once, into the model; accessors already laid out like
+// the model streams are copied in bulk. Only where the file can not be mapped with padding behind
+// it (see Mapped_File) is it read into memory once first. Every primitive becomes one Mesh, as with the Assimp importer.
+auto import_gltf(std::string const& path, Thread_Pool* thread_pool) -> Assimp_Model;
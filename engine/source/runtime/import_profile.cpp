@@ -0,0 +1,149 @@
+#include "import_profile.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+inline namespace
+{
+    auto const post_process_steps = std::vector<std::pair<char const*, unsigned int>>{
+        { "CalcTangentSpace",         aiProcess_CalcTangentSpace },
+        { "JoinIdenticalVertices",    aiProcess_JoinIdenticalVertices },
+        { "MakeLeftHanded",           aiProcess_MakeLeftHanded },
+        { "Triangulate",              aiProcess_Triangulate },
+        { "RemoveComponent",          aiProcess_RemoveComponent },
+        { "GenNormals",               aiProcess_GenNormals },
+        { "GenSmoothNormals",         aiProcess_GenSmoothNormals },
+        { "SplitLargeMeshes",         aiProcess_SplitLargeMeshes },
+        { "PreTransformVertices",     aiProcess_PreTransformVertices },
+        { "LimitBoneWeights",         aiProcess_LimitBoneWeights },
+        { "ValidateDataStructure",    aiProcess_ValidateDataStructure },
+        { "ImproveCacheLocality",     aiProcess_ImproveCacheLocality },
+        { "RemoveRedundantMaterials", aiProcess_RemoveRedundantMaterials },
+        { "FixInfacingNormals",       aiProcess_FixInfacingNormals },
+        { "PopulateArmatureData",     aiProcess_PopulateArmatureData },
+        { "SortByPType",              aiProcess_SortByPType },
+        { "FindDegenerates",          aiProcess_FindDegenerates },
+        { "FindInvalidData",          aiProcess_FindInvalidData },
+        { "GenUVCoords",              aiProcess_GenUVCoords },
+        { "TransformUVCoords",        aiProcess_TransformUVCoords },
+        { "FindInstances",            aiProcess_FindInstances },
+        { "OptimizeMeshes",           aiProcess_OptimizeMeshes },
+        { "OptimizeGraph",            aiProcess_OptimizeGraph },
+        { "FlipUVs",                  aiProcess_FlipUVs },
+        { "FlipWindingOrder",         aiProcess_FlipWindingOrder },
+        { "SplitByBoneCount",         aiProcess_SplitByBoneCount },
+        { "Debone",                   aiProcess_Debone },
+        { "GlobalScale",              aiProcess_GlobalScale },
+        { "EmbedTextures",            aiProcess_EmbedTextures },
+        { "ForceGenNormals",          aiProcess_ForceGenNormals },
+        { "DropNormals",              aiProcess_DropNormals },
+        { "GenBoundingBoxes",         aiProcess_GenBoundingBoxes },
+    };
+
+    auto trim(std::string const& text) -> std::string
+    {
+        auto is_space = [] (unsigned char c) { return std::isspace(c) != 0; };
+        auto first = std::find_if_not(text.begin(), text.end(), is_space);
+        auto last = std::find_if_not(text.rbegin(), text.rend(), is_space).base();
+        return first < last ? std::string{first, last} : std::string{};
+    }
+
+    // Every "key = value" line as "section.key"; blank lines and ; or # comments are skipped.
+    auto read_ini(std::string const& path) -> std::unordered_map<std::string, std::string>
+    {
+        auto values = std::unordered_map<std::string, std::string>{};
+        auto file = std::ifstream{path};
+        auto section = std::string{};
+
+        for (auto line = std::string{}; std::getline(file, line);) {
+            line = trim(line);
+            if (line.empty() || line[0] == ';' || line[0] == '#') continue;
+
+            if (line.front() == '[' && line.back() == ']') {
+                section = trim(line.substr(1, line.size() - 2));
+                continue;
+            }
+
+            auto separator = line.find('=');
+            if (separator == std::string::npos) continue;
+            values[section + "." + trim(line.substr(0, separator))] = trim(line.substr(separator + 1));
+        }
+
+        return values;
+    }
+
+    auto parse_post_process(std::string const& steps) -> unsigned int
+    {
+        auto flags = 0u;
+        for (auto first = (size_t) 0; first < steps.size();) {
+            auto last = std::min(steps.find(',', first), steps.size());
+            auto name = trim(steps.substr(first, last - first));
+            first = last + 1;
+            if (name.empty()) continue;
+
+            auto step = std::find_if(post_process_steps.begin(), post_process_steps.end(), [&] (auto const& entry) { return name == entry.first; });
+            if (step == post_process_steps.end()) {
+                throw std::runtime_error("failed to parse import profile: unknown post-process step " + name + "!");
+            }
+            flags |= step->second;
+        }
+        return flags;
+    }
+}
+
+auto builtin_import_profiles() -> std::vector<Import_Profile>
+{
+    auto const fast_preview = aiProcess_FlipUVs | aiProcess_Triangulate | aiProcess_SortByPType | aiProcess_GenNormals;
+    // Normals and tangents come from generate_tangent_frames(), in parallel after the import.
+    auto const ship_quality = (fast_preview & ~aiProcess_GenNormals)
+        | aiProcess_JoinIdenticalVertices | aiProcess_ImproveCacheLocality
+        | aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph | aiProcess_RemoveRedundantMaterials | aiProcess_FindInvalidData;
+
+    return {
+        { "minimal",      aiProcess_FlipUVs },
+        { "fast-preview", static_cast<unsigned int>(fast_preview) },
+        { "ship-quality", static_cast<unsigned int>(ship_quality) },
+    };
+}
+
+auto load_import_profile(std::string const& config_path) -> Import_Profile
+{
+    auto config = read_ini(config_path);
+    auto profiles = builtin_import_profiles();
+
+    auto const prefix = std::string{"import_profile."};
+    auto const suffix = std::string{".steps"};
+    for (auto const& entry: config) {
+        auto const& key = entry.first;
+        if (key.size() <= prefix.size() + suffix.size() || key.compare(0, prefix.size(), prefix) != 0 || key.compare(key.size() - suffix.size(), suffix.size(), suffix) != 0) continue;
+
+        auto name = key.substr(prefix.size(), key.size() - prefix.size() - suffix.size());
+        auto profile = std::find_if(profiles.begin(), profiles.end(), [&] (Import_Profile const& p) { return p.name == name; });
+        if (profile == profiles.end()) profile = profiles.insert(profiles.end(), Import_Profile{name});
+        profile->post_process = parse_post_process(entry.second);
+    }
+
+    auto selected = config.find("import.profile");
+    if (selected == config.end()) return profiles.front();
+
+    auto profile = std::find_if(profiles.begin(), profiles.end(), [&] (Import_Profile const& p) { return p.name == selected->second; });
+    if (profile == profiles.end()) {
+        throw std::runtime_error("failed to load import profile: unknown profile " + selected->second + " in " + config_path + "!");
+    }
+    return *profile;
+}
+
+auto describe_post_process(unsigned int post_process) -> std::string
+{
+    auto description = std::string{};
+    for (auto const& step: post_process_steps) {
+        if ((post_process & step.second) == 0) continue;
+        if (!description.empty()) description += ", ";
+        description += step.first;
+    }
+    return description;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <assimp/postprocess.h>
+
+#include <string>
+#include <vector>
+
+// A named set of Assimp post-processing steps (aiPostProcessSteps) the Assimp importer runs.
+// The glTF importer reads its files as they are and ignores the steps.
+struct Import_Profile final
+{
+    std::string name{"minimal"};
+    unsigned int post_process{aiProcess_FlipUVs};   // all the renderer itself relies on
+};
+
+// Built in profiles:
+//   minimal       FlipUVs only
+//   fast-preview  adds Triangulate, SortByPType and flat normals: cheap imports, unoptimized meshes
+//   ship-quality  drops the flat normals and adds vertex joining, mesh and graph optimization and
+//                 cache locality: slow imports, fewer draws and vertices at runtime. Smooth normals
+//                 and tangents are generated in-engine instead, see tangent_frames.hpp
+auto builtin_import_profiles() -> std::vector<Import_Profile>;
+
+// Reads the [import] profile entry of an ini file. Profiles may also be defined there, as a
+// [import_profile.<name>] section whose steps entry lists aiProcess_ names without the prefix,
+// which overrides a built in profile of the same name. A missing file or entry yields minimal;
+// unknown profile or step names throw.
+auto load_import_profile(std::string const& config_path) -> Import_Profile;
+
+// The step names set in post_process, comma separated.
+auto describe_post_process(unsigned int post_process) -> std::string;
@@ -1,4 +1,16 @@
 #include "loader.hpp"
+#include "asset_archive.hpp"
+#include "bounds.hpp"
+#include "model_cache.hpp"
+#include "mesh_processing.hpp"
+#include "mesh_optimizer.hpp"
+#include "meshlet_builder.hpp"
+#include "mesh_simplifier.hpp"
+#include "gltf_loader.hpp"
+#include "mapped_io.hpp"
+#include "skinning.hpp"
+#include "tangent_frames.hpp"
+#include "thread_pool.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -8,32 +20,37 @@
 #include <assimp/scene.h>
 #include <assimp/config.h>
 
-#include <deque>
 #include <stdexcept>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
 
 inline namespace
 {
-    auto tex_type_to_assimp = std::unordered_map<Assimp_Model::Texture_Type, aiTextureType>{
-        { Assimp_Model::Texture_Type::unknown,           aiTextureType::aiTextureType_UNKNOWN },
-        { Assimp_Model::Texture_Type::diffuse,           aiTextureType::aiTextureType_DIFFUSE },
-        { Assimp_Model::Texture_Type::specular,          aiTextureType::aiTextureType_SPECULAR },
-        { Assimp_Model::Texture_Type::ambient,           aiTextureType::aiTextureType_AMBIENT },
-        { Assimp_Model::Texture_Type::opacity,           aiTextureType::aiTextureType_OPACITY },
-        { Assimp_Model::Texture_Type::height,            aiTextureType::aiTextureType_HEIGHT },
-        { Assimp_Model::Texture_Type::emissive,          aiTextureType::aiTextureType_EMISSIVE },
-        { Assimp_Model::Texture_Type::normal,            aiTextureType::aiTextureType_NORMALS },
-        { Assimp_Model::Texture_Type::shininess,         aiTextureType::aiTextureType_SHININESS },
-        { Assimp_Model::Texture_Type::displacement,      aiTextureType::aiTextureType_DISPLACEMENT },
-        { Assimp_Model::Texture_Type::reflection,        aiTextureType::aiTextureType_REFLECTION },
-        { Assimp_Model::Texture_Type::lightmap,          aiTextureType::aiTextureType_LIGHTMAP },
-        { Assimp_Model::Texture_Type::base_color,        aiTextureType::aiTextureType_BASE_COLOR },
-        { Assimp_Model::Texture_Type::normal_camera,     aiTextureType::aiTextureType_NORMAL_CAMERA },
-        { Assimp_Model::Texture_Type::emission_color,    aiTextureType::aiTextureType_EMISSION_COLOR },
-        { Assimp_Model::Texture_Type::metalness,         aiTextureType::aiTextureType_METALNESS },
-        { Assimp_Model::Texture_Type::diffuse_roughness, aiTextureType::aiTextureType_DIFFUSE_ROUGHNESS },
-        { Assimp_Model::Texture_Type::ambient_occlusion, aiTextureType::aiTextureType_AMBIENT_OCCLUSION }
+    // Indexed by Assimp_Model::Texture_Type.
+    auto const tex_type_to_assimp = std::array<aiTextureType, Assimp_Model::texture_type_count>{
+        aiTextureType::aiTextureType_UNKNOWN,
+        aiTextureType::aiTextureType_DIFFUSE,
+        aiTextureType::aiTextureType_SPECULAR,
+        aiTextureType::aiTextureType_AMBIENT,
+        aiTextureType::aiTextureType_OPACITY,
+        aiTextureType::aiTextureType_HEIGHT,
+        aiTextureType::aiTextureType_EMISSIVE,
+        aiTextureType::aiTextureType_NORMALS,
+        aiTextureType::aiTextureType_SHININESS,
+        aiTextureType::aiTextureType_DISPLACEMENT,
+        aiTextureType::aiTextureType_REFLECTION,
+        aiTextureType::aiTextureType_LIGHTMAP,
+        aiTextureType::aiTextureType_BASE_COLOR,
+        aiTextureType::aiTextureType_NORMAL_CAMERA,
+        aiTextureType::aiTextureType_EMISSION_COLOR,
+        aiTextureType::aiTextureType_METALNESS,
+        aiTextureType::aiTextureType_DIFFUSE_ROUGHNESS,
+        aiTextureType::aiTextureType_AMBIENT_OCCLUSION,
     };
 
     auto from_assimp(::aiMatrix4x4 m) -> glm::mat4
@@ -56,214 +73,730 @@ inline namespace
         return { q.w, q.x, q.y, q.z };
     }
 
-}
+    // Assimp's post-processing steps in the order it runs them, for a build with none of them
+    // disabled. The progress handler only reports step indices into this list.
+    auto const post_process_step_names = std::vector<char const*>{
+        "MakeLeftHanded", "FlipUVs", "FlipWindingOrder", "RemoveVC", "RemoveRedundantMaterials", "EmbedTextures",
+        "FindInstances", "OptimizeGraph", "GenUVCoords", "TransformUVCoords", "GlobalScale", "PopulateArmatureData",
+        "PreTransformVertices", "Triangulate", "FindDegenerates", "SortByPType", "FindInvalidData", "OptimizeMeshes",
+        "FixInfacingNormals", "SplitByBoneCount", "SplitLargeMeshes (triangles)", "DropNormals", "GenNormals",
+        "ComputeSpatialSort", "GenSmoothNormals", "CalcTangentSpace", "JoinIdenticalVertices", "DestroySpatialSort",
+        "SplitLargeMeshes (vertices)", "Debone", "LimitBoneWeights", "ImproveCacheLocality", "GenBoundingBoxes",
+    };
 
-auto load_model(std::string path) -> Assimp_Model
-{
-    using Array_Index = Assimp_Model::Array_Index;
-    using Node_Address_To_Index = std::unordered_map<std::string, Array_Index>;
+    // Timestamps every progress callback of one ReadFile: the file read, then every registered
+    // post-processing step, active or not. A step's time is the gap to the next callback.
+    class Step_Timer final: public Assimp::ProgressHandler
+    {
+    public:
+        using Clock = std::chrono::high_resolution_clock;
 
-    std::cout << "Loading model..." << std::endl;
+        auto Update(float) -> bool override { return true; }
 
-    Assimp::Importer importer;
-    //TODO: set postprocessing step
-    auto post_process = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
-    auto scene = importer.ReadFile(path, aiProcess_FlipUVs);
+        auto UpdateFileRead(int current_step, int) -> void override
+        {
+            (current_step == 0 ? read_start : read_end) = Clock::now();
+        }
 
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-    {
-        throw std::runtime_error(importer.GetErrorString());
-    }
+        auto UpdatePostProcess(int current_step, int step_count) -> void override
+        {
+            steps.resize(std::size_t(step_count) + 1);
+            steps[std::size_t(current_step)] = Clock::now();
+        }
 
-    auto copy_into_shape_if_exists = [] (auto mesh, auto& shape) {
-        auto copy_if_exists = [&] (auto src, auto& dst) {
-            static_assert(sizeof(src[0]) == sizeof(dst[0]), "Unsupported platform.");
+        // Read and preprocessing times, then every step that took measurable time.
+        auto report(std::ostream& out) const -> void
+        {
+            auto ms = [] (Clock::time_point from, Clock::time_point to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
 
-            if (src == nullptr || mesh->mNumVertices == 0)
+            out << "Assimp read " << ms(read_start, read_end) << " ms";
+            if (steps.empty()) {
+                out << std::endl;
                 return;
+            }
+            out << ", preprocess " << ms(read_end, steps.front()) << " ms";
 
-            dst.resize(std::size_t(mesh->mNumVertices));
-            std::copy_n(
-                reinterpret_cast<char const*>(src),
-                std::size_t(mesh->mNumVertices) * sizeof(src[0]),
-                reinterpret_cast<char*>(dst.data())
-            );
-        };
+            auto named = steps.size() - 1 == post_process_step_names.size();
+            for (auto step = (size_t) 0; step + 1 < steps.size(); step++) {
+                auto step_ms = ms(steps[step], steps[step + 1]);
+                if (step_ms < 0.01) continue;
+                out << ", " << (named ? std::string{post_process_step_names[step]} : "step " + std::to_string(step)) << " " << step_ms << " ms";
+            }
+            out << ", post-process total " << ms(steps.front(), steps.back()) << " ms" << std::endl;
+        }
 
-        auto copy_if_exists_to_2d = [&] (auto src, auto& dst) {
-            if (src == nullptr || mesh->mNumVertices == 0)
-                return;
+    private:
+        Clock::time_point read_start{};
+        Clock::time_point read_end{};
+        std::vector<Clock::time_point> steps{};     // one per step plus the end of the last
+    };
 
-            dst.reserve(std::size_t(mesh->mNumVertices));
-            for (auto last=src+mesh->mNumVertices; src!=last; src++)
-                dst.emplace_back(src->x, src->y);
-        };
+    // io_system replaces Assimp's default IO when set.
+    auto import_model(std::string const& path, unsigned int read_flags, Thread_Pool* thread_pool, Assimp::IOSystem* io_system = nullptr) -> Assimp_Model
+    {
+        using Array_Index = Assimp_Model::Array_Index;
+
+        // The importer owns and deletes its progress handler and IO system.
+        Assimp::Importer importer;
+        auto step_timer = new Step_Timer{};
+        importer.SetProgressHandler(step_timer);
+        if (io_system) importer.SetIOHandler(io_system);
+        auto scene = importer.ReadFile(path, read_flags);
+
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        {
+            throw std::runtime_error(importer.GetErrorString());
+        }
+        step_timer->report(std::cout);
 
-        copy_if_exists(mesh->mVertices, shape.position);
-        copy_if_exists(mesh->mNormals, shape.normal);
-        copy_if_exists(mesh->mTangents, shape.tangent);
-        copy_if_exists(mesh->mBitangents, shape.bitangent);
-        copy_if_exists_to_2d(mesh->mTextureCoords[0], shape.texcoord);
-        copy_if_exists(mesh->mColors[0], shape.color);
-    };
+        auto copy_into_shape_if_exists = [] (auto mesh, auto& shape) {
+            auto copy_if_exists = [&] (auto src, auto& dst) {
+                static_assert(sizeof(src[0]) == sizeof(dst[0]), "Unsupported platform.");
 
-    auto load_materials = [&] (Assimp_Model& model) {
-        auto next_mat_name_id = 0;
-        //auto textures = std::span<::aiTexture*>{scene->mTextures, scene->mNumTextures};
+                if (src == nullptr || mesh->mNumVertices == 0)
+                    return;
 
-        for (int i = 0; i < int(scene->mNumMaterials); i++) {
-            auto mat = scene->mMaterials[i];
+                dst.resize(std::size_t(mesh->mNumVertices));
+                std::copy_n(
+                    reinterpret_cast<char const*>(src),
+                    std::size_t(mesh->mNumVertices) * sizeof(src[0]),
+                    reinterpret_cast<char*>(dst.data())
+                );
+            };
+
+            auto copy_if_exists_to_2d = [&] (auto src, auto& dst) {
+                if (src == nullptr || mesh->mNumVertices == 0)
+                    return;
+
+                dst.reserve(std::size_t(mesh->mNumVertices));
+                for (auto last=src+mesh->mNumVertices; src!=last; src++)
+                    dst.emplace_back(src->x, src->y);
+            };
 
-            Assimp_Model::Material result;
+            copy_if_exists(mesh->mVertices, shape.position);
+            copy_if_exists(mesh->mNormals, shape.normal);
+            copy_if_exists(mesh->mTangents, shape.tangent);
+            copy_if_exists(mesh->mBitangents, shape.bitangent);
+            copy_if_exists_to_2d(mesh->mTextureCoords[0], shape.texcoord);
+            copy_if_exists(mesh->mColors[0], shape.color);
+        };
+
+        auto load_materials = [&] (Assimp_Model& model) {
+            auto next_mat_name_id = 0;
+            //auto textures = std::span<::aiTexture*>{scene->mTextures, scene->mNumTextures};
 
-            result.name = mat->GetName().C_Str();
-            if (result.name.empty()) result.name = "material" + std::to_string(next_mat_name_id++);
+            // Fallback names depend on how many unnamed materials came before, so they are assigned up front.
+            model.materials.resize(std::size_t(scene->mNumMaterials));
+            for (int i = 0; i < int(scene->mNumMaterials); i++) {
+                auto& result = model.materials[i];
+                result.name = scene->mMaterials[i]->GetName().C_Str();
+                if (result.name.empty()) result.name = "material" + std::to_string(next_mat_name_id++);
+            }
 
-            static_assert(sizeof(glm::vec4) == sizeof(::aiColor4D), "Unsupported platform.");
-            mat->Get(AI_MATKEY_COLOR_DIFFUSE, reinterpret_cast<::aiColor4D&>(result.diffuse_color));
-            mat->Get(AI_MATKEY_COLOR_SPECULAR, reinterpret_cast<::aiColor4D&>(result.specular_color));
-            mat->Get(AI_MATKEY_COLOR_AMBIENT, reinterpret_cast<::aiColor4D&>(result.ambient_color));
-            mat->Get(AI_MATKEY_COLOR_TRANSPARENT, reinterpret_cast<::aiColor4D&>(result.transparent_color));
-            mat->Get(AI_MATKEY_COLOR_EMISSIVE, reinterpret_cast<::aiColor4D&>(result.emissive_color));
+            for_each_index(thread_pool, model.materials.size(), [&] (std::size_t i) {
+                auto mat = scene->mMaterials[i];
+                auto& result = model.materials[i];
 
-            mat->Get(AI_MATKEY_SHININESS, result.shininess);
-            mat->Get(AI_MATKEY_OPACITY, result.opacity);
+                static_assert(sizeof(glm::vec4) == sizeof(::aiColor4D), "Unsupported platform.");
+                mat->Get(AI_MATKEY_COLOR_DIFFUSE, reinterpret_cast<::aiColor4D&>(result.diffuse_color));
+                mat->Get(AI_MATKEY_COLOR_SPECULAR, reinterpret_cast<::aiColor4D&>(result.specular_color));
+                mat->Get(AI_MATKEY_COLOR_AMBIENT, reinterpret_cast<::aiColor4D&>(result.ambient_color));
+                mat->Get(AI_MATKEY_COLOR_TRANSPARENT, reinterpret_cast<::aiColor4D&>(result.transparent_color));
+                mat->Get(AI_MATKEY_COLOR_EMISSIVE, reinterpret_cast<::aiColor4D&>(result.emissive_color));
+
+                mat->Get(AI_MATKEY_SHININESS, result.shininess);
+                mat->Get(AI_MATKEY_OPACITY, result.opacity);
+            });
 
-            for (auto tex_type_assimp_tex_type: tex_type_to_assimp) {
-                auto tex_type = tex_type_assimp_tex_type.first;
-                auto assimp_tex_type = tex_type_assimp_tex_type.second;
+            // Interning is serial, so texture indices do not depend on the thread count.
+            auto interner = Texture_Interner{model.textures};
+            for (auto i = (size_t) 0; i < model.materials.size(); i++) {
+                auto mat = scene->mMaterials[i];
+                auto& result = model.materials[i];
 
-                for (auto i = 0; i < mat->GetTextureCount(assimp_tex_type); i++) {
+                for (auto type = (size_t) 0; type < tex_type_to_assimp.size(); type++) {
                     aiString path;
-                    if (mat->GetTexture(assimp_tex_type, 0, &path) != ::aiReturn_SUCCESS) continue;
+                    if (mat->GetTextureCount(tex_type_to_assimp[type]) == 0) continue;
+                    if (mat->GetTexture(tex_type_to_assimp[type], 0, &path) != ::aiReturn_SUCCESS) continue;
                     if (path.C_Str()[0] == '\0') continue;
 
                     auto texture_path = std::string{path.C_Str()};
                     replace(texture_path.begin(), texture_path.end(), '\\', '/');
 
-                    if (model.textures.find(texture_path) == model.textures.end()) {
-                        model.textures.emplace(texture_path);
+                    auto texture_count = model.textures.size();
+                    result.textures[type] = interner.intern(texture_path);
+                    if (model.textures.size() != texture_count) {
                         std::cout << texture_path << std::endl;
                     }
-                    result.material_textures.emplace(tex_type, texture_path);
                 }
             }
-            model.materials.emplace_back(std::move(result));
-        }
-    };
+        };
 
-    auto load_meshes = [&] (Assimp_Model& model) {
-        auto next_mesh_name_id = 0;
+        auto load_meshes = [&] (Assimp_Model& model) {
+            model.meshes.resize(std::size_t(scene->mNumMeshes));
 
-        for (auto i = 0u; i < scene->mNumMeshes; i++) {
-            auto mesh = scene->mMeshes[i];
+            for_each_index(thread_pool, model.meshes.size(), [&] (std::size_t i) {
+                auto mesh = scene->mMeshes[i];
+                auto& result = model.meshes[i];
 
-            Assimp_Model::Mesh result;
+                result.name = "mesh" + std::to_string(i);
+                auto name = std::string{mesh->mName.C_Str()};
+                if (!name.empty()) {
+                    result.name += ": ";
+                    result.name += name;
+                }
 
-            result.name = "mesh" + std::to_string(next_mesh_name_id++);
-            auto name = std::string{mesh->mName.C_Str()};
-            if (!name.empty()) {
-                result.name += ": ";
-                result.name += name;
-            }
+                result.material = Array_Index(mesh->mMaterialIndex);
 
-            result.material = Array_Index(mesh->mMaterialIndex);
+                auto copy_if_exists_to_triangle = [&] (auto src, auto& dst) {
+                    static_assert(sizeof(unsigned int) == sizeof(std::uint32_t), "Unsupported platform.");
 
-            auto copy_if_exists_to_triangle = [&] (auto src, auto& dst) {
-                static_assert(sizeof(unsigned int) == sizeof(std::uint32_t), "Unsupported platform.");
+                    if (src == nullptr || mesh->mNumFaces == 0)
+                        return;
 
-                if (src == nullptr || mesh->mNumFaces == 0)
-                    return;
+                    dst.reserve(std::size_t(mesh->mNumFaces));
+
+                    for (auto last = src + mesh->mNumFaces; src != last; src++) {
+                        dst.push_back({
+                            src->mIndices[0],
+                            src->mIndices[1],
+                            src->mIndices[2],
+                        });
+                    }
+                };
+
+                // Assimp hands out every shape as a full copy of the mesh, the difference to the
+                // base mesh is what gets kept.
+                auto copy_if_exists_to_shape_keys = [&] (auto src, auto& dst) {
+                    if (src == nullptr || mesh->mNumAnimMeshes == 0)
+                        return;
+
+                    auto next_shape_key_name_id = 0;
+                    dst.reserve(std::size_t(mesh->mNumAnimMeshes));
+
+                    for (auto i = 0u; i < mesh->mNumAnimMeshes; i++) {
+                        auto assimp_key = src[i];
+                        if (assimp_key->mVertices == nullptr || assimp_key->mNumVertices != mesh->mNumVertices)
+                            continue;
+
+                        auto position_deltas = std::vector<glm::vec3>(std::size_t(mesh->mNumVertices));
+                        for (auto v = 0u; v < mesh->mNumVertices; v++) {
+                            position_deltas[v] = from_assimp(assimp_key->mVertices[v]) - from_assimp(mesh->mVertices[v]);
+                        }
+
+                        auto key = make_shape_key(position_deltas);
+                        key.name = "shape" + std::to_string(next_shape_key_name_id++);
+                        auto name = std::string{assimp_key->mName.C_Str()};
+                        if (!name.empty()) {
+                            key.name += ": ";
+                            key.name += name;
+                        }
+
+                        key.default_weight = assimp_key->mWeight;
+                        dst.emplace_back(std::move(key));
+                    }
+                };
+
+                auto copy_if_exists_to_bones = [&] () {
+                    if (mesh->mNumBones == 0)
+                        return;
+
+                    auto weights = std::vector<Bone_Weight>{};
+                    result.bones.reserve(std::size_t(mesh->mNumBones));
+                    for (auto i = 0u; i < mesh->mNumBones; i++) {
+                        auto bone = mesh->mBones[i];
+                        result.bones.push_back({Array_Index(-1), from_assimp(bone->mOffsetMatrix), std::string{bone->mName.C_Str()}});
+                        for (auto w = 0u; w < bone->mNumWeights; w++) {
+                            weights.push_back({bone->mWeights[w].mVertexId, i, bone->mWeights[w].mWeight});
+                        }
+                    }
+                    pack_bone_influences(result, weights);
+                };
+
+                copy_if_exists_to_triangle(mesh->mFaces, result.topology);
+                copy_into_shape_if_exists(mesh, result.vertex_info);
+                copy_if_exists_to_bones();
+                copy_if_exists_to_shape_keys(mesh->mAnimMeshes, result.shape_keys);
+            });
+        };
+
+        // Appending children to the node array itself turns it into the breadth first queue:
+        // every node is visited once, in level order, and knows its parent index on arrival.
+        auto load_hierarchy = [&] (Assimp_Model& model) -> void {
+            auto next_node_name_id = 0;
+            auto pending = std::vector<::aiNode const*>{scene->mRootNode};
+            model.nodes.push_back({Array_Index(-1), from_assimp(scene->mRootNode->mTransformation), {}});
 
-                dst.reserve(std::size_t(mesh->mNumFaces));
+            for (auto node_index = (size_t) 0; node_index < pending.size(); node_index++) {
+                auto node = pending[node_index];
 
-                for (auto last = src + mesh->mNumFaces; src != last; src++) {
-                    dst.push_back({
-                        src->mIndices[0],
-                        src->mIndices[1],
-                        src->mIndices[2],
-                    });
+                for (int i=0; i<int(node->mNumMeshes); i++)
+                    model.meshes[node->mMeshes[i]].parent = Array_Index(node_index);
+
+                for (int i=0; i<int(node->mNumChildren); i++) {
+                    auto child = node->mChildren[i];
+                    pending.emplace_back(child);
+                    model.nodes.push_back({Array_Index(node_index), from_assimp(child->mTransformation), {}});
                 }
-            };
 
-            auto copy_if_exists_to_shape_keys = [&] (auto src, auto& dst) {
-                if (src == nullptr || mesh->mNumAnimMeshes == 0)
-                    return;
+                auto name = std::string{node->mName.C_Str()};
+                if (name.empty()) name = "node" + std::to_string(next_node_name_id++);
+                model.nodes[node_index].name = std::move(name);
+            }
+        };
 
-                auto next_shape_key_name_id = 0;
-                dst.resize(std::size_t(mesh->mNumAnimMeshes));
+        // Key times are converted from ticks to seconds; channels of nodes outside the hierarchy are dropped.
+        auto load_animations = [&] (Assimp_Model& model) -> void {
+            auto node_indices = std::unordered_map<std::string, Array_Index>{};
+            for (auto i = (size_t) 0; i < model.nodes.size(); i++) node_indices.emplace(model.nodes[i].name, Array_Index(i));
 
-                for (auto i = 0u; i < mesh->mNumAnimMeshes; i++) {
-                    auto assimp_key = src[i];
-                    auto& key = dst[i];
+            model.animations.resize(std::size_t(scene->mNumAnimations));
+            for (auto i = 0u; i < scene->mNumAnimations; i++) {
+                auto animation = scene->mAnimations[i];
+                auto& result = model.animations[i];
 
-                    key.name = "shape" + std::to_string(next_shape_key_name_id++);
-                    auto name = std::string{assimp_key->mName.C_Str()};
-                    if (!name.empty()) {
-                        key.name += ": ";
-                        key.name += name;
-                    }
+                auto ticks_per_second = animation->mTicksPerSecond > 0.0 ? animation->mTicksPerSecond : 25.0;
+                auto seconds = [&] (double ticks) { return float(ticks / ticks_per_second); };
 
-                    key.default_weight = assimp_key->mWeight;
-                    copy_into_shape_if_exists(assimp_key, key.shape);
+                result.name = "animation" + std::to_string(i);
+                auto name = std::string{animation->mName.C_Str()};
+                if (!name.empty()) {
+                    result.name += ": ";
+                    result.name += name;
                 }
-            };
+                result.duration = seconds(animation->mDuration);
+
+                for (auto c = 0u; c < animation->mNumChannels; c++) {
+                    auto src = animation->mChannels[c];
+                    auto node = node_indices.find(src->mNodeName.C_Str());
+                    if (node == node_indices.end()) continue;
+
+                    auto channel = Assimp_Model::Animation::Channel{};
+                    channel.node = node->second;
+                    for (auto k = 0u; k < src->mNumPositionKeys; k++) {
+                        channel.translation_times.emplace_back(seconds(src->mPositionKeys[k].mTime));
+                        channel.translations.emplace_back(from_assimp(src->mPositionKeys[k].mValue));
+                    }
+                    for (auto k = 0u; k < src->mNumRotationKeys; k++) {
+                        channel.rotation_times.emplace_back(seconds(src->mRotationKeys[k].mTime));
+                        channel.rotations.emplace_back(from_assimp(src->mRotationKeys[k].mValue));
+                    }
+                    for (auto k = 0u; k < src->mNumScalingKeys; k++) {
+                        channel.scale_times.emplace_back(seconds(src->mScalingKeys[k].mTime));
+                        channel.scales.emplace_back(from_assimp(src->mScalingKeys[k].mValue));
+                    }
+                    result.channels.emplace_back(std::move(channel));
+                }
+            }
+        };
 
-            copy_if_exists_to_triangle(mesh->mFaces, result.topology);
-            copy_into_shape_if_exists(mesh, result.vertex_info);
+        Assimp_Model result;
+        {
+            auto extract_start = std::chrono::high_resolution_clock::now();
+            std::cout << "Loading materials..." << std::endl;
+            load_materials(result);
+            std::cout << result.materials.size() << " materials have been loaded." << std::endl;
+            std::cout << "Loading meshes..." << std::endl;
+            load_meshes(result);
+            std::cout << result.meshes.size() << " meshes have been loaded." << std::endl;
+            auto extract_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - extract_start).count();
+            std::cout << "Extracted meshes and materials in " << extract_ms << " ms on "
+                      << (thread_pool ? thread_pool->size() + 1 : 1) << " thread(s)" << std::endl;
+            load_hierarchy(result);
+            bind_bones_to_nodes(result);
+            load_animations(result);
+        }
+        //std::cout << "Model_Info: mesh[" << result.meshes.size() << "], node[" << result.nodes.size() << "], material[" << result.materials.size() << "], texture[" << result.textures.size() << "]" << std::endl;;
+        return result;
+    }
 
-            model.meshes.emplace_back(std::move(result));
+    // A fresh one per import, since the importer deletes it; nullptr keeps Assimp's default IO.
+    auto make_io_system(Model_Load_Options const& options) -> Assimp::IOSystem*
+    {
+        return options.mapped_io ? new Mapped_IO_System{options.archive} : nullptr;
+    }
+
+    // Peak resident set size in bytes since the last reset_peak_resident_bytes(), 0 where the platform
+    // does not report it. Linux keeps it as VmHWM and resets it through clear_refs.
+    auto peak_resident_bytes() -> std::size_t
+    {
+#ifdef __linux__
+        auto status = std::ifstream{"/proc/self/status"};
+        for (auto line = std::string{}; std::getline(status, line);) {
+            if (line.compare(0, 6, "VmHWM:") == 0) return std::size_t(std::stoull(line.substr(6))) * 1024;
         }
-    };
+#endif
+        return 0;
+    }
+
+    auto reset_peak_resident_bytes() -> void
+    {
+#ifdef __linux__
+        auto clear_refs = std::ofstream{"/proc/self/clear_refs"};
+        clear_refs << "5";
+#endif
+    }
+
+    // glTF files are read by fastgltf from the file system, the archive only serves Assimp imports.
+    auto import_any(std::string const& path, Model_Load_Options const& options) -> Assimp_Model
+    {
+        if (is_gltf_path(path)) return import_gltf(path, options.thread_pool);
+
+        auto const& profile = options.import_profile;
+        std::cout << "Import profile " << profile.name << ": " << describe_post_process(profile.post_process) << std::endl;
+        return import_model(path, profile.post_process, options.thread_pool, make_io_system(options));
+    }
+
+    // One bit per processing option that changes the cooked result.
+    auto processing_flags(Model_Load_Options const& options) -> std::uint32_t
+    {
+        auto flags = std::uint32_t{0};
+        if (options.weld_vertices) flags |= 1u << 0;
+        if (options.optimize_vertex_cache) flags |= 1u << 1;
+        if (options.optimize_overdraw) flags |= 1u << 2;
+        if (options.build_meshlets) flags |= 1u << 3;
+        if (options.generate_tangent_frames) flags |= 1u << 4;
+        flags |= std::uint32_t(std::min<std::size_t>(options.lod_levels, 0xff)) << 8;
+        return flags;
+    }
+
+    // Mesh processing that runs after the import and before the model gets cooked.
+    auto process_model(Assimp_Model& model, Model_Load_Options const& options) -> void
+    {
+        if (options.weld_vertices) {
+            auto mesh_stats = std::vector<Mesh_Size_Stats>(model.meshes.size());
+            for_each_index(options.thread_pool, model.meshes.size(), [&] (std::size_t i) {
+                mesh_stats[i] = weld_vertices(model.meshes[i]);
+            });
 
-    auto load_hierarchy = [&] (Assimp_Model& model) -> Node_Address_To_Index {
-        auto next_node_name_id = 0;
-        std::unordered_map<::aiNode*, Array_Index> node_to_index{{nullptr, Array_Index(-1)}};
-        std::deque<::aiNode*> pending{scene->mRootNode};
-        Node_Address_To_Index node_addr_to_idx;
+            auto stats = Mesh_Size_Stats{};
+            for (auto const& mesh_stat: mesh_stats) stats += mesh_stat;
+            std::cout << "Welded vertices: " << stats.vertices_before << " -> " << stats.vertices_after
+                      << ", mesh bytes: " << stats.bytes_before << " -> " << stats.bytes_after << std::endl;
+        }
+
+        // After welding, so every triangle around a vertex shares it; before anything reorders or adds levels.
+        if (options.generate_tangent_frames) {
+            using Clock = std::chrono::high_resolution_clock;
+
+            auto start = Clock::now();
+            auto stats = generate_tangent_frames(model, options.thread_pool);
+            auto ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            if (stats.normal_meshes > 0 || stats.tangent_meshes > 0) {
+                std::cout << "Generated normals for " << stats.normal_meshes << " and tangents for " << stats.tangent_meshes << " meshes, "
+                          << stats.split_vertices << " vertices split at mirrored texture coordinates, in " << ms << " ms" << std::endl;
+            }
+        }
 
-        while (!pending.empty()) {
-            auto node = pending.front();
-            pending.pop_front();
+        if (options.optimize_vertex_cache) {
+            auto before = std::vector<Vertex_Cache_Stats>(model.meshes.size());
+            auto after = std::vector<Vertex_Cache_Stats>(model.meshes.size());
+            for_each_index(options.thread_pool, model.meshes.size(), [&] (std::size_t i) {
+                auto& mesh = model.meshes[i];
+                before[i] = analyze_vertex_cache(mesh);
+                optimize_vertex_cache(mesh);
+                if (options.optimize_overdraw) optimize_overdraw(mesh);
+                optimize_vertex_fetch(mesh);
+                after[i] = analyze_vertex_cache(mesh);
+            });
 
-            auto parent = node_to_index.at(node->mParent);
-            auto node_index = Array_Index(model.nodes.size());
-            node_to_index.emplace(node, node_index);
+            auto stats_before = Vertex_Cache_Stats{};
+            auto stats_after = Vertex_Cache_Stats{};
+            for (auto i = (size_t) 0; i < model.meshes.size(); i++) {
+                stats_before += before[i];
+                stats_after += after[i];
+            }
+            std::cout << "Vertex cache (" << default_vertex_cache_size << " entries): ACMR " << stats_before.acmr() << " -> " << stats_after.acmr()
+                      << ", ATVR " << stats_before.atvr() << " -> " << stats_after.atvr() << std::endl;
+        }
 
-            // This assumes [SS/ASSIMP/V1] patchset for Assimp has been applied.
-            node_addr_to_idx.emplace("node:" + std::to_string(std::uintptr_t(node)), node_index);
+        if (options.lod_levels > 0) {
+            using Clock = std::chrono::high_resolution_clock;
 
-            for (int i=0; i<int(node->mNumMeshes); i++)
-                model.meshes[node->mMeshes[i]].parent = node_index;
+            auto start = Clock::now();
+            for_each_index(options.thread_pool, model.meshes.size(), [&] (std::size_t i) {
+                build_lod_chain(model.meshes[i], options.lod_levels);
+            });
+            auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
 
-            for (int i=0; i<int(node->mNumChildren); i++)
-                pending.emplace_back(node->mChildren[i]);
+            // Triangles per level summed over all meshes; meshes that stop early count their coarsest level.
+            auto level_triangles = std::vector<std::size_t>(options.lod_levels + 1, 0);
+            for (auto const& mesh: model.meshes) {
+                for (auto level = (size_t) 0; level < level_triangles.size() && !mesh.lods.empty(); level++) {
+                    level_triangles[level] += mesh.lods[std::min(level, mesh.lods.size() - 1)].triangle_count;
+                }
+            }
+            std::cout << "Built LODs, triangles:";
+            for (auto level = (size_t) 0; level < level_triangles.size(); level++) {
+                auto ratio = level_triangles[0] ? double(level_triangles[level]) / double(level_triangles[0]) : 0.0;
+                std::cout << (level ? " -> " : " ") << level_triangles[level] << " (" << ratio * 100.0 << "%)";
+            }
+            std::cout << " in " << seconds * 1000.0 << " ms ("
+                      << (seconds > 0.0 ? double(level_triangles[0]) / seconds / 1e6 : 0.0) << " Mtri/s)" << std::endl;
+        }
 
-            auto name = std::string{node->mName.C_Str()};
-            if (name.empty()) name = "node" + std::to_string(next_node_name_id++);
+        if (options.build_meshlets) {
+            using Clock = std::chrono::high_resolution_clock;
 
-            auto transformation = from_assimp(node->mTransformation);
-            model.nodes.push_back({
-                parent,
-                transformation,
-                std::move(name),
+            auto start = Clock::now();
+            for_each_index(options.thread_pool, model.meshes.size(), [&] (std::size_t i) {
+                build_meshlets(model.meshes[i]);
             });
+            auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+            auto meshlets = std::size_t{0};
+            auto triangles = std::size_t{0};
+            for (auto const& mesh: model.meshes) {
+                meshlets += mesh.meshlets.size();
+                triangles += mesh.topology.size();
+            }
+            std::cout << "Built " << meshlets << " meshlets from " << triangles << " triangles in " << seconds * 1000.0 << " ms ("
+                      << (seconds > 0.0 ? double(triangles) / seconds / 1e6 : 0.0) << " Mtri/s)" << std::endl;
         }
 
-        return node_addr_to_idx;
-    };
+        // Last, so the bounds are over the final vertices; cheap enough to always run.
+        {
+            using Clock = std::chrono::high_resolution_clock;
 
-    Assimp_Model result;
-    {
-        std::cout << "Loading materials..." << std::endl;
-        load_materials(result);
-        std::cout << result.materials.size() << " materials have been loaded." << std::endl;
-        std::cout << "Loading meshes..." << std::endl;
-        load_meshes(result);
-        std::cout << result.meshes.size() << " meshes have been loaded." << std::endl;
-        //for bones and animation
-        auto node_addr_to_idx = load_hierarchy(result);
+            auto start = Clock::now();
+            compute_model_bounds(model, options.thread_pool);
+            auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+            auto vertices = std::size_t{0};
+            for (auto const& mesh: model.meshes) vertices += mesh.vertex_info.position.size();
+            std::cout << "Computed bounds of " << model.meshes.size() << " meshes, " << vertices << " vertices in " << seconds * 1000.0 << " ms ("
+                      << (seconds > 0.0 ? double(vertices) / seconds / 1e6 : 0.0) << " Mvert/s)" << std::endl;
+        }
     }
-    //std::cout << "Model_Info: mesh[" << result.meshes.size() << "], node[" << result.nodes.size() << "], material[" << result.materials.size() << "], texture[" << result.textures.size() << "]" << std::endl;;
+}
+
+Texture_Interner::Texture_Interner(std::vector<std::string>& textures)
+    : textures{textures}
+{
+    for (auto i = (size_t) 0; i < textures.size(); i++) {
+        indices.emplace(textures[i], Assimp_Model::Texture_Index(i));
+    }
+}
+
+auto Texture_Interner::intern(std::string const& path) -> Assimp_Model::Texture_Index
+{
+    auto inserted = indices.emplace(path, Assimp_Model::Texture_Index(textures.size()));
+    if (inserted.second) textures.emplace_back(path);
+    return inserted.first->second;
+}
+
+auto load_model(std::string path, Model_Load_Options const& options) -> Assimp_Model
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    std::cout << "Loading model..." << std::endl;
+    auto start = Clock::now();
+    auto elapsed_ms = [&] { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+    if (options.cache_dir.empty()) {
+        auto result = import_any(path, options);
+        process_model(result, options);
+        std::cout << "Imported " << path << " in " << elapsed_ms() << " ms (cache disabled)" << std::endl;
+        return result;
+    }
+
+    auto source = map_asset(path, options.archive);
+    if (!source.valid()) {
+        throw std::runtime_error("failed to open model file: " + path);
+    }
+    auto key = cooked_model_key(source.data, source.size, options.import_profile.post_process, processing_flags(options));
+    auto cooked_path = cooked_model_path(options.cache_dir, path);
+
+    if (auto cooked = load_cooked_model(cooked_path, key)) {
+        std::cout << "Loaded cooked " << path << " in " << elapsed_ms() << " ms (warm)" << std::endl;
+        return std::move(*cooked);
+    }
+
+    auto result = import_any(path, options);
+    process_model(result, options);
+    auto import_ms = elapsed_ms();
+    // The cache only saves time: a read-only or full cache directory must not lose the model.
+    try {
+        save_cooked_model(cooked_path, key, result);
+    } catch (std::exception const& e) {
+        std::cout << "Not caching cooked model " << cooked_path << ": " << e.what() << std::endl;
+        std::cout << "Imported " << path << " in " << import_ms << " ms (cold)" << std::endl;
+        return result;
+    }
+    std::cout << "Imported " << path << " in " << import_ms << " ms, cooked in " << elapsed_ms() - import_ms << " ms (cold)" << std::endl;
+
     return result;
 }
+
+auto compare_model_importers(std::string path, Model_Load_Options const& options) -> void
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    if (!is_gltf_path(path)) {
+        throw std::runtime_error("importer comparison needs a .gltf or .glb file: " + path);
+    }
+
+    auto report = [&] (char const* backend, auto&& import) {
+        auto start = Clock::now();
+        auto model = import();
+        auto ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        auto triangles = std::size_t{0};
+        auto bytes = std::size_t{0};
+        for (auto const& mesh: model.meshes) {
+            triangles += mesh.topology.size();
+            bytes += mesh_bytes(mesh);
+        }
+        std::cout << backend << ": " << ms << " ms, " << model.nodes.size() << " nodes, " << model.meshes.size() << " meshes, "
+                  << triangles << " triangles, " << bytes << " mesh bytes" << std::endl;
+    };
+
+    // Same flags as load_model, so both backends produce what the cache would hold before processing.
+    report("Assimp", [&] { return import_model(path, options.import_profile.post_process, options.thread_pool, make_io_system(options)); });
+    report("fastgltf", [&] { return import_gltf(path, options.thread_pool); });
+}
+
+auto benchmark_tangent_frames(std::string path, Model_Load_Options const& options) -> void
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    auto const tangent_steps = aiProcess_GenNormals | aiProcess_GenSmoothNormals | aiProcess_ForceGenNormals | aiProcess_CalcTangentSpace;
+    // Triangulated and joined as load_model would weld them, so both sides see shared vertices.
+    auto const without = (options.import_profile.post_process & ~static_cast<unsigned int>(tangent_steps)) | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices;
+    auto const with = without | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace;
+
+    auto timed_import = [&] (unsigned int post_process, double& ms) {
+        auto start = Clock::now();
+        auto model = import_model(path, post_process, options.thread_pool, make_io_system(options));
+        ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        return model;
+    };
+    auto without_ms = 0.0;
+    auto with_ms = 0.0;
+    auto plain = timed_import(without, without_ms);
+    auto assimp = timed_import(with, with_ms);
+
+    auto timed_generate = [&] (Thread_Pool* thread_pool, double& ms) {
+        auto model = plain;
+        auto start = Clock::now();
+        generate_tangent_frames(model, thread_pool, true);
+        ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        return model;
+    };
+    auto serial_ms = 0.0;
+    auto parallel_ms = 0.0;
+    auto serial = timed_generate(nullptr, serial_ms);
+    auto parallel = timed_generate(options.thread_pool, parallel_ms);
+
+    // Both must match bit for bit. Vertex order differs from Assimp's, so normals are compared per triangle corner.
+    auto identical = serial.meshes.size() == parallel.meshes.size();
+    auto compared = std::size_t{0};
+    auto angle_sum = 0.0;
+    auto vertices = std::size_t{0};
+    for (auto i = (size_t) 0; i < serial.meshes.size() && identical; i++) {
+        auto const& a = serial.meshes[i].vertex_info;
+        auto const& b = parallel.meshes[i].vertex_info;
+        identical = a.normal == b.normal && a.tangent == b.tangent && a.bitangent == b.bitangent && serial.meshes[i].topology.size() == parallel.meshes[i].topology.size();
+        vertices += a.position.size();
+
+        if (i >= assimp.meshes.size() || assimp.meshes[i].topology.size() != serial.meshes[i].topology.size()) continue;
+        auto const& reference = assimp.meshes[i].vertex_info.normal;
+        if (reference.empty()) continue;
+        for (auto t = (size_t) 0; t < serial.meshes[i].topology.size(); t++) {
+            auto const& ours = serial.meshes[i].topology[t];
+            auto const& theirs = assimp.meshes[i].topology[t];
+            for (auto corner: {std::make_pair(ours.a, theirs.a), std::make_pair(ours.b, theirs.b), std::make_pair(ours.c, theirs.c)}) {
+                angle_sum += std::acos(std::clamp(double(glm::dot(a.normal[corner.first], reference[corner.second])), -1.0, 1.0));
+                compared++;
+            }
+        }
+    }
+
+    std::cout << "Tangent frames for " << path << ", " << vertices << " vertices:" << std::endl
+              << "  Assimp import " << without_ms << " ms, with GenSmoothNormals and CalcTangentSpace " << with_ms << " ms (+" << with_ms - without_ms << " ms)" << std::endl
+              << "  in-engine " << serial_ms << " ms on 1 thread, " << parallel_ms << " ms on " << (options.thread_pool ? options.thread_pool->size() + 1 : 1)
+              << " thread(s), results " << (identical ? "identical" : "DIFFERENT") << std::endl
+              << "  mean angle to Assimp's normals " << (compared ? glm::degrees(angle_sum / double(compared)) : 0.0) << " degrees over " << compared << " corners" << std::endl;
+}
+
+auto benchmark_model_io(std::string path, Model_Load_Options const& options) -> void
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    // Hashing the file first puts it into the page cache, so no variant pays for the disk.
+    auto source = map_asset(path, options.archive);
+    if (!source.valid()) {
+        throw std::runtime_error("failed to open model file: " + path);
+    }
+    auto const source_size = source.size;
+    hash_bytes(source.data, source.size);
+    source = {};
+
+    auto report = [&] (char const* variant, auto&& make_io) {
+        auto resident_before = peak_resident_bytes();
+        reset_peak_resident_bytes();
+        auto start = Clock::now();
+        auto model = import_model(path, options.import_profile.post_process, options.thread_pool, make_io());
+        auto ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        auto peak = peak_resident_bytes();
+
+        std::cout << variant << ": " << ms << " ms, " << model.meshes.size() << " meshes";
+        if (peak > 0) std::cout << ", peak RSS " << double(peak) / (1024.0 * 1024.0) << " MiB (" << double(resident_before) / (1024.0 * 1024.0) << " MiB before)";
+        std::cout << std::endl;
+    };
+
+    std::cout << "Model IO for " << path << ", " << source_size << " bytes:" << std::endl;
+    report("  default IO", [] () -> Assimp::IOSystem* { return nullptr; });
+    report("  mapped IO", [] () -> Assimp::IOSystem* { return new Mapped_IO_System{}; });
+    if (options.archive && options.archive->find(path).valid()) {
+        report("  archive", [&] () -> Assimp::IOSystem* { return new Mapped_IO_System{options.archive}; });
+    }
+}
+
+auto benchmark_model_extraction(std::string path, std::size_t max_threads, Model_Load_Options const& options) -> void
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    if (max_threads == 0) max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    auto timed_import = [&] (Thread_Pool* thread_pool, double& ms) {
+        auto start = Clock::now();
+        auto model = import_model(path, options.import_profile.post_process, thread_pool, make_io_system(options));
+        ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        return model;
+    };
+    auto same_meshes = [] (Assimp_Model const& a, Assimp_Model const& b) {
+        if (a.meshes.size() != b.meshes.size() || a.materials.size() != b.materials.size() || a.textures != b.textures) return false;
+        for (auto i = (size_t) 0; i < a.meshes.size(); i++) {
+            auto const& x = a.meshes[i];
+            auto const& y = b.meshes[i];
+            if (x.vertex_info.position != y.vertex_info.position || x.vertex_info.normal != y.vertex_info.normal ||
+                x.vertex_info.texcoord != y.vertex_info.texcoord || x.vertex_info.color != y.vertex_info.color ||
+                x.topology.size() != y.topology.size() || x.material != y.material) {
+                return false;
+            }
+            auto triangle_bytes = x.topology.size() * sizeof(Assimp_Model::Mesh::Triangle);
+            if (triangle_bytes > 0 && std::memcmp(x.topology.data(), y.topology.data(), triangle_bytes) != 0) return false;
+        }
+        for (auto i = (size_t) 0; i < a.materials.size(); i++) {
+            if (a.materials[i].name != b.materials[i].name || a.materials[i].textures != b.materials[i].textures) return false;
+        }
+        return true;
+    };
+
+    auto serial_ms = 0.0;
+    auto serial = timed_import(nullptr, serial_ms);
+    std::cout << "Extraction of " << path << ", " << serial.meshes.size() << " meshes:" << std::endl
+              << "  1 thread: " << serial_ms << " ms" << std::endl;
+
+    for (auto thread_count = (size_t) 2; ; thread_count = std::min(thread_count * 2, max_threads)) {
+        if (thread_count > max_threads) break;
+        // The caller works through parallel_for too, so the pool gets one worker less.
+        auto thread_pool = Thread_Pool{thread_count - 1};
+        auto ms = 0.0;
+        auto model = timed_import(&thread_pool, ms);
+        std::cout << "  " << thread_count << " threads: " << ms << " ms, " << (ms > 0.0 ? serial_ms / ms : 0.0) << "x, results "
+                  << (same_meshes(serial, model) ? "identical" : "DIFFERENT") << std::endl;
+        if (thread_count == max_threads) break;
+    }
+}
@@ -1,12 +1,18 @@
 #pragma once
+#include <array>
+#include <limits>
 #include <vector>
-#include <set>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <glm/mat4x4.hpp>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <assimp/Importer.hpp>
 
+#include "import_profile.hpp"
+
 class Assimp_Model
 {
 public:
@@ -34,12 +40,39 @@ public:
         ambient_occlusion,
     };
 
+    static constexpr std::size_t texture_type_count = std::size_t(Texture_Type::ambient_occlusion) + 1;
+
+    using Texture_Index = std::uint32_t;    // index for textures array
+    static constexpr Texture_Index no_texture = ~Texture_Index{0};
+
+    // One texture slot per Texture_Type, laid out for a std430 buffer.
+    using Texture_Slots = std::array<Texture_Index, texture_type_count>;
+
+    static constexpr auto empty_texture_slots() -> Texture_Slots
+    {
+        auto slots = Texture_Slots{};
+        for (auto i = std::size_t{0}; i < slots.size(); i++) slots[i] = no_texture;
+        return slots;
+    }
+
+    // Box and sphere around the same points; empty (min above max) when there are none. See bounds.hpp.
+    struct Bounds final
+    {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+        glm::vec4 sphere{};         // xyz center, w radius
+
+        auto empty() const -> bool { return min.x > max.x; }
+    };
+
     struct Node
     {
         Array_Index parent{-1};     // index for nodes array
         glm::mat4 transformation{};
 
         std::string name;
+
+        Bounds world_bounds{};      // every mesh of the subtree in model space, rest pose
     };
 
     struct Mesh final
@@ -59,14 +92,68 @@ public:
             std::vector<glm::vec3> bitangent;
             std::vector<glm::vec2> texcoord;
             std::vector<glm::vec4> color;
+            std::vector<glm::u8vec4> bone_indices;      // into bones, up to four influences per vertex
+            std::vector<glm::u8vec4> bone_weights;      // unorm, summing to 255
+        };
+
+        // Morph target stored sparsely: only the vertices it moves, as offsets from the base mesh.
+        // Normal deltas are dropped, nothing draws with normals.
+        struct Shape_Key final
+        {
+            std::vector<std::uint32_t> vertices;        // ascending
+            std::vector<glm::vec3> position_deltas;
+            float default_weight{};
+
+            std::string name;
+        };
+
+        // A node that deforms the mesh; see pack_bone_influences().
+        struct Bone final
+        {
+            Array_Index node{-1};       // index for nodes array
+            glm::mat4 offset{};         // mesh space to bone space in the bind pose
+
+            std::string name;
+        };
+
+        // A small cluster of triangles with its own local vertex list, laid out for a std430 buffer.
+        struct Meshlet final
+        {
+            std::uint32_t vertex_offset{};      // into meshlet_vertices
+            std::uint32_t triangle_offset{};    // into meshlet_triangles, three local indices per triangle
+            std::uint32_t vertex_count{};
+            std::uint32_t triangle_count{};
+            glm::vec4 bounding_sphere{};        // xyz center, w radius
+            glm::vec4 normal_cone{};            // xyz axis, w cutoff; the cluster faces away when
+                                                // dot(center - eye, axis) >= cutoff * length(center - eye) + radius
+        };
+
+        // One level of detail: a range of triangles and how far it deviates from the full mesh.
+        struct Lod final
+        {
+            std::uint32_t first_triangle{};     // into topology followed by lod_topology
+            std::uint32_t triangle_count{};
+            float error{};                      // object space distance of the full mesh's vertices to this level, at most
         };
 
         Array_Index parent{-1};     // index for nodes array
         Array_Index material{-1};   // index for materials array
+        Bounds bounds{};            // of vertex_info.position: the bind pose, shape keys not applied
 
         std::vector<Triangle> topology;
         Vertex_info vertex_info;
+        std::vector<Bone> bones;
+        std::vector<Shape_Key> shape_keys;
         std::string name;
+
+        // Optional simplified levels, see build_lod_chain(). lods[0] is the full topology.
+        std::vector<Lod> lods;
+        std::vector<Triangle> lod_topology;
+
+        // Optional meshlet decomposition of topology, see build_meshlets().
+        std::vector<Meshlet> meshlets;
+        std::vector<std::uint32_t> meshlet_vertices;    // mesh vertex index for every meshlet-local vertex
+        std::vector<std::uint8_t> meshlet_triangles;
     };
 
     struct Material final
@@ -80,7 +167,30 @@ public:
         float shininess{};
         float opacity{};
 
-        std::unordered_map<Texture_Type, std::string> material_textures;
+        Texture_Slots textures{empty_texture_slots()};     // no_texture where the material has none
+
+        auto texture(Texture_Type type) const -> Texture_Index { return textures[std::size_t(type)]; }
+
+        std::string name;
+    };
+
+    // Keyframed local transforms of some nodes, times in seconds; see compress_animation().
+    struct Animation final
+    {
+        // Tracks the channel does not animate stay empty and keep the node's own transformation.
+        struct Channel final
+        {
+            Array_Index node{-1};       // index for nodes array
+            std::vector<float> translation_times;
+            std::vector<glm::vec3> translations;
+            std::vector<float> rotation_times;
+            std::vector<glm::quat> rotations;
+            std::vector<float> scale_times;
+            std::vector<glm::vec3> scales;
+        };
+
+        float duration{};
+        std::vector<Channel> channels;
 
         std::string name;
     };
@@ -89,7 +199,57 @@ public:
     std::vector<Node> nodes;        // guaranteed to be in level-order
     std::vector<Mesh> meshes;
     std::vector<Material> materials;
-    std::set<std::string> textures;
+    std::vector<Animation> animations;
+    std::vector<std::string> textures;      // every distinct texture path once, in first use order
 };
 
-auto load_model(std::string path) -> Assimp_Model;
+// Builds Assimp_Model::textures while materials are read: each distinct path is stored once and
+// every further use gets the same index.
+class Texture_Interner final
+{
+public:
+    explicit Texture_Interner(std::vector<std::string>& textures);
+
+    auto intern(std::string const& path) -> Assimp_Model::Texture_Index;
+
+private:
+    std::vector<std::string>& textures;
+    std::unordered_map<std::string, Assimp_Model::Texture_Index> indices{};
+};
+
+class Thread_Pool;
+class Asset_Archive;
+
+struct Model_Load_Options final
+{
+    std::string cache_dir{};                // cooked models are read from and written to here, empty disables the cache
+    Import_Profile import_profile{};        // Assimp post-processing, part of the cache key
+    Thread_Pool* thread_pool{nullptr};      // meshes and materials are extracted in parallel when set
+    bool mapped_io{true};                   // Assimp reads through Mapped_IO_System instead of its stdio default
+    Asset_Archive const* archive{nullptr};  // searched before the file system by the mapped IO and the cache key
+    bool weld_vertices{true};               // merge identical vertices and compact the index space
+    bool generate_tangent_frames{true};     // fill missing normals, tangents and bitangents in-engine, see tangent_frames.hpp
+    bool optimize_vertex_cache{true};       // reorder triangles and vertices for the post-transform cache and vertex fetch
+    bool optimize_overdraw{false};          // additionally sort triangle clusters front to back, needs optimize_vertex_cache
+    bool build_meshlets{false};             // fill Mesh::meshlets with culling bounds
+    std::size_t lod_levels{0};              // simplified levels built below every mesh, 0 disables
+};
+
+auto load_model(std::string path, Model_Load_Options const& options = {}) -> Assimp_Model;
+
+// Imports a glTF file through both the Assimp and the fastgltf backend, bypassing the cache
+// and mesh processing, and logs their timings side by side.
+auto compare_model_importers(std::string path, Model_Load_Options const& options = {}) -> void;
+
+// Imports a model through Assimp with and without GenSmoothNormals and CalcTangentSpace, and
+// logs their cost next to generate_tangent_frames() on one thread and on options.thread_pool.
+auto benchmark_tangent_frames(std::string path, Model_Load_Options const& options = {}) -> void;
+
+// Imports a model through Assimp with its default IO, with mapped IO and, when options.archive
+// holds it, out of the archive, and logs the import time and peak resident memory of each.
+auto benchmark_model_io(std::string path, Model_Load_Options const& options = {}) -> void;
+
+// Imports a model through Assimp serially and then with pools of 2, 4, ... up to max_threads
+// threads (the caller included), and logs every import time next to the serial one and whether
+// the extracted meshes and materials match the serial result. Zero means one per hardware thread.
+auto benchmark_model_extraction(std::string path, std::size_t max_threads, Model_Load_Options const& options = {}) -> void;
@@ -1,19 +1,168 @@
 #include "engine.hpp"
+#include "asset_archive.hpp"
+#include "bounds.hpp"
+#include "mip_generator.hpp"
+#include "texture_ingest.hpp"
 
 #include <iostream>
 #include <stdexcept>
 #include <cstdlib>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <optional>
 
-int main()
+inline namespace
 {
+    // Runs a command line mode, or the renderer; what it throws is reported.
+    auto run_mode(std::function<void()> const& mode) -> int
+    {
+        try {
+            mode();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // A mode that works on a model, with a thread pool the load options already point at.
+    auto run_model_mode(std::function<void(Thread_Pool&, Model_Load_Options&)> const& mode) -> int
+    {
+        return run_mode([&] {
+            auto thread_pool = Thread_Pool{};
+            auto options = Model_Load_Options{};
+            options.thread_pool = &thread_pool;
+            mode(thread_pool, options);
+        });
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // Engine --compare-importers <model.gltf> times the Assimp and fastgltf backends instead of rendering.
+    if (argc == 3 && std::string{argv[1]} == "--compare-importers") {
+        return run_model_mode([&] (Thread_Pool&, Model_Load_Options& options) { compare_model_importers(argv[2], options); });
+    }
+
+    // Engine --benchmark-extraction <model> [max threads] imports the model serially and on pools of growing size.
+    if ((argc == 3 || argc == 4) && std::string{argv[1]} == "--benchmark-extraction") {
+        return run_mode([&] {
+            auto max_threads = argc == 4 ? std::size_t(std::clamp(std::atoi(argv[3]), 1, 1024)) : std::size_t(0);
+            benchmark_model_extraction(argv[2], max_threads);
+        });
+    }
+
+    // Engine --benchmark-animation <model> [characters] samples the model's first clip for a crowd of characters.
+    if ((argc == 3 || argc == 4) && std::string{argv[1]} == "--benchmark-animation") {
+        return run_model_mode([&] (Thread_Pool&, Model_Load_Options& options) {
+            auto character_count = argc == 4 ? std::size_t(std::clamp(std::atoi(argv[3]), 1, 65535)) : std::size_t(256);
+            benchmark_animation(argv[2], character_count, options);
+        });
+    }
+
+    // Engine --benchmark-tangents <model> times tangent frame generation in-engine against Assimp's.
+    if (argc == 3 && std::string{argv[1]} == "--benchmark-tangents") {
+        return run_model_mode([&] (Thread_Pool&, Model_Load_Options& options) { benchmark_tangent_frames(argv[2], options); });
+    }
+
+    // Engine --benchmark-meshlets <model> imports the model uncached with meshlets, which logs their build throughput.
+    if (argc == 3 && std::string{argv[1]} == "--benchmark-meshlets") {
+        return run_model_mode([&] (Thread_Pool&, Model_Load_Options& options) {
+            options.build_meshlets = true;
+            load_model(argv[2], options);
+        });
+    }
+
+    // Engine --cook-texture <image> <cache directory> cooks ahead of time what the engine would cook on first launch.
+    if (argc == 4 && std::string{argv[1]} == "--cook-texture") {
+        return run_mode([&] {
+            auto thread_pool = Thread_Pool{};
+            auto options = Texture_Load_Options{};
+            options.cache_dir = argv[3];
+            options.cook.thread_pool = &thread_pool;
+            load_texture(argv[2], options);
+        });
+    }
+
+    // Engine --pack-assets <directory> <archive> packs every file below directory into one archive.
+    if (argc == 4 && std::string{argv[1]} == "--pack-assets") {
+        return run_mode([&] {
+            auto file_count = write_asset_archive(argv[3], argv[2]);
+            std::cout << "Packed " << file_count << " files into " << argv[3] << std::endl;
+        });
+    }
+
+    // Engine --benchmark-io <model> [<archive> <directory it was packed from>] times Assimp's IO against mapped IO.
+    if ((argc == 3 || argc == 5) && std::string{argv[1]} == "--benchmark-io") {
+        return run_model_mode([&] (Thread_Pool&, Model_Load_Options& options) {
+            auto archive = std::optional<Asset_Archive>{};
+            if (argc == 5) archive.emplace(argv[3], argv[4]);
+            options.archive = archive ? &*archive : nullptr;
+            benchmark_model_io(argv[2], options);
+        });
+    }
+
+    // Engine --benchmark-bounds [vertices] times the SIMD bounds reduction against the scalar one.
+    if ((argc == 2 || argc == 3) && std::string{argv[1]} == "--benchmark-bounds") {
+        return run_mode([&] {
+            auto vertex_count = argc == 3 ? std::size_t(std::max(std::atoll(argv[2]), 1ll)) : std::size_t(1) << 22;
+            benchmark_bounds(vertex_count);
+        });
+    }
+
+    // Engine --benchmark-mips [image | size] times the CPU mip chain generator against its references.
+    if ((argc == 2 || argc == 3) && std::string{argv[1]} == "--benchmark-mips") {
+        return run_mode([&] {
+            auto thread_pool = Thread_Pool{};
+            auto argument = argc == 3 ? std::string{argv[2]} : std::string{};
+            auto is_size = !argument.empty() && std::all_of(argument.begin(), argument.end(), [] (char c) { return c >= '0' && c <= '9'; });
+            auto size = is_size ? std::uint32_t(std::max(std::atol(argument.c_str()), 1l)) : std::uint32_t(2048);
+            benchmark_mip_generation(is_size ? std::string{} : argument, size, thread_pool);
+        });
+    }
+
+    // Engine --benchmark-texture-ingest <model> decodes the model's textures serially and on the pool.
+    if (argc == 3 && std::string{argv[1]} == "--benchmark-texture-ingest") {
+        return run_model_mode([&] (Thread_Pool& thread_pool, Model_Load_Options&) { benchmark_texture_ingest(argv[2], thread_pool); });
+    }
+
     Hello_Triangle_Application app{};
 
-    try {
-        app.run();
-    } catch (const std::exception& e){
-        std::cerr << e.what() << std::endl;
-        return EXIT_FAILURE;
+    // Engine [--model <file in engine/asset>] [--skinning-instances <count>] [--texture-mips cooked|compute|blit]
+    //        [--texture-ingest parallel|serial] [--texture-budget <MB of texture levels in VRAM>]
+    for (auto i = 1; i + 1 < argc; i += 2) {
+        auto option = std::string{argv[i]};
+        if (option == "--model") {
+            app.model_file = argv[i + 1];
+        } else if (option == "--skinning-instances") {
+            app.skinning_instance_count = static_cast<uint32_t>(std::clamp(std::atoi(argv[i + 1]), 1, 65535));
+        } else if (option == "--texture-mips") {
+            auto value = std::string{argv[i + 1]};
+            if (value == "cooked") {
+                app.texture_mips = Mip_Generation::cooked;
+            } else if (value == "compute") {
+                app.texture_mips = Mip_Generation::compute;
+            } else if (value == "blit") {
+                app.texture_mips = Mip_Generation::blit;
+            } else {
+                std::cerr << "unknown mip generation " << value << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (option == "--texture-ingest") {
+            auto value = std::string{argv[i + 1]};
+            if (value != "parallel" && value != "serial") {
+                std::cerr << "unknown texture ingest " << value << std::endl;
+                return EXIT_FAILURE;
+            }
+            app.serial_texture_ingest = value == "serial";
+        } else if (option == "--texture-budget") {
+            app.texture_budget = static_cast<uint64_t>(std::clamp(std::atoi(argv[i + 1]), 1, 1 << 20)) << 20;
+        } else {
+            std::cerr << "unknown option " << option << std::endl;
+            return EXIT_FAILURE;
+        }
     }
 
-    return EXIT_SUCCESS;
+    return run_mode([&] { app.run(); });
 }
@@ -0,0 +1,235 @@
+#include "mapped_file.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Mapped_File::Mapped_File(std::string const& path)
+{
+#ifdef _WIN32
+    auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+    file_handle = file;
+
+    auto file_size = LARGE_INTEGER{};
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        close();
+        return;
+    }
+
+    mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        close();
+        return;
+    }
+
+    bytes = static_cast<std::byte const*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    byte_count = bytes ? std::size_t(file_size.QuadPart) : 0;
+    mapping_size = byte_count;
+    if (!bytes) close();
+#else
+    file_descriptor = ::open(path.c_str(), O_RDONLY);
+    if (file_descriptor < 0) return;
+
+    struct stat file_stat{};
+    if (::fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size == 0) {
+        close();
+        return;
+    }
+
+    auto mapping = ::mmap(nullptr, std::size_t(file_stat.st_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return;
+    }
+
+    bytes = static_cast<std::byte const*>(mapping);
+    byte_count = std::size_t(file_stat.st_size);
+    mapping_size = byte_count;
+#endif
+}
+
+Mapped_File::Mapped_File(std::string const& path, std::size_t padding)
+{
+#ifdef _WIN32
+    auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+    file_handle = file;
+
+    // A view can not reach past the end of the file, only the rest of its last page is spare.
+    auto file_size = LARGE_INTEGER{};
+    auto system_info = SYSTEM_INFO{};
+    GetSystemInfo(&system_info);
+    auto page_size = std::size_t(system_info.dwPageSize);
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 || (page_size - std::size_t(file_size.QuadPart) % page_size) % page_size < padding) {
+        close();
+        return;
+    }
+
+    mapping_handle = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        close();
+        return;
+    }
+
+    bytes = static_cast<std::byte const*>(MapViewOfFile(mapping_handle, FILE_MAP_COPY, 0, 0, 0));
+    if (!bytes) {
+        close();
+        return;
+    }
+    byte_count = std::size_t(file_size.QuadPart);
+    mapping_size = byte_count;
+#else
+    file_descriptor = ::open(path.c_str(), O_RDONLY);
+    if (file_descriptor < 0) return;
+
+    struct stat file_stat{};
+    if (::fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size == 0) {
+        close();
+        return;
+    }
+
+    // Anonymous zero pages for the whole range, then the file over the front of them.
+    auto size = std::size_t(file_stat.st_size);
+    auto reservation = ::mmap(nullptr, size + padding, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reservation == MAP_FAILED) {
+        close();
+        return;
+    }
+    bytes = static_cast<std::byte const*>(reservation);
+    byte_count = size;
+    mapping_size = size + padding;
+
+    if (::mmap(reservation, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, file_descriptor, 0) == MAP_FAILED) {
+        close();
+        return;
+    }
+#endif
+    copy_on_write = true;
+}
+
+Mapped_File::~Mapped_File()
+{
+    close();
+}
+
+Mapped_File::Mapped_File(Mapped_File&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+auto Mapped_File::operator=(Mapped_File&& other) noexcept -> Mapped_File&
+{
+    if (this != &other) {
+        close();
+        std::swap(bytes, other.bytes);
+        std::swap(byte_count, other.byte_count);
+        std::swap(mapping_size, other.mapping_size);
+        std::swap(copy_on_write, other.copy_on_write);
+#ifdef _WIN32
+        std::swap(file_handle, other.file_handle);
+        std::swap(mapping_handle, other.mapping_handle);
+#else
+        std::swap(file_descriptor, other.file_descriptor);
+#endif
+    }
+    return *this;
+}
+
+auto Mapped_File::close() -> void
+{
+#ifdef _WIN32
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mapping_handle) CloseHandle(mapping_handle);
+    if (file_handle) CloseHandle(file_handle);
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+#else
+    if (bytes) ::munmap(const_cast<std::byte*>(bytes), mapping_size);
+    if (file_descriptor >= 0) ::close(file_descriptor);
+    file_descriptor = -1;
+#endif
+    bytes = nullptr;
+    byte_count = 0;
+    mapping_size = 0;
+    copy_on_write = false;
+}
+
+auto hash_bytes(void const* data, std::size_t size, std::uint64_t seed) -> std::uint64_t
+{
+    constexpr auto prime = std::uint64_t{0x9e3779b97f4a7c15ull};
+
+    auto mix = [] (std::uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    };
+
+    auto bytes = static_cast<unsigned char const*>(data);
+    auto h = seed ^ (std::uint64_t(size) * prime);
+
+    auto i = std::size_t{0};
+    for (; i + 8 <= size; i += 8) {
+        auto word = std::uint64_t{};
+        std::memcpy(&word, bytes + i, 8);
+        h = (h ^ mix(word)) * prime;
+        h = (h << 31) | (h >> 33);
+    }
+
+    auto tail = std::uint64_t{};
+    if (i < size) std::memcpy(&tail, bytes + i, size - i);
+    h = (h ^ mix(tail)) * prime;
+
+    return mix(h);
+}
+
+auto write_file_atomically(std::string const& path, std::function<void(std::ostream&)> const& write) -> void
+{
+    static auto next_writer = std::atomic<std::uint64_t>{0};
+
+    auto target = std::filesystem::path{path};
+    if (target.has_parent_path()) std::filesystem::create_directories(target.parent_path());
+
+    // Process id and a per-process count keep the temporaries of all writers apart.
+#ifdef _WIN32
+    auto process = std::uint64_t(_getpid());
+#else
+    auto process = std::uint64_t(::getpid());
+#endif
+    auto temp_path = target;
+    temp_path += ".tmp" + std::to_string(process) + "-" + std::to_string(next_writer++);
+
+    try {
+        auto file = std::ofstream{temp_path, std::ios::binary | std::ios::trunc};
+        if (file) {
+            write(file);
+            file.close();
+        }
+        if (!file) {
+            throw std::runtime_error("failed to write file: " + temp_path.string() + "!");
+        }
+        std::filesystem::rename(temp_path, target);
+    } catch (...) {
+        auto ignored = std::error_code{};
+        std::filesystem::remove(temp_path, ignored);
+        throw;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+// Read-only view of a whole file mapped into the address space.
+// An empty or missing file yields an invalid mapping instead of throwing,
+// so callers can treat it as a cache miss.
+class Mapped_File final
+{
+public:
+    Mapped_File() = default;
+    explicit Mapped_File(std::string const& path);
+    // Mapped copy-on-write and followed by padding zero bytes that belong to no file, for parsers
+    // that read or write past the end. Writes never reach the file. On Windows the padding has to
+    // fit in the file's last page, otherwise the mapping is invalid.
+    Mapped_File(std::string const& path, std::size_t padding);
+    ~Mapped_File();
+
+    Mapped_File(Mapped_File const&) = delete;
+    auto operator=(Mapped_File const&) -> Mapped_File& = delete;
+    Mapped_File(Mapped_File&& other) noexcept;
+    auto operator=(Mapped_File&& other) noexcept -> Mapped_File&;
+
+    auto valid() const -> bool { return bytes != nullptr; }
+    auto data() const -> std::byte const* { return bytes; }
+    auto size() const -> std::size_t { return byte_count; }
+    auto writable_data() const -> std::byte* { return copy_on_write ? const_cast<std::byte*>(bytes) : nullptr; }     // padded mappings only
+
+private:
+    auto close() -> void;
+
+    std::byte const* bytes{nullptr};
+    std::size_t byte_count{0};
+    std::size_t mapping_size{0};        // byte_count plus the padding
+    bool copy_on_write{false};
+#ifdef _WIN32
+    void* file_handle{nullptr};
+    void* mapping_handle{nullptr};
+#else
+    int file_descriptor{-1};
+#endif
+};
+
+// 64-bit content hash, word-at-a-time so hashing multi-megabyte FBX files stays cheap.
+auto hash_bytes(void const* data, std::size_t size, std::uint64_t seed = 0) -> std::uint64_t;
+
+// Has write() fill a temporary file next to path and renames it over path once every byte made it,
+// so a crash or a failed write never leaves a half-written file behind. Each call writes its own
+// temporary: concurrent writers of one path do not collide, the last rename wins. Creates missing
+// directories and throws when the file cannot be written.
+auto write_file_atomically(std::string const& path, std::function<void(std::ostream&)> const& write) -> void;
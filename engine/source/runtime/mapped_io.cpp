@@ -0,0 +1,93 @@
+#include "mapped_io.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+Mapped_IO_Stream::Mapped_IO_Stream(Mapped_Bytes bytes)
+    : bytes{std::move(bytes)}
+{
+}
+
+auto Mapped_IO_Stream::Read(void* buffer, size_t size, size_t count) -> size_t
+{
+    if (size == 0 || count == 0) return 0;
+
+    // Whole elements only, as fread does.
+    auto available = (bytes.size - position) / size;
+    count = std::min(count, available);
+    std::memcpy(buffer, bytes.data + position, size * count);
+    position += size * count;
+    return count;
+}
+
+auto Mapped_IO_Stream::Write(void const*, size_t, size_t) -> size_t
+{
+    return 0;
+}
+
+auto Mapped_IO_Stream::Seek(size_t offset, aiOrigin origin) -> aiReturn
+{
+    auto target = std::size_t{};
+    switch (origin) {
+        case aiOrigin_SET: target = offset; break;
+        case aiOrigin_CUR: target = position + offset; break;
+        case aiOrigin_END: target = bytes.size - offset; break;
+        default: return aiReturn_FAILURE;
+    }
+    if (target > bytes.size) return aiReturn_FAILURE;
+
+    position = target;
+    return aiReturn_SUCCESS;
+}
+
+auto Mapped_IO_Stream::Tell() const -> size_t
+{
+    return position;
+}
+
+auto Mapped_IO_Stream::FileSize() const -> size_t
+{
+    return bytes.size;
+}
+
+auto Mapped_IO_Stream::Flush() -> void
+{
+}
+
+Mapped_IO_System::Mapped_IO_System(Asset_Archive const* archive)
+    : archive{archive}
+{
+}
+
+auto Mapped_IO_System::Exists(char const* path) const -> bool
+{
+    if (archive && archive->find(path).valid()) return true;
+    auto error = std::error_code{};
+    return std::filesystem::is_regular_file(path, error);
+}
+
+auto Mapped_IO_System::getOsSeparator() const -> char
+{
+#ifdef _WIN32
+    return '\\';
+#else
+    return '/';
+#endif
+}
+
+auto Mapped_IO_System::Open(char const* path, char const* mode) -> Assimp::IOStream*
+{
+    if (std::strchr(mode, 'w') || std::strchr(mode, 'a') || std::strchr(mode, '+')) return nullptr;
+
+    auto bytes = map_asset(path, archive);
+    if (!bytes.valid()) return nullptr;
+    return new Mapped_IO_Stream{std::move(bytes)};
+}
+
+auto Mapped_IO_System::Close(Assimp::IOStream* stream) -> void
+{
+    delete stream;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "asset_archive.hpp"
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+// Read-only Assimp stream over mapped bytes: reads are a memcpy out of the page cache, with no
+// stdio buffer in between.
+class Mapped_IO_Stream final: public Assimp::IOStream
+{
+public:
+    explicit Mapped_IO_Stream(Mapped_Bytes bytes);
+
+    auto Read(void* buffer, size_t size, size_t count) -> size_t override;
+    auto Write(void const* buffer, size_t size, size_t count) -> size_t override;
+    auto Seek(size_t offset, aiOrigin origin) -> aiReturn override;
+    auto Tell() const -> size_t override;
+    auto FileSize() const -> size_t override;
+    auto Flush() -> void override;
+
+private:
+    Mapped_Bytes bytes{};
+    std::size_t position{0};
+};
+
+// Opens every file an import touches (the model, .mtl files, external buffers) through
+// map_asset(): from the archive when one is given and holds the file, otherwise mapped from the
+// file system. Only read modes are supported. Hand it to Assimp::Importer::SetIOHandler, which
+// takes ownership.
+class Mapped_IO_System final: public Assimp::IOSystem
+{
+public:
+    explicit Mapped_IO_System(Asset_Archive const* archive = nullptr);
+
+    auto Exists(char const* path) const -> bool override;
+    auto getOsSeparator() const -> char override;
+    auto Open(char const* path, char const* mode = "rb") -> Assimp::IOStream* override;
+    auto Close(Assimp::IOStream* stream) -> void override;
+
+private:
+    Asset_Archive const* archive{nullptr};
+};
@@ -0,0 +1,262 @@
+#include "mesh_optimizer.hpp"
+#include "mesh_processing.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+inline namespace
+{
+    using Triangle = Assimp_Model::Mesh::Triangle;
+
+    auto corner(Triangle const& triangle, int i) -> std::uint32_t
+    {
+        return i == 0 ? triangle.a : (i == 1 ? triangle.b : triangle.c);
+    }
+
+    // Triangles adjacent to each vertex, in compressed sparse row form.
+    struct Vertex_Adjacency final
+    {
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> triangles;
+
+        Vertex_Adjacency(std::vector<Triangle> const& topology, std::size_t vertex_count)
+            : offsets(vertex_count + 1, 0), triangles(topology.size() * 3)
+        {
+            for (auto const& triangle: topology) {
+                for (auto i = 0; i < 3; i++) offsets[corner(triangle, i) + 1]++;
+            }
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+            auto cursor = std::vector<std::uint32_t>(offsets.begin(), offsets.end() - 1);
+            for (auto t = (size_t) 0; t < topology.size(); t++) {
+                for (auto i = 0; i < 3; i++) triangles[cursor[corner(topology[t], i)]++] = std::uint32_t(t);
+            }
+        }
+
+        auto count(std::uint32_t vertex) const -> std::uint32_t { return offsets[vertex + 1] - offsets[vertex]; }
+    };
+
+    // FIFO cache replay; returns per triangle whether all three corners missed, which marks a cache flush.
+    auto simulate_fifo(std::vector<Triangle> const& topology, std::size_t vertex_count, std::size_t cache_size,
+                       std::vector<bool>* cold_triangles = nullptr) -> std::size_t
+    {
+        auto time_stamps = std::vector<std::size_t>(vertex_count, 0);
+        auto time = cache_size + 1;
+        auto misses = std::size_t{0};
+
+        if (cold_triangles) cold_triangles->assign(topology.size(), false);
+
+        for (auto t = (size_t) 0; t < topology.size(); t++) {
+            auto triangle_misses = 0;
+            for (auto i = 0; i < 3; i++) {
+                auto vertex = corner(topology[t], i);
+                if (time - time_stamps[vertex] > cache_size) {
+                    time_stamps[vertex] = time++;
+                    triangle_misses++;
+                }
+            }
+            misses += std::size_t(triangle_misses);
+            if (cold_triangles && triangle_misses == 3) (*cold_triangles)[t] = true;
+        }
+
+        return misses;
+    }
+}
+
+auto Vertex_Cache_Stats::operator+=(Vertex_Cache_Stats const& other) -> Vertex_Cache_Stats&
+{
+    transformed_vertices += other.transformed_vertices;
+    triangles += other.triangles;
+    vertices += other.vertices;
+    return *this;
+}
+
+auto analyze_vertex_cache(Assimp_Model::Mesh const& mesh, std::size_t cache_size) -> Vertex_Cache_Stats
+{
+    auto vertex_count = mesh.vertex_info.position.size();
+
+    auto stats = Vertex_Cache_Stats{};
+    stats.transformed_vertices = simulate_fifo(mesh.topology, vertex_count, cache_size);
+    stats.triangles = mesh.topology.size();
+    stats.vertices = vertex_count;
+    return stats;
+}
+
+auto optimize_vertex_cache(Assimp_Model::Mesh& mesh, std::size_t cache_size) -> void
+{
+    constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+
+    auto& topology = mesh.topology;
+    auto vertex_count = mesh.vertex_info.position.size();
+    if (topology.empty() || vertex_count == 0) return;
+
+    auto adjacency = Vertex_Adjacency{topology, vertex_count};
+
+    auto live_triangles = std::vector<std::uint32_t>(vertex_count);
+    for (auto v = (size_t) 0; v < vertex_count; v++) live_triangles[v] = adjacency.count(std::uint32_t(v));
+
+    auto cache_time = std::vector<std::size_t>(vertex_count, 0);
+    auto emitted = std::vector<bool>(topology.size(), false);
+    auto dead_end = std::vector<std::uint32_t>{};
+    auto candidates = std::vector<std::uint32_t>{};
+
+    auto result = std::vector<Triangle>{};
+    result.reserve(topology.size());
+
+    auto time = cache_size + 1;
+    auto cursor = std::uint32_t{0};
+
+    auto skip_dead_end = [&] () -> std::uint32_t {
+        while (!dead_end.empty()) {
+            auto vertex = dead_end.back();
+            dead_end.pop_back();
+            if (live_triangles[vertex] > 0) return vertex;
+        }
+        while (cursor < vertex_count) {
+            if (live_triangles[cursor] > 0) return cursor;
+            cursor++;
+        }
+        return none;
+    };
+
+    // Prefer the candidate that stays in the cache after its remaining triangles are emitted,
+    // and among those the one that entered the cache earliest.
+    auto next_vertex = [&] () -> std::uint32_t {
+        auto best = none;
+        auto best_priority = -1l;
+
+        for (auto vertex: candidates) {
+            if (live_triangles[vertex] == 0) continue;
+
+            auto priority = 0l;
+            auto age = long(time - cache_time[vertex]);
+            if (age + 2 * long(live_triangles[vertex]) <= long(cache_size)) priority = age;
+
+            if (priority > best_priority) {
+                best_priority = priority;
+                best = vertex;
+            }
+        }
+
+        return best != none ? best : skip_dead_end();
+    };
+
+    auto fan = skip_dead_end();
+    while (fan != none) {
+        candidates.clear();
+
+        for (auto i = adjacency.offsets[fan]; i < adjacency.offsets[fan + 1]; i++) {
+            auto t = adjacency.triangles[i];
+            if (emitted[t]) continue;
+
+            for (auto c = 0; c < 3; c++) {
+                auto vertex = corner(topology[t], c);
+                dead_end.emplace_back(vertex);
+                candidates.emplace_back(vertex);
+                live_triangles[vertex]--;
+                if (time - cache_time[vertex] > cache_size) cache_time[vertex] = time++;
+            }
+
+            emitted[t] = true;
+            result.emplace_back(topology[t]);
+        }
+
+        fan = next_vertex();
+    }
+
+    topology = std::move(result);
+}
+
+auto optimize_overdraw(Assimp_Model::Mesh& mesh, std::size_t cache_size) -> void
+{
+    auto& topology = mesh.topology;
+    auto const& position = mesh.vertex_info.position;
+    if (topology.size() < 2 || position.empty()) return;
+
+    // Cluster boundaries sit where the cache was flushed anyway, so reordering clusters costs
+    // (almost) no extra vertex transforms. Tiny clusters are merged to keep the sort meaningful.
+    constexpr auto min_cluster_triangles = std::size_t{16};
+
+    auto cold_triangles = std::vector<bool>{};
+    simulate_fifo(topology, position.size(), cache_size, &cold_triangles);
+
+    auto cluster_starts = std::vector<std::size_t>{0};
+    for (auto t = (size_t) 1; t < topology.size(); t++) {
+        if (cold_triangles[t] && t - cluster_starts.back() >= min_cluster_triangles) cluster_starts.emplace_back(t);
+    }
+    cluster_starts.emplace_back(topology.size());
+
+    auto mesh_centroid = glm::vec3{0.0f};
+    for (auto const& p: position) mesh_centroid += p;
+    mesh_centroid /= float(position.size());
+
+    struct Cluster final
+    {
+        std::size_t begin{};
+        std::size_t end{};
+        float sort_key{};
+    };
+
+    auto clusters = std::vector<Cluster>{};
+    for (auto c = (size_t) 0; c + 1 < cluster_starts.size(); c++) {
+        auto centroid = glm::vec3{0.0f};
+        auto normal = glm::vec3{0.0f};
+        auto area = 0.0f;
+
+        for (auto t = cluster_starts[c]; t < cluster_starts[c + 1]; t++) {
+            auto const& a = position[topology[t].a];
+            auto const& b = position[topology[t].b];
+            auto const& p = position[topology[t].c];
+            auto cross = glm::cross(b - a, p - a);
+            auto triangle_area = glm::length(cross);
+
+            centroid += (a + b + p) * (triangle_area / 3.0f);
+            normal += cross;
+            area += triangle_area;
+        }
+
+        if (area > 0.0f) centroid /= area;
+        auto length = glm::length(normal);
+        if (length > 0.0f) normal /= length;
+
+        // Clusters far out along their own facing direction are likely occluders: draw them first.
+        clusters.push_back({cluster_starts[c], cluster_starts[c + 1], glm::dot(centroid - mesh_centroid, normal)});
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [] (Cluster const& lhs, Cluster const& rhs) {
+        return lhs.sort_key > rhs.sort_key;
+    });
+
+    auto result = std::vector<Triangle>{};
+    result.reserve(topology.size());
+    for (auto const& cluster: clusters) {
+        result.insert(result.end(), topology.begin() + cluster.begin, topology.begin() + cluster.end);
+    }
+    topology = std::move(result);
+}
+
+auto optimize_vertex_fetch(Assimp_Model::Mesh& mesh) -> void
+{
+    constexpr auto unassigned = std::numeric_limits<std::uint32_t>::max();
+
+    auto remap = std::vector<std::uint32_t>(mesh.vertex_info.position.size(), unassigned);
+    auto order = std::vector<std::uint32_t>{};
+    order.reserve(remap.size());
+
+    auto fetch = [&] (std::uint32_t vertex) -> std::uint32_t {
+        if (remap[vertex] == unassigned) {
+            remap[vertex] = std::uint32_t(order.size());
+            order.emplace_back(vertex);
+        }
+        return remap[vertex];
+    };
+
+    for (auto& triangle: mesh.topology) {
+        triangle.a = fetch(triangle.a);
+        triangle.b = fetch(triangle.b);
+        triangle.c = fetch(triangle.c);
+    }
+
+    gather_vertices(mesh, order);
+}
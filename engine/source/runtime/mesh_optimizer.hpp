@@ -0,0 +1,34 @@
+#pragma once
+#include "loader.hpp"
+
+#include <cstddef>
+
+constexpr std::size_t default_vertex_cache_size = 16;
+
+// Result of replaying an index list through a FIFO post-transform cache.
+struct Vertex_Cache_Stats final
+{
+    std::size_t transformed_vertices{};     // cache misses, i.e. vertex shader invocations
+    std::size_t triangles{};
+    std::size_t vertices{};
+
+    // Average cache miss ratio: transformed vertices per triangle, 0.5 is the ideal for large grids.
+    auto acmr() const -> float { return triangles ? float(transformed_vertices) / float(triangles) : 0.0f; }
+    // Average transform to vertex ratio: 1.0 means every vertex is shaded exactly once.
+    auto atvr() const -> float { return vertices ? float(transformed_vertices) / float(vertices) : 0.0f; }
+
+    auto operator+=(Vertex_Cache_Stats const& other) -> Vertex_Cache_Stats&;
+};
+
+auto analyze_vertex_cache(Assimp_Model::Mesh const& mesh, std::size_t cache_size = default_vertex_cache_size) -> Vertex_Cache_Stats;
+
+// Reorders triangles for post-transform cache locality (Tipsify, Sander et al. 2007).
+auto optimize_vertex_cache(Assimp_Model::Mesh& mesh, std::size_t cache_size = default_vertex_cache_size) -> void;
+
+// Splits the cache-optimized triangle order into clusters at cache flush points and
+// sorts the clusters so outward facing ones on the hull are drawn first. Run it after
+// optimize_vertex_cache; the cache efficiency inside each cluster is kept.
+auto optimize_overdraw(Assimp_Model::Mesh& mesh, std::size_t cache_size = default_vertex_cache_size) -> void;
+
+// Renumbers vertices in order of first use by the topology so vertex fetch walks memory linearly.
+auto optimize_vertex_fetch(Assimp_Model::Mesh& mesh) -> void;
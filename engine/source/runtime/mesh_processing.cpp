@@ -0,0 +1,214 @@
+#include "mesh_processing.hpp"
+#include "mapped_file.hpp"
+
+#include <cstring>
+#include <limits>
+
+inline namespace
+{
+    // Every shape key entry moving a vertex, grouped by vertex in key order.
+    struct Shape_Key_Entries final
+    {
+        std::vector<std::uint32_t> offsets{};   // of each vertex's first entry, one more than vertices
+        std::vector<std::uint32_t> keys{};      // index for Mesh::shape_keys
+        std::vector<std::uint32_t> entries{};   // index into that key's vertices and deltas
+        std::vector<std::uint64_t> hashes{};    // of each vertex's entries, for the weld table
+    };
+
+    // Vertices moving differently under any shape key must stay apart, so welding keys them on a
+    // hash of all their deltas as well and compares the deltas themselves when hashes match.
+    auto shape_key_entries(Assimp_Model::Mesh const& mesh) -> Shape_Key_Entries
+    {
+        auto result = Shape_Key_Entries{};
+        if (mesh.shape_keys.empty()) return result;
+
+        auto vertex_count = mesh.vertex_info.position.size();
+        result.offsets.assign(vertex_count + 1, 0);
+        for (auto const& key: mesh.shape_keys) {
+            for (auto vertex: key.vertices) result.offsets[vertex + 1]++;
+        }
+        for (auto v = (size_t) 0; v < vertex_count; v++) result.offsets[v + 1] += result.offsets[v];
+
+        auto fill = std::vector<std::uint32_t>(result.offsets.begin(), result.offsets.end() - 1);
+        result.keys.resize(result.offsets.back());
+        result.entries.resize(result.offsets.back());
+        result.hashes.assign(vertex_count, 0);
+        for (auto k = (size_t) 0; k < mesh.shape_keys.size(); k++) {
+            auto const& key = mesh.shape_keys[k];
+            for (auto i = (size_t) 0; i < key.vertices.size(); i++) {
+                auto vertex = key.vertices[i];
+                result.keys[fill[vertex]] = std::uint32_t(k);
+                result.entries[fill[vertex]] = std::uint32_t(i);
+                fill[vertex]++;
+
+                auto& hash = result.hashes[vertex];
+                hash = hash_bytes(&k, sizeof(k), hash);
+                hash = hash_bytes(&key.position_deltas[i], sizeof(key.position_deltas[i]), hash);
+            }
+        }
+        return result;
+    }
+
+    auto shape_keys_equal(Assimp_Model::Mesh const& mesh, Shape_Key_Entries const& shape, std::uint32_t a, std::uint32_t b) -> bool
+    {
+        if (shape.hashes[a] != shape.hashes[b]) return false;
+        auto count = shape.offsets[a + 1] - shape.offsets[a];
+        if (count != shape.offsets[b + 1] - shape.offsets[b]) return false;
+
+        for (auto i = (std::uint32_t) 0; i < count; i++) {
+            auto x = shape.offsets[a] + i;
+            auto y = shape.offsets[b] + i;
+            if (shape.keys[x] != shape.keys[y]) return false;
+            auto const& key = mesh.shape_keys[shape.keys[x]];
+            auto const& first = shape.entries[x];
+            auto const& second = shape.entries[y];
+            if (std::memcmp(&key.position_deltas[first], &key.position_deltas[second], sizeof(glm::vec3)) != 0) return false;
+        }
+        return true;
+    }
+
+    auto vertex_hash(Assimp_Model::Mesh::Vertex_info const& vertex_info, std::uint32_t vertex) -> std::uint64_t
+    {
+        auto hash = std::uint64_t{0};
+        for_each_stream(vertex_info, [&] (auto const& stream) {
+            if (!stream.empty()) hash = hash_bytes(&stream[vertex], sizeof(stream[vertex]), hash);
+        });
+        return hash;
+    }
+
+    auto vertex_equal(Assimp_Model::Mesh::Vertex_info const& vertex_info, std::uint32_t a, std::uint32_t b) -> bool
+    {
+        auto equal = true;
+        for_each_stream(vertex_info, [&] (auto const& stream) {
+            if (equal && !stream.empty()) equal = std::memcmp(&stream[a], &stream[b], sizeof(stream[a])) == 0;
+        });
+        return equal;
+    }
+}
+
+auto Mesh_Size_Stats::operator+=(Mesh_Size_Stats const& other) -> Mesh_Size_Stats&
+{
+    vertices_before += other.vertices_before;
+    vertices_after += other.vertices_after;
+    bytes_before += other.bytes_before;
+    bytes_after += other.bytes_after;
+    return *this;
+}
+
+auto gather_vertices(Assimp_Model::Mesh& mesh, std::vector<std::uint32_t> const& kept) -> void
+{
+    constexpr auto unmoved = std::numeric_limits<std::uint32_t>::max();
+    auto old_vertex_count = mesh.vertex_info.position.size();
+
+    for (auto& key: mesh.shape_keys) {
+        auto entry_of = std::vector<std::uint32_t>(old_vertex_count, unmoved);
+        for (auto i = (size_t) 0; i < key.vertices.size(); i++) entry_of[key.vertices[i]] = std::uint32_t(i);
+
+        auto gathered = Assimp_Model::Mesh::Shape_Key{};
+        for (auto new_index = (size_t) 0; new_index < kept.size(); new_index++) {
+            auto entry = entry_of[kept[new_index]];
+            if (entry == unmoved) continue;
+            gathered.vertices.emplace_back(std::uint32_t(new_index));
+            gathered.position_deltas.emplace_back(key.position_deltas[entry]);
+        }
+        key.vertices = std::move(gathered.vertices);
+        key.position_deltas = std::move(gathered.position_deltas);
+    }
+
+    for_each_stream(mesh.vertex_info, [&] (auto& stream) {
+        if (stream.empty()) return;
+
+        auto gathered = std::decay_t<decltype(stream)>{};
+        gathered.reserve(kept.size());
+        for (auto old_index: kept) {
+            gathered.emplace_back(stream[old_index]);
+        }
+        stream = std::move(gathered);
+    });
+}
+
+auto mesh_bytes(Assimp_Model::Mesh const& mesh) -> std::size_t
+{
+    auto bytes = mesh.topology.size() * sizeof(Assimp_Model::Mesh::Triangle);
+    for_each_stream(mesh.vertex_info, [&] (auto const& stream) {
+        bytes += stream.size() * sizeof(stream[0]);
+    });
+    for (auto const& key: mesh.shape_keys) {
+        bytes += key.vertices.size() * sizeof(key.vertices[0]);
+        bytes += key.position_deltas.size() * sizeof(key.position_deltas[0]);
+    }
+    return bytes;
+}
+
+auto make_shape_key(std::vector<glm::vec3> const& position_deltas) -> Assimp_Model::Mesh::Shape_Key
+{
+    // Exporters write tiny float noise into vertices a key does not really touch.
+    constexpr auto epsilon = 1e-6f;
+
+    auto key = Assimp_Model::Mesh::Shape_Key{};
+    for (auto v = (size_t) 0; v < position_deltas.size(); v++) {
+        if (!glm::any(glm::greaterThan(glm::abs(position_deltas[v]), glm::vec3{epsilon}))) continue;
+
+        key.vertices.emplace_back(std::uint32_t(v));
+        key.position_deltas.emplace_back(position_deltas[v]);
+    }
+    return key;
+}
+
+auto weld_vertices(Assimp_Model::Mesh& mesh) -> Mesh_Size_Stats
+{
+    constexpr auto unassigned = std::numeric_limits<std::uint32_t>::max();
+
+    auto stats = Mesh_Size_Stats{};
+    auto vertex_count = mesh.vertex_info.position.size();
+    stats.vertices_before = vertex_count;
+    stats.bytes_before = mesh_bytes(mesh);
+
+    // Open addressing table of canonical vertices, at most half full.
+    auto table_size = std::size_t{16};
+    while (table_size < vertex_count * 2) table_size *= 2;
+    auto table = std::vector<std::uint32_t>(table_size, unassigned);
+
+    auto shape = shape_key_entries(mesh);
+    auto hash_of = [&] (std::uint32_t vertex) {
+        auto hash = vertex_hash(mesh.vertex_info, vertex);
+        return shape.hashes.empty() ? hash : hash_bytes(&shape.hashes[vertex], sizeof(shape.hashes[vertex]), hash);
+    };
+    auto equal = [&] (std::uint32_t a, std::uint32_t b) {
+        return vertex_equal(mesh.vertex_info, a, b) && (shape.hashes.empty() || shape_keys_equal(mesh, shape, a, b));
+    };
+
+    auto remap = std::vector<std::uint32_t>(vertex_count, unassigned);
+    auto kept = std::vector<std::uint32_t>{};    // old index of every new vertex
+    kept.reserve(vertex_count);
+
+    auto weld = [&] (std::uint32_t vertex) -> std::uint32_t {
+        if (remap[vertex] != unassigned) return remap[vertex];
+
+        auto slot = std::size_t(hash_of(vertex)) & (table_size - 1);
+        while (table[slot] != unassigned) {
+            auto candidate = table[slot];
+            if (equal(kept[candidate], vertex)) {
+                return remap[vertex] = candidate;
+            }
+            slot = (slot + 1) & (table_size - 1);
+        }
+
+        auto new_index = std::uint32_t(kept.size());
+        kept.emplace_back(vertex);
+        table[slot] = new_index;
+        return remap[vertex] = new_index;
+    };
+
+    for (auto& triangle: mesh.topology) {
+        triangle.a = weld(triangle.a);
+        triangle.b = weld(triangle.b);
+        triangle.c = weld(triangle.c);
+    }
+
+    gather_vertices(mesh, kept);
+
+    stats.vertices_after = kept.size();
+    stats.bytes_after = mesh_bytes(mesh);
+    return stats;
+}
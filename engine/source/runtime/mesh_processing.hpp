@@ -0,0 +1,43 @@
+#pragma once
+#include "loader.hpp"
+
+#include <cstddef>
+
+struct Mesh_Size_Stats final
+{
+    std::size_t vertices_before{};
+    std::size_t vertices_after{};
+    std::size_t bytes_before{};     // vertex attribute streams plus indices
+    std::size_t bytes_after{};
+
+    auto operator+=(Mesh_Size_Stats const& other) -> Mesh_Size_Stats&;
+};
+
+// Calls function with every attribute stream of a Vertex_info, in declaration order.
+// Streams a mesh does not carry are passed as empty vectors.
+template <typename Vertex_Info, typename Function>
+auto for_each_stream(Vertex_Info& vertex_info, Function&& function) -> void
+{
+    function(vertex_info.position);
+    function(vertex_info.normal);
+    function(vertex_info.tangent);
+    function(vertex_info.bitangent);
+    function(vertex_info.texcoord);
+    function(vertex_info.color);
+    function(vertex_info.bone_indices);
+    function(vertex_info.bone_weights);
+}
+
+// Keeps only the listed vertices, in the listed order, in every stream and shape key of the mesh.
+auto gather_vertices(Assimp_Model::Mesh& mesh, std::vector<std::uint32_t> const& kept) -> void;
+
+// Turns dense per-vertex deltas into a sparse shape key holding only the vertices that move.
+auto make_shape_key(std::vector<glm::vec3> const& position_deltas) -> Assimp_Model::Mesh::Shape_Key;
+
+// Bytes held by the vertex streams, shape keys and the index list of a mesh.
+auto mesh_bytes(Assimp_Model::Mesh const& mesh) -> std::size_t;
+
+// Merges vertices whose attributes are bitwise identical across every stream the mesh
+// carries, and which every shape key moves alike, and rewrites the topology to the merged indices. Vertices are renumbered in
+// order of first use, so unreferenced vertices are dropped as well.
+auto weld_vertices(Assimp_Model::Mesh& mesh) -> Mesh_Size_Stats;
@@ -0,0 +1,534 @@
+#include "mesh_simplifier.hpp"
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+
+inline namespace
+{
+    using Triangle = Assimp_Model::Mesh::Triangle;
+
+    constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+    constexpr auto many = none - 1;
+
+    // Border planes are weighted up so open edges and seams keep their outline.
+    constexpr auto border_weight = 10.0;
+
+    auto corner(Triangle const& triangle, int i) -> std::uint32_t
+    {
+        return i == 0 ? triangle.a : (i == 1 ? triangle.b : triangle.c);
+    }
+
+    auto edge_key(std::uint32_t from, std::uint32_t to) -> std::uint64_t
+    {
+        return (std::uint64_t(from) << 32) | to;
+    }
+
+    // Closest point on triangle abc to p, after Ericson's Real-Time Collision Detection 5.1.5.
+    auto point_triangle_distance(glm::dvec3 p, glm::dvec3 a, glm::dvec3 b, glm::dvec3 c) -> double
+    {
+        auto ab = b - a;
+        auto ac = c - a;
+        auto ap = p - a;
+        auto d1 = glm::dot(ab, ap);
+        auto d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0 && d2 <= 0.0) return glm::length(p - a);
+
+        auto bp = p - b;
+        auto d3 = glm::dot(ab, bp);
+        auto d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0 && d4 <= d3) return glm::length(p - b);
+
+        auto vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) return glm::length(p - (a + ab * (d1 / (d1 - d3))));
+
+        auto cp = p - c;
+        auto d5 = glm::dot(ab, cp);
+        auto d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0 && d5 <= d6) return glm::length(p - c);
+
+        auto vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) return glm::length(p - (a + ac * (d2 / (d2 - d6))));
+
+        auto va = d3 * d6 - d5 * d4;
+        if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0) return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+
+        auto denominator = 1.0 / (va + vb + vc);
+        return glm::length(p - (a + ab * (vb * denominator) + ac * (vc * denominator)));
+    }
+
+    // Sum of weighted squared distances to a set of planes, as a symmetric 4x4 matrix.
+    struct Quadric final
+    {
+        double a00{};
+        double a01{};
+        double a02{};
+        double a11{};
+        double a12{};
+        double a22{};
+        double b0{};
+        double b1{};
+        double b2{};
+        double c{};
+        double weight{};
+
+        auto add_plane(glm::dvec3 normal, double distance, double plane_weight) -> void
+        {
+            a00 += plane_weight * normal.x * normal.x;
+            a01 += plane_weight * normal.x * normal.y;
+            a02 += plane_weight * normal.x * normal.z;
+            a11 += plane_weight * normal.y * normal.y;
+            a12 += plane_weight * normal.y * normal.z;
+            a22 += plane_weight * normal.z * normal.z;
+            b0 += plane_weight * normal.x * distance;
+            b1 += plane_weight * normal.y * distance;
+            b2 += plane_weight * normal.z * distance;
+            c += plane_weight * distance * distance;
+            weight += plane_weight;
+        }
+
+        auto operator+=(Quadric const& other) -> Quadric&
+        {
+            a00 += other.a00;
+            a01 += other.a01;
+            a02 += other.a02;
+            a11 += other.a11;
+            a12 += other.a12;
+            a22 += other.a22;
+            b0 += other.b0;
+            b1 += other.b1;
+            b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+            return *this;
+        }
+
+        // Weighted mean of the squared plane distances of point.
+        auto error(glm::vec3 point) const -> double
+        {
+            auto x = double(point.x);
+            auto y = double(point.y);
+            auto z = double(point.z);
+            auto result = a00 * x * x + a11 * y * y + a22 * z * z
+                        + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                        + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return weight > 0.0 ? std::max(result, 0.0) / weight : 0.0;
+        }
+    };
+
+    enum struct Vertex_Kind
+    {
+        manifold,   // interior vertex, collapses anywhere
+        border,     // on an open edge, collapses along it
+        seam,       // one of two UV wedges sharing a position, collapses along the seam with its twin
+        locked,     // corners, non-manifold or more than two wedges
+    };
+
+    // Maps every vertex to the first vertex with a bitwise identical position.
+    auto build_position_remap(std::vector<glm::vec3> const& position) -> std::vector<std::uint32_t>
+    {
+        auto order = std::vector<std::uint32_t>(position.size());
+        std::iota(order.begin(), order.end(), 0u);
+
+        auto less = [&] (std::uint32_t lhs, std::uint32_t rhs) {
+            auto result = std::memcmp(&position[lhs], &position[rhs], sizeof(glm::vec3));
+            return result != 0 ? result < 0 : lhs < rhs;
+        };
+        std::sort(order.begin(), order.end(), less);
+
+        auto remap = std::vector<std::uint32_t>(position.size());
+        for (auto i = (size_t) 0; i < order.size(); i++) {
+            auto same = i > 0 && std::memcmp(&position[order[i]], &position[order[i - 1]], sizeof(glm::vec3)) == 0;
+            remap[order[i]] = same ? remap[order[i - 1]] : order[i];
+        }
+        return remap;
+    }
+
+    struct Collapse final
+    {
+        std::uint32_t from{};
+        std::uint32_t to{};
+        double cost{};
+    };
+
+    struct Simplifier final
+    {
+        std::vector<glm::vec3> const& position;
+        std::vector<std::uint32_t> remap;           // vertex to its position representative
+        std::vector<Quadric> quadrics;              // per position representative
+
+        std::vector<Vertex_Kind> kind;
+        std::vector<std::uint32_t> open_out;        // target of the single open outgoing edge, none or many
+        std::vector<std::uint32_t> open_in;
+        std::vector<std::uint32_t> twin;            // other wedge of a seam vertex
+
+        std::vector<std::uint32_t> adjacency_offsets;   // triangles around each position representative
+        std::vector<std::uint32_t> adjacency;
+
+        explicit Simplifier(std::vector<glm::vec3> const& vertex_position)
+            : position(vertex_position), remap(build_position_remap(vertex_position)), quadrics(vertex_position.size())
+        {
+        }
+
+        auto add_quadrics(std::vector<Triangle> const& topology) -> void
+        {
+            auto edges = std::unordered_set<std::uint64_t>{};
+            edges.reserve(topology.size() * 3);
+            for (auto const& triangle: topology) {
+                for (auto i = 0; i < 3; i++) edges.insert(edge_key(corner(triangle, i), corner(triangle, (i + 1) % 3)));
+            }
+
+            for (auto const& triangle: topology) {
+                auto const& p0 = position[triangle.a];
+                auto normal = glm::dvec3{glm::cross(position[triangle.b] - p0, position[triangle.c] - p0)};
+                auto length = glm::length(normal);
+                if (length <= 0.0) continue;
+                normal /= length;
+
+                // Area weighted, so the error is a mean distance over the surface.
+                auto area = length * 0.5;
+                for (auto i = 0; i < 3; i++) {
+                    quadrics[remap[corner(triangle, i)]].add_plane(normal, -glm::dot(normal, glm::dvec3{position[corner(triangle, i)]}), area);
+                }
+
+                // Open edges in index space are mesh borders and UV seams alike.
+                for (auto i = 0; i < 3; i++) {
+                    auto from = corner(triangle, i);
+                    auto to = corner(triangle, (i + 1) % 3);
+                    if (edges.count(edge_key(to, from))) continue;
+
+                    auto edge = glm::dvec3{position[to] - position[from]};
+                    auto edge_normal = glm::cross(edge, normal);
+                    auto edge_length = glm::length(edge_normal);
+                    if (edge_length <= 0.0) continue;
+                    edge_normal /= edge_length;
+
+                    auto distance = -glm::dot(edge_normal, glm::dvec3{position[from]});
+                    auto edge_weight = glm::dot(edge, edge) * border_weight;
+                    quadrics[remap[from]].add_plane(edge_normal, distance, edge_weight);
+                    quadrics[remap[to]].add_plane(edge_normal, distance, edge_weight);
+                }
+            }
+        }
+
+        auto classify(std::vector<Triangle> const& topology) -> void
+        {
+            auto vertex_count = position.size();
+            auto edges = std::unordered_set<std::uint64_t>{};
+            auto position_edges = std::unordered_set<std::uint64_t>{};
+            edges.reserve(topology.size() * 3);
+            position_edges.reserve(topology.size() * 3);
+            for (auto const& triangle: topology) {
+                for (auto i = 0; i < 3; i++) {
+                    auto from = corner(triangle, i);
+                    auto to = corner(triangle, (i + 1) % 3);
+                    edges.insert(edge_key(from, to));
+                    position_edges.insert(edge_key(remap[from], remap[to]));
+                }
+            }
+
+            open_out.assign(vertex_count, none);
+            open_in.assign(vertex_count, none);
+            auto position_open = std::vector<std::uint32_t>(vertex_count, 0);
+            auto record = [] (std::uint32_t& slot, std::uint32_t vertex) {
+                slot = slot == none || slot == vertex ? vertex : many;
+            };
+
+            for (auto const& triangle: topology) {
+                for (auto i = 0; i < 3; i++) {
+                    auto from = corner(triangle, i);
+                    auto to = corner(triangle, (i + 1) % 3);
+                    if (!edges.count(edge_key(to, from))) {
+                        record(open_out[from], to);
+                        record(open_in[to], from);
+                    }
+                    if (!position_edges.count(edge_key(remap[to], remap[from]))) {
+                        position_open[remap[from]]++;
+                        position_open[remap[to]]++;
+                    }
+                }
+            }
+
+            // Wedges are the live vertices that share one position.
+            auto live = std::vector<bool>(vertex_count, false);
+            for (auto const& triangle: topology) {
+                for (auto i = 0; i < 3; i++) live[corner(triangle, i)] = true;
+            }
+            auto wedge_count = std::vector<std::uint32_t>(vertex_count, 0);
+            auto first_wedge = std::vector<std::uint32_t>(vertex_count, none);
+            twin.assign(vertex_count, none);
+            for (auto v = (size_t) 0; v < vertex_count; v++) {
+                if (!live[v]) continue;
+                auto r = remap[v];
+                if (wedge_count[r]++ == 0) {
+                    first_wedge[r] = std::uint32_t(v);
+                } else {
+                    twin[v] = first_wedge[r];
+                    twin[first_wedge[r]] = std::uint32_t(v);
+                }
+            }
+
+            auto single = [] (std::uint32_t slot) { return slot != none && slot != many; };
+
+            kind.assign(vertex_count, Vertex_Kind::locked);
+            for (auto v = (size_t) 0; v < vertex_count; v++) {
+                if (!live[v]) continue;
+                auto r = remap[v];
+
+                if (wedge_count[r] == 1) {
+                    if (position_open[r] == 0) {
+                        kind[v] = Vertex_Kind::manifold;
+                    } else if (single(open_out[v]) && single(open_in[v])) {
+                        kind[v] = Vertex_Kind::border;
+                    }
+                } else if (wedge_count[r] == 2 && position_open[r] == 0) {
+                    auto other = twin[v];
+                    if (single(open_out[v]) && single(open_in[v]) && single(open_out[other]) && single(open_in[other])) {
+                        kind[v] = Vertex_Kind::seam;
+                    }
+                }
+            }
+
+            adjacency_offsets.assign(vertex_count + 1, 0);
+            for (auto const& triangle: topology) {
+                for (auto i = 0; i < 3; i++) adjacency_offsets[remap[corner(triangle, i)] + 1]++;
+            }
+            std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+            adjacency.resize(topology.size() * 3);
+            auto cursor = std::vector<std::uint32_t>(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (auto t = (size_t) 0; t < topology.size(); t++) {
+                for (auto i = 0; i < 3; i++) adjacency[cursor[remap[corner(topology[t], i)]]++] = std::uint32_t(t);
+            }
+        }
+
+        // The seam twin of to that from's twin runs along, or none when the seam splits here.
+        auto twin_target(std::uint32_t from, std::uint32_t to) const -> std::uint32_t
+        {
+            auto other = twin[from];
+            if (open_out[other] < many && remap[open_out[other]] == remap[to]) return open_out[other];
+            if (open_in[other] < many && remap[open_in[other]] == remap[to]) return open_in[other];
+            return none;
+        }
+
+        auto can_collapse(std::uint32_t from, std::uint32_t to) const -> bool
+        {
+            auto along_open_edge = open_out[from] == to || open_in[from] == to;
+
+            switch (kind[from]) {
+            case Vertex_Kind::manifold:
+                return true;
+            case Vertex_Kind::border:
+                return along_open_edge && kind[to] != Vertex_Kind::manifold && kind[to] != Vertex_Kind::seam;
+            case Vertex_Kind::seam:
+                return along_open_edge && kind[to] != Vertex_Kind::manifold && kind[to] != Vertex_Kind::border && twin_target(from, to) != none;
+            default:
+                return false;
+            }
+        }
+
+        // Moving from onto to must not turn any of the remaining triangles around it over.
+        auto flips_triangles(std::vector<Triangle> const& topology, std::uint32_t from, std::uint32_t to) const -> bool
+        {
+            auto r_from = remap[from];
+            auto r_to = remap[to];
+            auto const& target = position[to];
+
+            for (auto i = adjacency_offsets[r_from]; i < adjacency_offsets[r_from + 1]; i++) {
+                auto const& triangle = topology[adjacency[i]];
+                auto corners = std::array<std::uint32_t, 3>{triangle.a, triangle.b, triangle.c};
+                if (remap[corners[0]] == r_to || remap[corners[1]] == r_to || remap[corners[2]] == r_to) continue;
+
+                auto points = std::array<glm::vec3, 3>{position[corners[0]], position[corners[1]], position[corners[2]]};
+                auto before = glm::cross(points[1] - points[0], points[2] - points[0]);
+                for (auto& point: points) {
+                    if (point == position[from]) point = target;
+                }
+                auto after = glm::cross(points[1] - points[0], points[2] - points[0]);
+                if (glm::dot(before, after) <= 0.0f) return true;
+            }
+            return false;
+        }
+    };
+}
+
+inline namespace
+{
+    // The quadric error is a weighted mean of squared distances, not a bound, so the error of a
+    // result is measured: the largest distance from a vertex of the input to the simplified
+    // triangles around the vertex it was folded into. Only that fan is searched, which can only
+    // overestimate the distance to the whole surface.
+    auto deviation(Simplifier const& simplifier, std::vector<Triangle> const& input, std::vector<Triangle> const& simplified,
+                   std::vector<std::uint32_t> const& folded) -> double
+    {
+        auto const& remap = simplifier.remap;
+        auto const& position = simplifier.position;
+
+        auto fan_offsets = std::vector<std::uint32_t>(position.size() + 1, 0);
+        for (auto const& triangle: simplified) {
+            for (auto c = 0; c < 3; c++) fan_offsets[remap[corner(triangle, c)] + 1]++;
+        }
+        for (auto i = (size_t) 0; i < position.size(); i++) fan_offsets[i + 1] += fan_offsets[i];
+        auto fill = std::vector<std::uint32_t>(fan_offsets.begin(), fan_offsets.end() - 1);
+        auto fans = std::vector<std::uint32_t>(fan_offsets.back());
+        for (auto t = (size_t) 0; t < simplified.size(); t++) {
+            for (auto c = 0; c < 3; c++) fans[fill[remap[corner(simplified[t], c)]]++] = std::uint32_t(t);
+        }
+
+        auto worst = 0.0;
+        auto measured = std::vector<bool>(position.size(), false);
+        for (auto const& triangle: input) {
+            for (auto c = 0; c < 3; c++) {
+                auto vertex = corner(triangle, c);
+                if (measured[vertex]) continue;
+                measured[vertex] = true;
+
+                auto target = remap[folded[vertex]];
+                if (remap[vertex] == target) continue;
+                auto point = glm::dvec3{position[vertex]};
+                // A vertex whose every triangle collapsed away keeps the distance it was moved.
+                auto distance = glm::length(point - glm::dvec3{position[target]});
+                for (auto i = fan_offsets[target]; i < fan_offsets[target + 1]; i++) {
+                    auto const& fan = simplified[fans[i]];
+                    distance = std::min(distance, point_triangle_distance(point, position[fan.a], position[fan.b], position[fan.c]));
+                }
+                worst = std::max(worst, distance);
+            }
+        }
+        return worst;
+    }
+}
+
+auto simplify_mesh(Assimp_Model::Mesh const& mesh, std::vector<Triangle> const& topology,
+                   std::size_t target_triangles, float max_error) -> Simplify_Result
+{
+    auto result = Simplify_Result{topology, 0.0f};
+    if (topology.size() <= target_triangles || mesh.vertex_info.position.empty()) return result;
+
+    auto simplifier = Simplifier{mesh.vertex_info.position};
+    simplifier.add_quadrics(topology);
+
+    auto& current = result.topology;
+    auto max_cost = double(max_error) * double(max_error);
+
+    // The vertex every vertex of topology has been folded into so far.
+    auto folded = std::vector<std::uint32_t>(mesh.vertex_info.position.size());
+    std::iota(folded.begin(), folded.end(), 0u);
+
+    auto vertex_remap = std::vector<std::uint32_t>(mesh.vertex_info.position.size());
+    auto collapse_locked = std::vector<bool>(mesh.vertex_info.position.size());
+    auto collapses = std::vector<Collapse>{};
+
+    // Each pass collapses the cheapest independent edges, then rebuilds the connectivity.
+    while (current.size() > target_triangles) {
+        simplifier.classify(current);
+        auto const& remap = simplifier.remap;
+
+        collapses.clear();
+        for (auto const& triangle: current) {
+            for (auto i = 0; i < 3; i++) {
+                auto v0 = corner(triangle, i);
+                auto v1 = corner(triangle, (i + 1) % 3);
+                for (auto direction = 0; direction < 2; direction++) {
+                    auto from = direction == 0 ? v0 : v1;
+                    auto to = direction == 0 ? v1 : v0;
+                    if (remap[from] == remap[to] || !simplifier.can_collapse(from, to)) continue;
+
+                    auto cost = simplifier.quadrics[remap[from]].error(simplifier.position[to]);
+                    if (cost <= max_cost) collapses.push_back({from, to, cost});
+                }
+            }
+        }
+        if (collapses.empty()) break;
+
+        std::sort(collapses.begin(), collapses.end(), [] (Collapse const& lhs, Collapse const& rhs) { return lhs.cost < rhs.cost; });
+
+        std::iota(vertex_remap.begin(), vertex_remap.end(), 0u);
+        std::fill(collapse_locked.begin(), collapse_locked.end(), false);
+
+        auto triangles_left = current.size();
+        auto collapsed = 0;
+        for (auto const& collapse: collapses) {
+            if (triangles_left <= target_triangles) break;
+
+            auto r_from = remap[collapse.from];
+            auto r_to = remap[collapse.to];
+            if (collapse_locked[r_from] || collapse_locked[r_to]) continue;
+            if (simplifier.flips_triangles(current, collapse.from, collapse.to)) continue;
+
+            vertex_remap[collapse.from] = collapse.to;
+            if (simplifier.kind[collapse.from] == Vertex_Kind::seam) {
+                vertex_remap[simplifier.twin[collapse.from]] = simplifier.twin_target(collapse.from, collapse.to);
+            }
+
+            simplifier.quadrics[r_to] += simplifier.quadrics[r_from];
+            collapse_locked[r_from] = true;
+            collapse_locked[r_to] = true;
+
+            // Neighbours of the collapsed vertex are locked too, the flip test above assumed they stay put.
+            for (auto t = simplifier.adjacency_offsets[r_from]; t < simplifier.adjacency_offsets[r_from + 1]; t++) {
+                auto const& triangle = current[simplifier.adjacency[t]];
+                for (auto c = 0; c < 3; c++) collapse_locked[remap[corner(triangle, c)]] = true;
+            }
+
+            triangles_left -= simplifier.kind[collapse.from] == Vertex_Kind::border ? 1 : 2;
+            collapsed++;
+        }
+        if (collapsed == 0) break;
+
+        for (auto& vertex: folded) vertex = vertex_remap[vertex];
+
+        auto write = (size_t) 0;
+        for (auto const& triangle: current) {
+            auto a = vertex_remap[triangle.a];
+            auto b = vertex_remap[triangle.b];
+            auto c = vertex_remap[triangle.c];
+            if (remap[a] == remap[b] || remap[b] == remap[c] || remap[c] == remap[a]) continue;
+            current[write++] = Triangle{a, b, c};
+        }
+        current.resize(write);
+    }
+
+    result.error = float(deviation(simplifier, topology, current, folded));
+    return result;
+}
+
+auto build_lod_chain(Assimp_Model::Mesh& mesh, std::size_t level_count) -> void
+{
+    // Levels that do not shed at least this share of the previous level are not worth a draw range.
+    constexpr auto min_reduction = 0.9;
+    constexpr auto min_triangles = std::size_t{16};
+
+    mesh.lods.clear();
+    mesh.lod_topology.clear();
+    if (mesh.topology.empty()) return;
+
+    mesh.lods.push_back({0, std::uint32_t(mesh.topology.size()), 0.0f});
+
+    auto previous = mesh.topology;
+    auto error = 0.0f;
+    for (auto level = (size_t) 0; level < level_count; level++) {
+        auto target = previous.size() / 2;
+        if (target < min_triangles) break;
+
+        auto simplified = simplify_mesh(mesh, previous, target, std::numeric_limits<float>::max());
+        if (double(simplified.topology.size()) > double(previous.size()) * min_reduction) break;
+
+        // Each level is simplified from the one before, so the distances add up to one to the full mesh.
+        error += simplified.error;
+
+        // The optimizer works on mesh.topology; lend it the level for the duration.
+        std::swap(mesh.topology, simplified.topology);
+        optimize_vertex_cache(mesh);
+        std::swap(mesh.topology, simplified.topology);
+
+        auto first_triangle = std::uint32_t(mesh.topology.size() + mesh.lod_topology.size());
+        mesh.lods.push_back({first_triangle, std::uint32_t(simplified.topology.size()), error});
+        mesh.lod_topology.insert(mesh.lod_topology.end(), simplified.topology.begin(), simplified.topology.end());
+        previous = std::move(simplified.topology);
+    }
+}
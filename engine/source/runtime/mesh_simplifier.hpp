@@ -0,0 +1,24 @@
+#pragma once
+#include "loader.hpp"
+
+#include <cstddef>
+
+struct Simplify_Result final
+{
+    std::vector<Assimp_Model::Mesh::Triangle> topology;
+    float error{};      // largest distance of an input vertex to the result, in object space units
+};
+
+// Quadric error edge collapse (Garland and Heckbert 1997) of topology over the vertices of mesh,
+// down to target_triangles or until the quadric error of the next collapse exceeds max_error. The
+// error of the result is measured instead, since the quadric error is a mean and not a bound.
+// Every collapse folds a vertex onto a neighbour instead of creating a new one, so the vertex streams
+// stay shared between all levels. Open borders, which includes the borders between meshes of
+// different materials, only collapse along themselves; UV seams collapse both sides at once.
+auto simplify_mesh(Assimp_Model::Mesh const& mesh, std::vector<Assimp_Model::Mesh::Triangle> const& topology,
+                   std::size_t target_triangles, float max_error) -> Simplify_Result;
+
+// Fills mesh.lods and mesh.lod_topology with up to level_count levels below the full mesh, each with
+// half the triangles of the previous one. Stops early once the mesh does not reduce any further.
+// The triangles of every level are ordered for the post-transform cache.
+auto build_lod_chain(Assimp_Model::Mesh& mesh, std::size_t level_count) -> void;
@@ -0,0 +1,131 @@
+#include "meshlet_builder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+inline namespace
+{
+    using Mesh = Assimp_Model::Mesh;
+
+    auto compute_bounds(Mesh const& mesh, Mesh::Meshlet& meshlet) -> void
+    {
+        auto const& position = mesh.vertex_info.position;
+        auto vertices = &mesh.meshlet_vertices[meshlet.vertex_offset];
+        auto triangles = &mesh.meshlet_triangles[meshlet.triangle_offset];
+
+        auto lower = glm::vec3{std::numeric_limits<float>::max()};
+        auto upper = glm::vec3{std::numeric_limits<float>::lowest()};
+        for (auto i = 0u; i < meshlet.vertex_count; i++) {
+            lower = glm::min(lower, position[vertices[i]]);
+            upper = glm::max(upper, position[vertices[i]]);
+        }
+
+        auto center = (lower + upper) * 0.5f;
+        auto radius = 0.0f;
+        for (auto i = 0u; i < meshlet.vertex_count; i++) {
+            radius = std::max(radius, glm::length(position[vertices[i]] - center));
+        }
+        meshlet.bounding_sphere = glm::vec4{center, radius};
+
+        auto normals = std::vector<glm::vec3>{};
+        normals.reserve(meshlet.triangle_count);
+        auto axis = glm::vec3{0.0f};
+        for (auto t = 0u; t < meshlet.triangle_count; t++) {
+            auto const& a = position[vertices[triangles[t * 3 + 0]]];
+            auto const& b = position[vertices[triangles[t * 3 + 1]]];
+            auto const& c = position[vertices[triangles[t * 3 + 2]]];
+            auto normal = glm::cross(b - a, c - a);
+            auto length = glm::length(normal);
+            if (length <= 0.0f) continue;
+
+            normals.emplace_back(normal / length);
+            axis += normals.back();
+        }
+
+        // A degenerate or wider than hemisphere cone can never be culled: cutoff 1 fails the test for any eye.
+        auto axis_length = glm::length(axis);
+        if (normals.empty() || axis_length <= 0.0f) {
+            meshlet.normal_cone = glm::vec4{0.0f, 0.0f, 0.0f, 1.0f};
+            return;
+        }
+        axis /= axis_length;
+
+        auto min_dot = 1.0f;
+        for (auto const& normal: normals) min_dot = std::min(min_dot, glm::dot(axis, normal));
+
+        if (min_dot <= 0.0f) {
+            meshlet.normal_cone = glm::vec4{axis, 1.0f};
+            return;
+        }
+
+        // The test compares against the sine of the half angle, i.e. the cosine of its complement.
+        meshlet.normal_cone = glm::vec4{axis, std::sqrt(1.0f - min_dot * min_dot)};
+    }
+}
+
+auto build_meshlets(Assimp_Model::Mesh& mesh) -> void
+{
+    constexpr auto unassigned = std::numeric_limits<std::uint8_t>::max();
+    static_assert(max_meshlet_vertices < unassigned, "Local indices must fit into 8 bits.");
+
+    mesh.meshlets.clear();
+    mesh.meshlet_vertices.clear();
+    mesh.meshlet_triangles.clear();
+    if (mesh.topology.empty()) return;
+
+    mesh.meshlets.reserve(mesh.topology.size() / max_meshlet_triangles + 1);
+    mesh.meshlet_vertices.reserve(mesh.topology.size());
+    mesh.meshlet_triangles.reserve(mesh.topology.size() * 3);
+
+    auto local_index = std::vector<std::uint8_t>(mesh.vertex_info.position.size(), unassigned);
+    auto current = Mesh::Meshlet{};
+
+    auto flush = [&] {
+        if (current.triangle_count == 0) return;
+
+        for (auto i = 0u; i < current.vertex_count; i++) {
+            local_index[mesh.meshlet_vertices[current.vertex_offset + i]] = unassigned;
+        }
+        compute_bounds(mesh, current);
+        mesh.meshlets.emplace_back(current);
+
+        current = Mesh::Meshlet{};
+        current.vertex_offset = std::uint32_t(mesh.meshlet_vertices.size());
+        current.triangle_offset = std::uint32_t(mesh.meshlet_triangles.size());
+    };
+
+    for (auto const& triangle: mesh.topology) {
+        auto corners = std::array<std::uint32_t, 3>{triangle.a, triangle.b, triangle.c};
+
+        auto new_vertices = 0u;
+        for (auto vertex: corners) {
+            if (local_index[vertex] == unassigned) new_vertices++;
+        }
+        // Degenerate triangles may list a new vertex twice; counting it twice only makes the check conservative.
+        if (current.vertex_count + new_vertices > max_meshlet_vertices || current.triangle_count + 1 > max_meshlet_triangles) {
+            flush();
+        }
+
+        for (auto vertex: corners) {
+            if (local_index[vertex] == unassigned) {
+                local_index[vertex] = std::uint8_t(current.vertex_count++);
+                mesh.meshlet_vertices.emplace_back(vertex);
+            }
+            mesh.meshlet_triangles.emplace_back(local_index[vertex]);
+        }
+        current.triangle_count++;
+    }
+
+    flush();
+}
+
+auto meshlet_faces_away(Assimp_Model::Mesh::Meshlet const& meshlet, glm::vec3 eye) -> bool
+{
+    auto center = glm::vec3{meshlet.bounding_sphere};
+    auto to_center = center - eye;
+    auto axis = glm::vec3{meshlet.normal_cone};
+
+    return glm::dot(to_center, axis) >= meshlet.normal_cone.w * glm::length(to_center) + meshlet.bounding_sphere.w;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "loader.hpp"
+
+#include <cstddef>
+
+// Sized so one meshlet maps onto one mesh shader / compute workgroup:
+// 64 vertices fit a wave of outputs and 124 triangles keep the local index
+// buffer of a meshlet under 384 bytes.
+constexpr std::size_t max_meshlet_vertices = 64;
+constexpr std::size_t max_meshlet_triangles = 124;
+
+// Splits mesh.topology into meshlets and computes a bounding sphere and a normal
+// cone for each of them. Triangles are taken in topology order, so running the
+// vertex cache optimizer first gives tighter clusters. Purely CPU side.
+auto build_meshlets(Assimp_Model::Mesh& mesh) -> void;
+
+// CPU reference of the per-meshlet cone test a culling pass performs.
+auto meshlet_faces_away(Assimp_Model::Mesh::Meshlet const& meshlet, glm::vec3 eye) -> bool;
@@ -0,0 +1,328 @@
+#include "mip_generator.hpp"
+#include "thread_pool.hpp"
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIPGEN_USE_SSE2 1
+#else
+#define MIPGEN_USE_SSE2 0
+#endif
+
+inline namespace
+{
+    // Linear light is quantized to this many steps before the table lookup that encodes it; near
+    // black one step is a fifth of an sRGB code, so the table never moves a texel by more than one.
+    constexpr std::uint32_t encode_steps = 1u << 14;
+
+    // Aim for this many output texels per task, so small levels do not drown in scheduling.
+    constexpr std::size_t texels_per_task = 1u << 15;
+
+    auto srgb_to_linear(float value) -> float
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    auto linear_to_srgb(float value) -> float
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    auto decode_table() -> std::array<float, 256> const&
+    {
+        static auto const table = [] {
+            auto result = std::array<float, 256>{};
+            for (auto i = (size_t) 0; i < result.size(); i++) result[i] = srgb_to_linear(float(i) / 255.0f);
+            return result;
+        }();
+        return table;
+    }
+
+    auto encode_table() -> std::array<unsigned char, encode_steps + 1> const&
+    {
+        static auto const table = [] {
+            auto result = std::array<unsigned char, encode_steps + 1>{};
+            for (auto i = (size_t) 0; i < result.size(); i++) {
+                result[i] = static_cast<unsigned char>(linear_to_srgb(float(i) / float(encode_steps)) * 255.0f + 0.5f);
+            }
+            return result;
+        }();
+        return table;
+    }
+
+    // Linear light RGBA, four floats per texel.
+    struct Linear_Level final
+    {
+        std::vector<float> texels{};
+        std::uint32_t width{};
+        std::uint32_t height{};
+    };
+
+#if MIPGEN_USE_SSE2
+    using Texel = __m128;
+
+    auto decode(unsigned char const* pixel) -> Texel
+    {
+        auto const& table = decode_table();
+        return _mm_setr_ps(table[pixel[0]], table[pixel[1]], table[pixel[2]], float(pixel[3]) * (1.0f / 255.0f));
+    }
+
+    auto load(float const* texel) -> Texel
+    {
+        return _mm_loadu_ps(texel);
+    }
+
+    auto average(Texel a, Texel b, Texel c, Texel d) -> Texel
+    {
+        return _mm_mul_ps(_mm_add_ps(_mm_add_ps(a, b), _mm_add_ps(c, d)), _mm_set1_ps(0.25f));
+    }
+
+    auto store(Texel texel, float* out, unsigned char* pixel) -> void
+    {
+        _mm_storeu_ps(out, texel);
+
+        // Color becomes a table index, alpha its byte; cvtps rounds to nearest.
+        auto const scale = _mm_setr_ps(float(encode_steps), float(encode_steps), float(encode_steps), 255.0f);
+        auto clamped = _mm_min_ps(_mm_max_ps(texel, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        alignas(16) std::int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_cvtps_epi32(_mm_mul_ps(clamped, scale)));
+
+        auto const& table = encode_table();
+        pixel[0] = table[lanes[0]];
+        pixel[1] = table[lanes[1]];
+        pixel[2] = table[lanes[2]];
+        pixel[3] = static_cast<unsigned char>(lanes[3]);
+    }
+#else
+    using Texel = glm::vec4;
+
+    auto decode(unsigned char const* pixel) -> Texel
+    {
+        auto const& table = decode_table();
+        return Texel{table[pixel[0]], table[pixel[1]], table[pixel[2]], float(pixel[3]) * (1.0f / 255.0f)};
+    }
+
+    auto load(float const* texel) -> Texel
+    {
+        return Texel{texel[0], texel[1], texel[2], texel[3]};
+    }
+
+    auto average(Texel a, Texel b, Texel c, Texel d) -> Texel
+    {
+        return (a + b + c + d) * 0.25f;
+    }
+
+    auto store(Texel texel, float* out, unsigned char* pixel) -> void
+    {
+        auto const& table = encode_table();
+        auto clamped = glm::clamp(texel, 0.0f, 1.0f);
+        for (auto c = 0; c < 4; c++) out[c] = texel[c];
+        for (auto c = 0; c < 3; c++) pixel[c] = table[std::size_t(clamped[c] * float(encode_steps) + 0.5f)];
+        pixel[3] = static_cast<unsigned char>(clamped[3] * 255.0f + 0.5f);
+    }
+#endif
+
+    // One level below a width x height source that fetch(x, y) reads linear texels from, as floats
+    // for the next level and as sRGB bytes for the chain.
+    template <typename Fetch>
+    auto downsample(Fetch const& fetch, std::uint32_t width, std::uint32_t height, Thread_Pool* thread_pool, Linear_Level& linear) -> Texture_Pixels
+    {
+        auto result = Texture_Pixels{};
+        result.width = std::max(width / 2, 1u);
+        result.height = std::max(height / 2, 1u);
+        result.pixels.resize((size_t) result.width * result.height * 4);
+        linear.width = result.width;
+        linear.height = result.height;
+        linear.texels.resize((size_t) result.width * result.height * 4);
+
+        auto rows_per_task = std::max<std::size_t>(1, texels_per_task / result.width);
+        auto task_count = (result.height + rows_per_task - 1) / rows_per_task;
+        for_each_index(thread_pool, task_count, [&] (std::size_t task) {
+            auto last_row = std::min<std::size_t>(result.height, (task + 1) * rows_per_task);
+            for (auto y = std::uint32_t(task * rows_per_task); y < last_row; y++) {
+                auto y0 = std::min(y * 2, height - 1);
+                auto y1 = std::min(y * 2 + 1, height - 1);
+                for (auto x = (std::uint32_t) 0; x < result.width; x++) {
+                    auto x0 = std::min(x * 2, width - 1);
+                    auto x1 = std::min(x * 2 + 1, width - 1);
+                    auto index = ((size_t) y * result.width + x) * 4;
+                    store(average(fetch(x0, y0), fetch(x1, y0), fetch(x0, y1), fetch(x1, y1)), linear.texels.data() + index, result.pixels.data() + index);
+                }
+            }
+        });
+        return result;
+    }
+
+    // Largest difference of any channel between two chains, in 8-bit codes.
+    auto largest_difference(std::vector<Texture_Pixels> const& a, std::vector<Texture_Pixels> const& b) -> int
+    {
+        if (a.size() != b.size()) return 255;
+        auto difference = 0;
+        for (auto level = (size_t) 0; level < a.size(); level++) {
+            if (a[level].pixels.size() != b[level].pixels.size()) return 255;
+            for (auto i = (size_t) 0; i < a[level].pixels.size(); i++) {
+                difference = std::max(difference, std::abs(int(a[level].pixels[i]) - int(b[level].pixels[i])));
+            }
+        }
+        return difference;
+    }
+
+    // Each level resized from the one above with stb_image_resize: box filter, sRGB color, linear
+    // alpha. Alpha counts as premultiplied so it does not weight color, the same as the box above.
+    auto generate_mip_chain_stb(Texture_Pixels const& source) -> std::vector<Texture_Pixels>
+    {
+        auto chain = std::vector<Texture_Pixels>{};
+        chain.emplace_back(source);
+        while (chain.back().width > 1 || chain.back().height > 1) {
+            auto const& above = chain.back();
+            auto level = Texture_Pixels{};
+            level.width = std::max(above.width / 2, 1u);
+            level.height = std::max(above.height / 2, 1u);
+            level.pixels.resize((size_t) level.width * level.height * 4);
+            auto resized = stbir_resize_uint8_generic(
+                above.pixels.data(), int(above.width), int(above.height), 0,
+                level.pixels.data(), int(level.width), int(level.height), 0,
+                4, 3, STBIR_FLAG_ALPHA_PREMULTIPLIED, STBIR_EDGE_CLAMP, STBIR_FILTER_BOX, STBIR_COLORSPACE_SRGB, nullptr
+            );
+            if (!resized) {
+                throw std::runtime_error("failed to resize texture level!");
+            }
+            chain.emplace_back(std::move(level));
+        }
+        return chain;
+    }
+}
+
+auto generate_mip_chain(Texture_Pixels const& source, Thread_Pool* thread_pool) -> std::vector<Texture_Pixels>
+{
+    auto chain = std::vector<Texture_Pixels>{};
+    chain.emplace_back(source);
+    if (source.width <= 1 && source.height <= 1) return chain;
+
+    // The source is decoded while it is filtered, so no float copy of the largest level is made.
+    auto linear = Linear_Level{};
+    chain.emplace_back(downsample([&] (std::uint32_t x, std::uint32_t y) {
+        return decode(source.pixels.data() + ((size_t) y * source.width + x) * 4);
+    }, source.width, source.height, thread_pool, linear));
+
+    auto next = Linear_Level{};
+    while (chain.back().width > 1 || chain.back().height > 1) {
+        chain.emplace_back(downsample([&] (std::uint32_t x, std::uint32_t y) {
+            return load(linear.texels.data() + ((size_t) y * linear.width + x) * 4);
+        }, linear.width, linear.height, thread_pool, next));
+        std::swap(linear, next);
+    }
+    return chain;
+}
+
+auto generate_mip_chain_reference(Texture_Pixels const& source) -> std::vector<Texture_Pixels>
+{
+    auto chain = std::vector<Texture_Pixels>{};
+    chain.emplace_back(source);
+
+    auto linear = std::vector<float>(source.pixels.size());
+    for (auto i = (size_t) 0; i < linear.size(); i++) {
+        auto value = float(source.pixels[i]) / 255.0f;
+        linear[i] = i % 4 == 3 ? value : srgb_to_linear(value);
+    }
+
+    auto width = source.width;
+    auto height = source.height;
+    while (width > 1 || height > 1) {
+        auto level = Texture_Pixels{};
+        level.width = std::max(width / 2, 1u);
+        level.height = std::max(height / 2, 1u);
+        level.pixels.resize((size_t) level.width * level.height * 4);
+        auto next = std::vector<float>(level.pixels.size());
+
+        for (auto y = (std::uint32_t) 0; y < level.height; y++) {
+            auto y0 = std::min(y * 2, height - 1);
+            auto y1 = std::min(y * 2 + 1, height - 1);
+            for (auto x = (std::uint32_t) 0; x < level.width; x++) {
+                auto x0 = std::min(x * 2, width - 1);
+                auto x1 = std::min(x * 2 + 1, width - 1);
+                auto texel = [&] (std::uint32_t tx, std::uint32_t ty) { return linear.data() + ((size_t) ty * width + tx) * 4; };
+                for (auto c = 0; c < 4; c++) {
+                    auto value = (texel(x0, y0)[c] + texel(x1, y0)[c] + texel(x0, y1)[c] + texel(x1, y1)[c]) * 0.25f;
+                    auto index = ((size_t) y * level.width + x) * 4 + c;
+                    next[index] = value;
+                    auto encoded = c == 3 ? value : linear_to_srgb(std::clamp(value, 0.0f, 1.0f));
+                    level.pixels[index] = static_cast<unsigned char>(encoded * 255.0f + 0.5f);
+                }
+            }
+        }
+
+        linear = std::move(next);
+        width = level.width;
+        height = level.height;
+        chain.emplace_back(std::move(level));
+    }
+    return chain;
+}
+
+auto benchmark_mip_generation(std::string const& path, std::uint32_t size, Thread_Pool& thread_pool) -> void
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    auto source = Texture_Pixels{};
+    if (!path.empty()) {
+        source = load_texture_pixels(path);
+    } else {
+        // Smooth gradients with noise on top, and an alpha ramp, so every channel is exercised.
+        auto random = std::mt19937{42};
+        auto noise = std::uniform_int_distribution<int>{-24, 24};
+        source.width = size;
+        source.height = size;
+        source.pixels.resize((size_t) size * size * 4);
+        for (auto y = (std::uint32_t) 0; y < size; y++) {
+            for (auto x = (std::uint32_t) 0; x < size; x++) {
+                auto pixel = source.pixels.data() + ((size_t) y * size + x) * 4;
+                pixel[0] = static_cast<unsigned char>(std::clamp(int(x * 255 / size) + noise(random), 0, 255));
+                pixel[1] = static_cast<unsigned char>(std::clamp(int(y * 255 / size) + noise(random), 0, 255));
+                pixel[2] = static_cast<unsigned char>(std::clamp(int((x ^ y) & 255) + noise(random), 0, 255));
+                pixel[3] = static_cast<unsigned char>((x + y) * 255 / (2 * size));
+            }
+        }
+    }
+
+    // Enough repetitions for roughly 16 million source texels per variant.
+    auto const texels = double(source.width) * source.height;
+    auto const repetitions = std::max<std::size_t>(1, std::size_t((1u << 24) / std::max(texels, 1.0)));
+
+    auto time = [&] (auto&& generate, std::vector<Texture_Pixels>& result) {
+        auto start = Clock::now();
+        for (auto i = (size_t) 0; i < repetitions; i++) result = generate();
+        auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return seconds > 0.0 ? double(repetitions) * texels / seconds / 1e6 : 0.0;
+    };
+
+    auto serial = std::vector<Texture_Pixels>{};
+    auto parallel = std::vector<Texture_Pixels>{};
+    auto reference = std::vector<Texture_Pixels>{};
+    auto stb = std::vector<Texture_Pixels>{};
+    auto serial_rate = time([&] { return generate_mip_chain(source, nullptr); }, serial);
+    auto parallel_rate = time([&] { return generate_mip_chain(source, &thread_pool); }, parallel);
+    auto reference_rate = time([&] { return generate_mip_chain_reference(source); }, reference);
+    auto stb_rate = time([&] { return generate_mip_chain_stb(source); }, stb);
+
+    std::cout << "Mip chain of " << source.width << "x" << source.height << " (" << serial.size() << " levels), " << repetitions << " times: "
+              << serial_rate << " MP/s (" << (MIPGEN_USE_SSE2 ? "SSE2" : "scalar") << "), "
+              << parallel_rate << " MP/s on " << thread_pool.size() << " threads, "
+              << reference_rate << " MP/s reference, "
+              << stb_rate << " MP/s stb_image_resize" << std::endl;
+    std::cout << "Largest difference in 8-bit codes: " << largest_difference(serial, parallel) << " serial vs parallel, "
+              << largest_difference(serial, reference) << " vs reference, "
+              << largest_difference(serial, stb) << " vs stb_image_resize" << std::endl;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "texture_cooker.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class Thread_Pool;
+
+// The full mip chain of an sRGB texture, the source first and 1x1 last. Every level is a 2x2 box
+// filter of the one above, averaged in linear light: color is decoded once into a float image, each
+// texel filtered four channels at a time in SIMD lanes and encoded back to sRGB. Alpha stays
+// linear. An odd last row or column is averaged with itself. Rows of a level are split across the
+// pool when one is given; levels depend on each other, so they are built one after another.
+auto generate_mip_chain(Texture_Pixels const& source, Thread_Pool* thread_pool = nullptr) -> std::vector<Texture_Pixels>;
+
+// Reference for generate_mip_chain(): the same filter one channel at a time with std::pow.
+auto generate_mip_chain_reference(Texture_Pixels const& source) -> std::vector<Texture_Pixels>;
+
+// Times generate_mip_chain() serially and on the pool against the reference and stb_image_resize's
+// sRGB box filter, and logs megapixels of source per second plus the largest difference of any
+// channel in 8-bit codes. Uses a generated size x size image when path is empty. stb's box covers
+// the whole source of an odd level, so only power-of-two sizes compare evenly with it.
+auto benchmark_mip_generation(std::string const& path, std::uint32_t size, Thread_Pool& thread_pool) -> void;
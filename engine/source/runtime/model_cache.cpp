@@ -0,0 +1,316 @@
+#include "model_cache.hpp"
+#include "mapped_file.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+inline namespace
+{
+    struct Cooked_Header final
+    {
+        std::uint32_t magic{};
+        std::uint32_t version{};
+        std::uint64_t key{};
+        std::uint64_t payload_size{};
+    };
+
+    struct Writer final
+    {
+        std::vector<char> bytes;
+
+        template <typename T>
+        auto write(T const& value) -> void
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be cooked.");
+            auto src = reinterpret_cast<char const*>(&value);
+            bytes.insert(bytes.end(), src, src + sizeof(T));
+        }
+
+        template <typename T>
+        auto write_array(std::vector<T> const& values) -> void
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be cooked.");
+            write(std::uint64_t(values.size()));
+            auto src = reinterpret_cast<char const*>(values.data());
+            bytes.insert(bytes.end(), src, src + values.size() * sizeof(T));
+        }
+
+        auto write_string(std::string const& value) -> void
+        {
+            write(std::uint32_t(value.size()));
+            bytes.insert(bytes.end(), value.begin(), value.end());
+        }
+    };
+
+    // Bounds-checked cursor over the mapped file; a short read means the file is corrupt.
+    struct Reader final
+    {
+        std::byte const* cursor{};
+        std::byte const* end{};
+
+        auto take(std::size_t size) -> std::byte const*
+        {
+            if (size > std::size_t(end - cursor)) {
+                throw std::runtime_error("cooked model is truncated");
+            }
+            auto result = cursor;
+            cursor += size;
+            return result;
+        }
+
+        template <typename T>
+        auto read() -> T
+        {
+            auto value = T{};
+            std::memcpy(&value, take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        // Every element takes at least one byte, so a count larger than what is left is corrupt.
+        auto read_count(std::size_t element_size = 1) -> std::size_t
+        {
+            auto count = read<std::uint64_t>();
+            if (count > std::size_t(end - cursor) / element_size) {
+                throw std::runtime_error("cooked model is truncated");
+            }
+            return std::size_t(count);
+        }
+
+        template <typename T>
+        auto read_array(std::vector<T>& values) -> void
+        {
+            values.resize(read_count(sizeof(T)));
+            if (!values.empty()) std::memcpy(values.data(), take(values.size() * sizeof(T)), values.size() * sizeof(T));
+        }
+
+        auto read_string() -> std::string
+        {
+            auto size = read<std::uint32_t>();
+            auto src = reinterpret_cast<char const*>(take(size));
+            return std::string{src, src + size};
+        }
+    };
+
+    auto write_model(Writer& writer, Assimp_Model const& model) -> void
+    {
+        writer.write(std::uint64_t(model.nodes.size()));
+        for (auto const& node: model.nodes) {
+            writer.write(node.parent);
+            writer.write(node.transformation);
+            writer.write_string(node.name);
+            writer.write(node.world_bounds);
+        }
+
+        writer.write(std::uint64_t(model.meshes.size()));
+        for (auto const& mesh: model.meshes) {
+            writer.write(mesh.parent);
+            writer.write(mesh.material);
+            writer.write(mesh.bounds);
+            writer.write_string(mesh.name);
+            writer.write_array(mesh.topology);
+            writer.write_array(mesh.vertex_info.position);
+            writer.write_array(mesh.vertex_info.normal);
+            writer.write_array(mesh.vertex_info.tangent);
+            writer.write_array(mesh.vertex_info.bitangent);
+            writer.write_array(mesh.vertex_info.texcoord);
+            writer.write_array(mesh.vertex_info.color);
+            writer.write_array(mesh.vertex_info.bone_indices);
+            writer.write_array(mesh.vertex_info.bone_weights);
+            writer.write(std::uint64_t(mesh.bones.size()));
+            for (auto const& bone: mesh.bones) {
+                writer.write(bone.node);
+                writer.write(bone.offset);
+                writer.write_string(bone.name);
+            }
+            writer.write(std::uint64_t(mesh.shape_keys.size()));
+            for (auto const& key: mesh.shape_keys) {
+                writer.write_array(key.vertices);
+                writer.write_array(key.position_deltas);
+                writer.write(key.default_weight);
+                writer.write_string(key.name);
+            }
+            writer.write_array(mesh.meshlets);
+            writer.write_array(mesh.meshlet_vertices);
+            writer.write_array(mesh.meshlet_triangles);
+            writer.write_array(mesh.lods);
+            writer.write_array(mesh.lod_topology);
+        }
+
+        writer.write(std::uint64_t(model.materials.size()));
+        for (auto const& material: model.materials) {
+            writer.write(material.diffuse_color);
+            writer.write(material.specular_color);
+            writer.write(material.ambient_color);
+            writer.write(material.transparent_color);
+            writer.write(material.emissive_color);
+            writer.write(material.shininess);
+            writer.write(material.opacity);
+            writer.write(material.textures);
+            writer.write_string(material.name);
+        }
+
+        writer.write(std::uint64_t(model.textures.size()));
+        for (auto const& texture: model.textures) {
+            writer.write_string(texture);
+        }
+
+        writer.write(std::uint64_t(model.animations.size()));
+        for (auto const& animation: model.animations) {
+            writer.write(animation.duration);
+            writer.write_string(animation.name);
+            writer.write(std::uint64_t(animation.channels.size()));
+            for (auto const& channel: animation.channels) {
+                writer.write(channel.node);
+                writer.write_array(channel.translation_times);
+                writer.write_array(channel.translations);
+                writer.write_array(channel.rotation_times);
+                writer.write_array(channel.rotations);
+                writer.write_array(channel.scale_times);
+                writer.write_array(channel.scales);
+            }
+        }
+    }
+
+    auto read_model(Reader& reader) -> Assimp_Model
+    {
+        auto model = Assimp_Model{};
+
+        model.nodes.resize(reader.read_count());
+        for (auto& node: model.nodes) {
+            node.parent = reader.read<Assimp_Model::Array_Index>();
+            node.transformation = reader.read<glm::mat4>();
+            node.name = reader.read_string();
+            node.world_bounds = reader.read<Assimp_Model::Bounds>();
+        }
+
+        model.meshes.resize(reader.read_count());
+        for (auto& mesh: model.meshes) {
+            mesh.parent = reader.read<Assimp_Model::Array_Index>();
+            mesh.material = reader.read<Assimp_Model::Array_Index>();
+            mesh.bounds = reader.read<Assimp_Model::Bounds>();
+            mesh.name = reader.read_string();
+            reader.read_array(mesh.topology);
+            reader.read_array(mesh.vertex_info.position);
+            reader.read_array(mesh.vertex_info.normal);
+            reader.read_array(mesh.vertex_info.tangent);
+            reader.read_array(mesh.vertex_info.bitangent);
+            reader.read_array(mesh.vertex_info.texcoord);
+            reader.read_array(mesh.vertex_info.color);
+            reader.read_array(mesh.vertex_info.bone_indices);
+            reader.read_array(mesh.vertex_info.bone_weights);
+            mesh.bones.resize(reader.read_count());
+            for (auto& bone: mesh.bones) {
+                bone.node = reader.read<Assimp_Model::Array_Index>();
+                bone.offset = reader.read<glm::mat4>();
+                bone.name = reader.read_string();
+            }
+            mesh.shape_keys.resize(reader.read_count());
+            for (auto& key: mesh.shape_keys) {
+                reader.read_array(key.vertices);
+                reader.read_array(key.position_deltas);
+                key.default_weight = reader.read<float>();
+                key.name = reader.read_string();
+            }
+            reader.read_array(mesh.meshlets);
+            reader.read_array(mesh.meshlet_vertices);
+            reader.read_array(mesh.meshlet_triangles);
+            reader.read_array(mesh.lods);
+            reader.read_array(mesh.lod_topology);
+        }
+
+        model.materials.resize(reader.read_count());
+        for (auto& material: model.materials) {
+            material.diffuse_color = reader.read<glm::vec4>();
+            material.specular_color = reader.read<glm::vec4>();
+            material.ambient_color = reader.read<glm::vec4>();
+            material.transparent_color = reader.read<glm::vec4>();
+            material.emissive_color = reader.read<glm::vec4>();
+            material.shininess = reader.read<float>();
+            material.opacity = reader.read<float>();
+            material.textures = reader.read<Assimp_Model::Texture_Slots>();
+            material.name = reader.read_string();
+        }
+
+        model.textures.resize(reader.read_count());
+        for (auto& texture: model.textures) {
+            texture = reader.read_string();
+        }
+
+        model.animations.resize(reader.read_count());
+        for (auto& animation: model.animations) {
+            animation.duration = reader.read<float>();
+            animation.name = reader.read_string();
+            animation.channels.resize(reader.read_count());
+            for (auto& channel: animation.channels) {
+                channel.node = reader.read<Assimp_Model::Array_Index>();
+                reader.read_array(channel.translation_times);
+                reader.read_array(channel.translations);
+                reader.read_array(channel.rotation_times);
+                reader.read_array(channel.rotations);
+                reader.read_array(channel.scale_times);
+                reader.read_array(channel.scales);
+            }
+        }
+
+        return model;
+    }
+}
+
+auto cooked_model_key(void const* source, std::size_t source_size, std::uint32_t post_process, std::uint32_t processing) -> std::uint64_t
+{
+    auto key = hash_bytes(source, source_size, cooked_model_version);
+    key = hash_bytes(&post_process, sizeof(post_process), key);
+    return hash_bytes(&processing, sizeof(processing), key);
+}
+
+auto cooked_model_path(std::string const& cache_dir, std::string const& source_path) -> std::string
+{
+    // The path hash keeps same-named assets from different folders apart.
+    auto path_hash = hash_bytes(source_path.data(), source_path.size());
+    auto name = std::stringstream{};
+    name << std::filesystem::path{source_path}.filename().string() << '.' << std::hex << path_hash << ".cooked";
+    return (std::filesystem::path{cache_dir} / name.str()).string();
+}
+
+auto load_cooked_model(std::string const& cooked_path, std::uint64_t key) -> std::optional<Assimp_Model>
+{
+    auto file = Mapped_File{cooked_path};
+    if (!file.valid() || file.size() < sizeof(Cooked_Header)) {
+        return std::nullopt;
+    }
+
+    auto header = Cooked_Header{};
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != cooked_model_magic || header.version != cooked_model_version || header.key != key) {
+        return std::nullopt;
+    }
+    if (header.payload_size != file.size() - sizeof(header)) {
+        std::cout << "Ignoring truncated cooked model " << cooked_path << std::endl;
+        return std::nullopt;
+    }
+
+    auto reader = Reader{file.data() + sizeof(header), file.data() + file.size()};
+    try {
+        return read_model(reader);
+    } catch (std::runtime_error const& e) {
+        std::cout << "Ignoring cooked model " << cooked_path << ": " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+auto save_cooked_model(std::string const& cooked_path, std::uint64_t key, Assimp_Model const& model) -> void
+{
+    auto writer = Writer{};
+    write_model(writer, model);
+
+    auto header = Cooked_Header{cooked_model_magic, cooked_model_version, key, std::uint64_t(writer.bytes.size())};
+
+    write_file_atomically(cooked_path, [&] (std::ostream& file) {
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        file.write(writer.bytes.data(), std::streamsize(writer.bytes.size()));
+    });
+}
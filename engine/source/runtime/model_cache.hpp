@@ -0,0 +1,23 @@
+#pragma once
+#include "loader.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// Cooked model files start with a fixed header followed by the model blocks.
+// Vertex and index arrays are stored exactly as they sit in memory, so a warm
+// load is one mmap plus one memcpy per attribute stream.
+// Bump the version whenever the layout of Assimp_Model or of the file changes, or what processing stores in it.
+constexpr std::uint32_t cooked_model_magic = 0x4c444d43; // "CMDL"
+constexpr std::uint32_t cooked_model_version = 10;
+
+// Identifies one cooked variant of a source asset: content hash of the source
+// file's bytes mixed with everything that changes the imported result, i.e. the
+// Assimp post-process flags and the engine's own processing steps.
+auto cooked_model_key(void const* source, std::size_t source_size, std::uint32_t post_process, std::uint32_t processing) -> std::uint64_t;
+auto cooked_model_path(std::string const& cache_dir, std::string const& source_path) -> std::string;
+
+// Returns std::nullopt on a miss: no file, other version, other key or a truncated file.
+auto load_cooked_model(std::string const& cooked_path, std::uint64_t key) -> std::optional<Assimp_Model>;
+auto save_cooked_model(std::string const& cooked_path, std::uint64_t key, Assimp_Model const& model) -> void;
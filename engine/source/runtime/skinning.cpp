@@ -0,0 +1,104 @@
+#include "skinning.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+auto pack_bone_influences(Assimp_Model::Mesh& mesh, std::vector<Bone_Weight> const& weights) -> void
+{
+    auto& vertex_info = mesh.vertex_info;
+    auto const vertex_count = vertex_info.position.size();
+
+    if (mesh.bones.size() > max_skin_bones) {
+        std::cout << mesh.name << " has " << mesh.bones.size() << " bones, more than " << max_skin_bones
+                  << " can be indexed, it will not be skinned" << std::endl;
+        mesh.bones.clear();
+        vertex_info.bone_indices.clear();
+        vertex_info.bone_weights.clear();
+        return;
+    }
+
+    using Influences = std::array<Bone_Weight, max_bone_influences>;
+    auto strongest = std::vector<Influences>(vertex_count);
+
+    // Insertion into a sorted array of four, the weakest falls off the end.
+    for (auto const& weight: weights) {
+        if (weight.vertex >= vertex_count || weight.bone >= mesh.bones.size() || !(weight.weight > 0.0f)) continue;
+        auto& influences = strongest[weight.vertex];
+        auto slot = max_bone_influences;
+        while (slot > 0 && influences[slot - 1].weight < weight.weight) slot--;
+        if (slot == max_bone_influences) continue;
+        std::move_backward(influences.begin() + slot, influences.end() - 1, influences.end());
+        influences[slot] = weight;
+    }
+
+    vertex_info.bone_indices.assign(vertex_count, glm::u8vec4{0});
+    vertex_info.bone_weights.assign(vertex_count, glm::u8vec4{0});
+
+    for (auto v = (size_t) 0; v < vertex_count; v++) {
+        auto const& influences = strongest[v];
+        auto total = 0.0f;
+        for (auto const& influence: influences) total += influence.weight;
+        if (total <= 0.0f) continue;
+
+        // Rounding may leave the sum off by a few steps; the strongest influence absorbs it,
+        // so every skinned vertex is an exact affine combination.
+        auto quantized = std::array<int, max_bone_influences>{};
+        auto sum = 0;
+        for (auto i = (size_t) 0; i < max_bone_influences; i++) {
+            quantized[i] = int(std::lround(influences[i].weight / total * 255.0f));
+            sum += quantized[i];
+        }
+        quantized[0] += 255 - sum;
+
+        for (auto i = (size_t) 0; i < max_bone_influences; i++) {
+            vertex_info.bone_indices[v][i] = std::uint8_t(influences[i].bone);
+            vertex_info.bone_weights[v][i] = std::uint8_t(quantized[i]);
+        }
+    }
+}
+
+auto bind_bones_to_nodes(Assimp_Model& model) -> void
+{
+    auto node_by_name = std::unordered_map<std::string, Assimp_Model::Array_Index>{};
+    for (auto i = (size_t) 0; i < model.nodes.size(); i++) {
+        node_by_name.emplace(model.nodes[i].name, Assimp_Model::Array_Index(i));
+    }
+
+    for (auto& mesh: model.meshes) {
+        for (auto& bone: mesh.bones) {
+            auto node = node_by_name.find(bone.name);
+            if (node == node_by_name.end()) {
+                std::cout << mesh.name << ": no node for bone " << bone.name << std::endl;
+                continue;
+            }
+            bone.node = node->second;
+        }
+    }
+}
+
+auto compute_skin_matrices(Assimp_Model::Mesh const& mesh, Transform_Hierarchy const& hierarchy, glm::mat4* matrices) -> void
+{
+    auto to_mesh_space = mesh.parent >= 0 ? glm::inverse(hierarchy.world(mesh.parent)) : glm::mat4{1.0f};
+    for (auto i = (size_t) 0; i < mesh.bones.size(); i++) {
+        auto const& bone = mesh.bones[i];
+        matrices[i] = bone.node >= 0 ? to_mesh_space * hierarchy.world(bone.node) * bone.offset : glm::mat4{1.0f};
+    }
+}
+
+auto skin_position(Assimp_Model::Mesh const& mesh, glm::mat4 const* matrices, std::size_t vertex) -> glm::vec3
+{
+    auto const& position = mesh.vertex_info.position[vertex];
+    if (mesh.vertex_info.bone_weights.empty()) return position;
+
+    auto indices = mesh.vertex_info.bone_indices[vertex];
+    auto weights = glm::vec4{mesh.vertex_info.bone_weights[vertex]} / 255.0f;
+    if (weights.x + weights.y + weights.z + weights.w <= 0.0f) return position;
+
+    auto skin = matrices[indices.x] * weights.x + matrices[indices.y] * weights.y
+              + matrices[indices.z] * weights.z + matrices[indices.w] * weights.w;
+    return glm::vec3{skin * glm::vec4{position, 1.0f}};
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "loader.hpp"
+#include "transform_hierarchy.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr std::size_t max_bone_influences = 4;
+constexpr std::size_t max_skin_bones = 256;     // bone indices are stored in one byte
+
+// One weight of one bone on one vertex, as the importers read them.
+struct Bone_Weight final
+{
+    std::uint32_t vertex{};
+    std::uint32_t bone{};       // index for Mesh::bones
+    float weight{};
+};
+
+// Keeps the four strongest influences of every vertex, renormalizes them and fills the
+// bone_indices and bone_weights streams of the mesh. Vertices without any influence get
+// all zero weights and keep their rest position. Meshes with more bones than fit in a byte
+// lose their skin, which is logged.
+auto pack_bone_influences(Assimp_Model::Mesh& mesh, std::vector<Bone_Weight> const& weights) -> void;
+
+// Resolves Bone::node of every mesh through the node names.
+auto bind_bones_to_nodes(Assimp_Model& model) -> void;
+
+// Bone palette of mesh in the current pose, mapping bind pose positions into the space of the
+// mesh node, so the draw still applies the node transform on top.
+auto compute_skin_matrices(Assimp_Model::Mesh const& mesh, Transform_Hierarchy const& hierarchy, glm::mat4* matrices) -> void;
+
+// Reference for skinning.comp.
+auto skin_position(Assimp_Model::Mesh const& mesh, glm::mat4 const* matrices, std::size_t vertex) -> glm::vec3;
@@ -0,0 +1,282 @@
+#include "tangent_frames.hpp"
+#include "mesh_processing.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+inline namespace
+{
+    using Mesh = Assimp_Model::Mesh;
+
+    // Large enough to amortize handing out a chunk, small enough to balance one huge mesh over the pool.
+    constexpr std::size_t items_per_chunk = 16384;
+
+    // Runs body(first, last) over [0, count) in fixed size chunks, on the pool when one was given.
+    auto for_each_chunk(Thread_Pool* thread_pool, std::size_t count, std::function<void(std::size_t, std::size_t)> const& body) -> void
+    {
+        auto chunk_count = (count + items_per_chunk - 1) / items_per_chunk;
+        for_each_index(thread_pool, chunk_count, [&] (std::size_t chunk) {
+            body(chunk * items_per_chunk, std::min(count, (chunk + 1) * items_per_chunk));
+        });
+    }
+
+    auto corner_vertex(std::vector<Mesh::Triangle> const& topology, std::size_t corner) -> std::uint32_t
+    {
+        auto const& triangle = topology[corner / 3];
+        switch (corner % 3) {
+            case 0: return triangle.a;
+            case 1: return triangle.b;
+            default: return triangle.c;
+        }
+    }
+
+    auto corner_vertex(std::vector<Mesh::Triangle>& topology, std::size_t corner) -> std::uint32_t&
+    {
+        auto& triangle = topology[corner / 3];
+        switch (corner % 3) {
+            case 0: return triangle.a;
+            case 1: return triangle.b;
+            default: return triangle.c;
+        }
+    }
+
+    // The corners (triangle * 3 + slot) of every slot in ascending order, at
+    // corners[offsets[slot]] up to corners[offsets[slot + 1]]. A slot is a vertex or a group of them.
+    struct Slot_Corners final
+    {
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> corners;
+    };
+
+    template <typename Slot_Of>
+    auto collect_corners(std::vector<Mesh::Triangle> const& topology, std::size_t slot_count, Slot_Of&& slot_of) -> Slot_Corners
+    {
+        auto result = Slot_Corners{};
+        result.offsets.assign(slot_count + 1, 0);
+        for (auto corner = (size_t) 0; corner < topology.size() * 3; corner++) {
+            result.offsets[slot_of(corner_vertex(topology, corner)) + 1]++;
+        }
+        std::partial_sum(result.offsets.begin(), result.offsets.end(), result.offsets.begin());
+
+        auto next = std::vector<std::uint32_t>(result.offsets.begin(), result.offsets.end() - 1);
+        result.corners.resize(topology.size() * 3);
+        for (auto corner = (size_t) 0; corner < topology.size() * 3; corner++) {
+            result.corners[next[slot_of(corner_vertex(topology, corner))]++] = std::uint32_t(corner);
+        }
+        return result;
+    }
+
+    auto angle_between(glm::vec3 a, glm::vec3 b) -> float
+    {
+        auto lengths = glm::length(a) * glm::length(b);
+        if (lengths <= 0.0f) return 0.0f;
+        return std::acos(std::clamp(glm::dot(a, b) / lengths, -1.0f, 1.0f));
+    }
+
+    // The angle the triangle spans at the corner.
+    auto corner_angle(std::vector<glm::vec3> const& position, std::vector<Mesh::Triangle> const& topology, std::size_t corner) -> float
+    {
+        auto first = corner - corner % 3;
+        auto at = position[corner_vertex(topology, corner)];
+        auto next = position[corner_vertex(topology, first + (corner + 1) % 3)];
+        auto previous = position[corner_vertex(topology, first + (corner + 2) % 3)];
+        return angle_between(next - at, previous - at);
+    }
+
+    // Any unit vector perpendicular to normal, for vertices without texture coordinate derivatives.
+    auto any_perpendicular(glm::vec3 normal) -> glm::vec3
+    {
+        auto axis = std::abs(normal.x) < 0.9f ? glm::vec3{1.0f, 0.0f, 0.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+        return glm::normalize(axis - normal * glm::dot(normal, axis));
+    }
+
+    enum Orientation : std::uint8_t
+    {
+        mirrored,       // texture space has the opposite handedness of the triangle
+        preserved,
+        degenerate,     // no texture area, takes whatever the vertex's other triangles have
+    };
+}
+
+auto Tangent_Frame_Stats::operator+=(Tangent_Frame_Stats const& other) -> Tangent_Frame_Stats&
+{
+    normal_meshes += other.normal_meshes;
+    tangent_meshes += other.tangent_meshes;
+    split_vertices += other.split_vertices;
+    return *this;
+}
+
+auto generate_normals(Assimp_Model::Mesh& mesh, Thread_Pool* thread_pool) -> void
+{
+    auto const& position = mesh.vertex_info.position;
+    auto const& topology = mesh.topology;
+    auto vertex_count = position.size();
+
+    // Vertices at the same position form a group, numbered in order of position then index.
+    auto order = std::vector<std::uint32_t>(vertex_count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&] (std::uint32_t lhs, std::uint32_t rhs) {
+        auto const& a = position[lhs];
+        auto const& b = position[rhs];
+        if (a.x != b.x) return a.x < b.x;
+        if (a.y != b.y) return a.y < b.y;
+        if (a.z != b.z) return a.z < b.z;
+        return lhs < rhs;
+    });
+    auto group_of = std::vector<std::uint32_t>(vertex_count);
+    auto group_count = (size_t) 0;
+    for (auto i = (size_t) 0; i < vertex_count; i++) {
+        if (i > 0 && position[order[i]] != position[order[i - 1]]) group_count++;
+        group_of[order[i]] = std::uint32_t(group_count);
+    }
+    if (vertex_count > 0) group_count++;
+
+    auto face_normals = std::vector<glm::vec3>(topology.size());
+    for_each_chunk(thread_pool, topology.size(), [&] (std::size_t first, std::size_t last) {
+        for (auto t = first; t < last; t++) {
+            auto const& triangle = topology[t];
+            auto normal = glm::cross(position[triangle.b] - position[triangle.a], position[triangle.c] - position[triangle.a]);
+            auto length = glm::length(normal);
+            face_normals[t] = length > 0.0f ? normal / length : glm::vec3{0.0f};
+        }
+    });
+
+    auto groups = collect_corners(topology, group_count, [&] (std::uint32_t vertex) { return group_of[vertex]; });
+    auto group_normals = std::vector<glm::vec3>(group_count);
+    for_each_chunk(thread_pool, group_count, [&] (std::size_t first, std::size_t last) {
+        for (auto group = first; group < last; group++) {
+            auto sum = glm::vec3{0.0f};
+            for (auto i = groups.offsets[group]; i < groups.offsets[group + 1]; i++) {
+                auto corner = groups.corners[i];
+                sum += face_normals[corner / 3] * corner_angle(position, topology, corner);
+            }
+            auto length = glm::length(sum);
+            group_normals[group] = length > 0.0f ? sum / length : glm::vec3{0.0f, 0.0f, 1.0f};
+        }
+    });
+
+    auto& normal = mesh.vertex_info.normal;
+    normal.resize(vertex_count);
+    for (auto v = (size_t) 0; v < vertex_count; v++) normal[v] = group_normals[group_of[v]];
+}
+
+auto generate_tangents(Assimp_Model::Mesh& mesh, Thread_Pool* thread_pool) -> std::size_t
+{
+    auto& vertex_info = mesh.vertex_info;
+    auto& topology = mesh.topology;
+    auto vertex_count = vertex_info.position.size();
+    if (vertex_info.normal.size() != vertex_count || vertex_info.texcoord.size() != vertex_count) return 0;
+
+    // Per triangle, the direction in which u grows, flipped on mirrored triangles.
+    auto face_tangents = std::vector<glm::vec3>(topology.size());
+    auto face_orientations = std::vector<Orientation>(topology.size());
+    for_each_chunk(thread_pool, topology.size(), [&] (std::size_t first, std::size_t last) {
+        auto const& position = vertex_info.position;
+        auto const& texcoord = vertex_info.texcoord;
+        for (auto t = first; t < last; t++) {
+            auto const& triangle = topology[t];
+            auto d1 = position[triangle.b] - position[triangle.a];
+            auto d2 = position[triangle.c] - position[triangle.a];
+            auto t21 = texcoord[triangle.b] - texcoord[triangle.a];
+            auto t31 = texcoord[triangle.c] - texcoord[triangle.a];
+
+            auto signed_area = t21.x * t31.y - t21.y * t31.x;
+            auto tangent = t31.y * d1 - t21.y * d2;
+            auto length = glm::length(tangent);
+            face_orientations[t] = signed_area == 0.0f ? degenerate : signed_area > 0.0f ? preserved : mirrored;
+            face_tangents[t] = signed_area != 0.0f && length > 0.0f ? tangent * ((signed_area > 0.0f ? 1.0f : -1.0f) / length) : glm::vec3{0.0f};
+        }
+    });
+
+    // Split vertices where both handednesses meet: the mirrored corners move to a copy at the end.
+    auto corners = collect_corners(topology, vertex_count, [] (std::uint32_t vertex) { return vertex; });
+    auto kept = std::vector<std::uint32_t>(vertex_count);
+    std::iota(kept.begin(), kept.end(), 0u);
+    auto signs = std::vector<float>(vertex_count, 1.0f);
+    for (auto v = (size_t) 0; v < vertex_count; v++) {
+        auto has_preserved = false;
+        auto has_mirrored = false;
+        for (auto i = corners.offsets[v]; i < corners.offsets[v + 1]; i++) {
+            auto orientation = face_orientations[corners.corners[i] / 3];
+            has_preserved = has_preserved || orientation == preserved;
+            has_mirrored = has_mirrored || orientation == mirrored;
+        }
+        if (!has_preserved && has_mirrored) signs[v] = -1.0f;
+        if (!has_preserved || !has_mirrored) continue;
+
+        auto copy = std::uint32_t(kept.size());
+        kept.emplace_back(std::uint32_t(v));
+        signs.emplace_back(-1.0f);
+        for (auto i = corners.offsets[v]; i < corners.offsets[v + 1]; i++) {
+            auto corner = corners.corners[i];
+            if (face_orientations[corner / 3] == mirrored) corner_vertex(topology, corner) = copy;
+        }
+    }
+
+    auto split_count = kept.size() - vertex_count;
+    if (split_count > 0) {
+        gather_vertices(mesh, kept);
+        vertex_count = kept.size();
+        corners = collect_corners(topology, vertex_count, [] (std::uint32_t vertex) { return vertex; });
+    }
+
+    vertex_info.tangent.resize(vertex_count);
+    vertex_info.bitangent.resize(vertex_count);
+    for_each_chunk(thread_pool, vertex_count, [&] (std::size_t first, std::size_t last) {
+        for (auto v = first; v < last; v++) {
+            auto normal = vertex_info.normal[v];
+            auto sum = glm::vec3{0.0f};
+            for (auto i = corners.offsets[v]; i < corners.offsets[v + 1]; i++) {
+                auto corner = corners.corners[i];
+                auto tangent = face_tangents[corner / 3];
+                tangent -= normal * glm::dot(normal, tangent);
+                auto length = glm::length(tangent);
+                if (length > 0.0f) sum += tangent * (corner_angle(vertex_info.position, topology, corner) / length);
+            }
+
+            sum -= normal * glm::dot(normal, sum);
+            auto length = glm::length(sum);
+            auto tangent = length > 0.0f ? sum / length : any_perpendicular(normal);
+            vertex_info.tangent[v] = tangent;
+            vertex_info.bitangent[v] = signs[v] * glm::cross(normal, tangent);
+        }
+    });
+
+    return split_count;
+}
+
+auto generate_tangent_frames(Assimp_Model& model, Thread_Pool* thread_pool, bool overwrite) -> Tangent_Frame_Stats
+{
+    auto mesh_stats = std::vector<Tangent_Frame_Stats>(model.meshes.size());
+    for_each_index(thread_pool, model.meshes.size(), [&] (std::size_t i) {
+        auto& mesh = model.meshes[i];
+        auto const& vertex_info = mesh.vertex_info;
+        auto vertex_count = vertex_info.position.size();
+        auto& stats = mesh_stats[i];
+
+        // New normals invalidate whatever tangents came with the mesh.
+        auto new_normals = overwrite || vertex_info.normal.size() != vertex_count;
+        if (new_normals) {
+            generate_normals(mesh, thread_pool);
+            stats.normal_meshes = 1;
+        }
+
+        auto missing_tangents = vertex_info.tangent.size() != vertex_count || vertex_info.bitangent.size() != vertex_count;
+        if ((new_normals || missing_tangents) && vertex_info.texcoord.size() == vertex_count) {
+            stats.split_vertices = generate_tangents(mesh, thread_pool);
+            stats.tangent_meshes = 1;
+        } else if (new_normals) {
+            mesh.vertex_info.tangent.clear();
+            mesh.vertex_info.bitangent.clear();
+        }
+    });
+
+    auto stats = Tangent_Frame_Stats{};
+    for (auto const& mesh_stat: mesh_stats) stats += mesh_stat;
+    return stats;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "loader.hpp"
+
+#include <cstddef>
+
+class Thread_Pool;
+
+struct Tangent_Frame_Stats final
+{
+    std::size_t normal_meshes{};        // meshes whose normals were generated
+    std::size_t tangent_meshes{};       // meshes whose tangents and bitangents were generated
+    std::size_t split_vertices{};       // added where mirrored texture coordinates meet
+
+    auto operator+=(Tangent_Frame_Stats const& other) -> Tangent_Frame_Stats&;
+};
+
+// Smooth normals weighted by the angle every triangle spans at the vertex. Vertices at the same
+// position share their normal, so seams in the texture coordinates do not show as creases.
+auto generate_normals(Assimp_Model::Mesh& mesh, Thread_Pool* thread_pool = nullptr) -> void;
+
+// MikkTSpace-like tangents and bitangents: per triangle from the texture coordinate derivatives,
+// projected onto the vertex normal and weighted by the corner angle. Only the handedness split is
+// done: a vertex shared by triangles of opposite handedness is split in two, and the bitangent is
+// sign * cross(normal, tangent). MikkTSpace's grouping of corners into tangent spaces is not, so
+// normal maps baked with it can differ slightly where its groups would have split a vertex. Needs normals and texture coordinates; returns how many vertices the split added.
+// Runs before LODs and meshlets are built, as it appends vertices and rewrites only topology.
+auto generate_tangents(Assimp_Model::Mesh& mesh, Thread_Pool* thread_pool = nullptr) -> std::size_t;
+
+// Generates whatever part of the tangent frame a mesh lacks, or all of it with overwrite.
+// Meshes go to the pool and large meshes split their triangles and vertices over it once more.
+// Every vertex gathers its corners in a fixed order, so the result is bitwise the same for any
+// pool and thread count.
+auto generate_tangent_frames(Assimp_Model& model, Thread_Pool* thread_pool = nullptr, bool overwrite = false) -> Tangent_Frame_Stats;
@@ -0,0 +1,261 @@
+#include "texture_cooker.hpp"
+#include "mapped_file.hpp"
+#include "mip_generator.hpp"
+#include "thread_pool.hpp"
+
+#include <cstring>     // stb_dxt's implementation uses memcpy without including it
+
+#include <stb_image.h>
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <ostream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+inline namespace
+{
+    struct Texture_Header final
+    {
+        std::uint32_t magic{};
+        std::uint32_t version{};
+        std::uint64_t key{};
+        std::uint32_t format{};
+        std::uint32_t width{};
+        std::uint32_t height{};
+        std::uint32_t level_count{};
+    };
+
+    constexpr std::uint64_t level_alignment = 16;
+
+    auto align_up(std::uint64_t value) -> std::uint64_t
+    {
+        return (value + level_alignment - 1) / level_alignment * level_alignment;
+    }
+
+    auto decode_texture_pixels(Mapped_Bytes const& source, std::string const& path) -> Texture_Pixels
+    {
+        auto width = 0;
+        auto height = 0;
+        auto channels = 0;
+        auto pixels = source.valid()
+            ? stbi_load_from_memory(reinterpret_cast<stbi_uc const*>(source.data), int(source.size), &width, &height, &channels, STBI_rgb_alpha)
+            : nullptr;
+        if (!pixels) {
+            throw std::runtime_error("failed to load texture image: " + path + "!");
+        }
+
+        auto texture = Texture_Pixels{};
+        texture.width = static_cast<std::uint32_t>(width);
+        texture.height = static_cast<std::uint32_t>(height);
+        texture.pixels.assign(pixels, pixels + (size_t) width * height * 4);
+        stbi_image_free(pixels);
+        return texture;
+    }
+
+    auto block_size(Texture_Format format) -> std::size_t
+    {
+        return format == Texture_Format::bc1 ? 8 : 16;
+    }
+
+    // Encodes one level into out, a block row at a time; edge blocks repeat the last row and column.
+    auto encode_blocks(Texture_Pixels const& level, Texture_Format format, unsigned char* out, Thread_Pool* thread_pool) -> void
+    {
+        auto blocks_x = (level.width + 3) / 4;
+        auto blocks_y = (level.height + 3) / 4;
+        auto row_bytes = blocks_x * block_size(format);
+
+        for_each_index(thread_pool, blocks_y, [&] (std::size_t block_y) {
+            unsigned char block[16 * 4];
+            for (auto block_x = (std::uint32_t) 0; block_x < blocks_x; block_x++) {
+                for (auto y = 0u; y < 4; y++) {
+                    auto ty = std::min(std::uint32_t(block_y) * 4 + y, level.height - 1);
+                    for (auto x = 0u; x < 4; x++) {
+                        auto tx = std::min(block_x * 4 + x, level.width - 1);
+                        std::memcpy(block + (y * 4 + x) * 4, level.pixels.data() + ((size_t) ty * level.width + tx) * 4, 4);
+                    }
+                }
+                auto dest = out + block_y * row_bytes + block_x * block_size(format);
+                stb_compress_dxt_block(dest, block, format == Texture_Format::bc3 ? 1 : 0, STB_DXT_HIGHQUAL);
+            }
+        });
+    }
+
+    auto describe(Texture_Format format) -> char const*
+    {
+        switch (format) {
+            case Texture_Format::bc1: return "BC1";
+            case Texture_Format::bc3: return "BC3";
+            default: return "RGBA8";
+        }
+    }
+}
+
+auto load_texture_pixels(std::string const& path) -> Texture_Pixels
+{
+    return decode_texture_pixels(map_asset(path), path);
+}
+
+auto texture_level_size(Texture_Format format, std::uint32_t width, std::uint32_t height) -> std::size_t
+{
+    if (format == Texture_Format::rgba8) return (size_t) width * height * 4;
+    return (size_t) ((width + 3) / 4) * ((height + 3) / 4) * block_size(format);
+}
+
+auto cook_texture(Texture_Pixels const& pixels, Texture_Cook_Options const& options) -> Cooked_Texture
+{
+    auto texture = Cooked_Texture{};
+    texture.width = pixels.width;
+    texture.height = pixels.height;
+    texture.format = Texture_Format::rgba8;
+    if (options.compress) {
+        auto opaque = true;
+        for (auto i = (size_t) 3; i < pixels.pixels.size() && opaque; i += 4) opaque = pixels.pixels[i] == 255;
+        texture.format = opaque ? Texture_Format::bc1 : Texture_Format::bc3;
+    }
+
+    auto chain = options.build_mips ? generate_mip_chain(pixels, options.thread_pool) : std::vector<Texture_Pixels>{pixels};
+
+    auto offset = std::uint64_t{0};
+    for (auto const& level: chain) {
+        auto size = texture_level_size(texture.format, level.width, level.height);
+        texture.levels.push_back({offset, size, level.width, level.height});
+        offset = align_up(offset + size);
+    }
+    texture.storage.resize(std::size_t(offset));
+
+    for_each_index(options.thread_pool, chain.size(), [&] (std::size_t i) {
+        auto out = texture.storage.data() + texture.levels[i].offset;
+        if (texture.format == Texture_Format::rgba8) {
+            std::memcpy(out, chain[i].pixels.data(), chain[i].pixels.size());
+        } else {
+            encode_blocks(chain[i], texture.format, out, options.thread_pool);
+        }
+    });
+    return texture;
+}
+
+auto cooked_texture_key(void const* source, std::size_t source_size, Texture_Cook_Options const& options) -> std::uint64_t
+{
+    auto key = hash_bytes(source, source_size, cooked_texture_version);
+    auto flags = std::uint32_t(options.compress ? 1 : 0) | std::uint32_t(options.build_mips ? 2 : 0);
+    return hash_bytes(&flags, sizeof(flags), key);
+}
+
+auto cooked_texture_path(std::string const& cache_dir, std::string const& source_path) -> std::string
+{
+    // The path hash keeps same-named assets from different folders apart.
+    auto path_hash = hash_bytes(source_path.data(), source_path.size());
+    auto name = std::stringstream{};
+    name << std::filesystem::path{source_path}.filename().string() << '.' << std::hex << path_hash << ".ctex";
+    return (std::filesystem::path{cache_dir} / name.str()).string();
+}
+
+auto load_cooked_texture(std::string const& cooked_path, std::uint64_t key) -> std::optional<Cooked_Texture>
+{
+    auto bytes = map_asset(cooked_path);
+    if (!bytes.valid() || bytes.size < sizeof(Texture_Header)) {
+        return std::nullopt;
+    }
+
+    auto header = Texture_Header{};
+    std::memcpy(&header, bytes.data, sizeof(header));
+    if (header.magic != cooked_texture_magic || header.version != cooked_texture_version || header.key != key) {
+        return std::nullopt;
+    }
+
+    auto index_size = (size_t) header.level_count * 2 * sizeof(std::uint64_t);
+    if (header.format > std::uint32_t(Texture_Format::bc3) || bytes.size < sizeof(header) + index_size) {
+        std::cout << "Ignoring truncated cooked texture " << cooked_path << std::endl;
+        return std::nullopt;
+    }
+
+    auto texture = Cooked_Texture{};
+    texture.format = Texture_Format(header.format);
+    texture.width = header.width;
+    texture.height = header.height;
+
+    // Level offsets in the file count from its start, the same bytes data() returns.
+    auto index = bytes.data + sizeof(header);
+    for (auto i = (size_t) 0; i < header.level_count; i++) {
+        auto level = Cooked_Texture::Level{};
+        std::memcpy(&level.offset, index + i * 16, sizeof(level.offset));
+        std::memcpy(&level.size, index + i * 16 + 8, sizeof(level.size));
+        level.width = std::max(header.width >> i, 1u);
+        level.height = std::max(header.height >> i, 1u);
+        if (level.offset > bytes.size || level.size > bytes.size - level.offset || level.size != texture_level_size(texture.format, level.width, level.height)) {
+            std::cout << "Ignoring truncated cooked texture " << cooked_path << std::endl;
+            return std::nullopt;
+        }
+        texture.levels.emplace_back(level);
+    }
+
+    texture.mapped = std::move(bytes);
+    return texture;
+}
+
+auto save_cooked_texture(std::string const& cooked_path, std::uint64_t key, Cooked_Texture const& texture) -> void
+{
+    auto header = Texture_Header{cooked_texture_magic, cooked_texture_version, key, std::uint32_t(texture.format), texture.width, texture.height, std::uint32_t(texture.levels.size())};
+    auto first_level = align_up(sizeof(header) + texture.levels.size() * 2 * sizeof(std::uint64_t));
+
+    write_file_atomically(cooked_path, [&] (std::ostream& file) {
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        for (auto const& level: texture.levels) {
+            auto offset = first_level + level.offset;
+            file.write(reinterpret_cast<char const*>(&offset), sizeof(offset));
+            file.write(reinterpret_cast<char const*>(&level.size), sizeof(level.size));
+        }
+        auto const padding = std::vector<char>(std::size_t(first_level - sizeof(header) - texture.levels.size() * 2 * sizeof(std::uint64_t)), 0);
+        file.write(padding.data(), std::streamsize(padding.size()));
+        file.write(reinterpret_cast<char const*>(texture.data()), std::streamsize(texture.size()));
+    });
+}
+
+auto load_texture(std::string const& path, Texture_Load_Options const& options) -> Cooked_Texture
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    auto start = Clock::now();
+    auto elapsed_ms = [&] { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+    auto report = [&] (Cooked_Texture const& texture, char const* how) {
+        auto rgba_bytes = (size_t) 0;
+        for (auto const& level: texture.levels) rgba_bytes += texture_level_size(Texture_Format::rgba8, level.width, level.height);
+        std::cout << how << " " << path << " in " << elapsed_ms() << " ms: " << texture.width << "x" << texture.height << " " << describe(texture.format)
+                  << ", " << texture.levels.size() << " levels, " << texture.size() << " bytes (" << rgba_bytes << " as RGBA8)" << std::endl;
+    };
+
+    auto source = map_asset(path, options.archive);
+    if (!source.valid()) {
+        throw std::runtime_error("failed to load texture image: " + path + "!");
+    }
+
+    if (options.cache_dir.empty()) {
+        auto texture = cook_texture(decode_texture_pixels(source, path), options.cook);
+        report(texture, "Cooked");
+        return texture;
+    }
+
+    auto key = cooked_texture_key(source.data, source.size, options.cook);
+    auto cooked_path = cooked_texture_path(options.cache_dir, path);
+    if (auto cooked = load_cooked_texture(cooked_path, key)) {
+        report(*cooked, "Loaded cooked");
+        return std::move(*cooked);
+    }
+
+    auto texture = cook_texture(decode_texture_pixels(source, path), options.cook);
+    // The cache only saves time: a read-only or full cache directory must not lose the texture.
+    try {
+        save_cooked_texture(cooked_path, key, texture);
+    } catch (std::exception const& e) {
+        std::cout << "Not caching cooked texture " << cooked_path << ": " << e.what() << std::endl;
+        report(texture, "Cooked");
+        return texture;
+    }
+    report(texture, "Cooked and cached");
+    return texture;
+}
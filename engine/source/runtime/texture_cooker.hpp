@@ -0,0 +1,92 @@
+#pragma once
+#include "asset_archive.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+class Thread_Pool;
+
+// Tightly packed RGBA8 pixels, top row first.
+struct Texture_Pixels final
+{
+    std::vector<unsigned char> pixels;
+    std::uint32_t width{};
+    std::uint32_t height{};
+};
+
+// Decodes an image file with stb_image; throws when it can not be read.
+auto load_texture_pixels(std::string const& path) -> Texture_Pixels;
+
+// How the texels of every level are stored; all of them are sRGB encoded colors.
+enum class Texture_Format: std::uint32_t
+{
+    rgba8,      // 4 bytes per texel
+    bc1,        // 8 bytes per 4x4 block, opaque
+    bc3,        // 16 bytes per 4x4 block, BC1 color plus interpolated alpha
+};
+
+// A texture ready for the GPU: every level back to back in one block of bytes, so uploading is
+// one copy into a staging buffer plus one buffer to image region per level. The bytes either are
+// owned or point into a mapped cooked file.
+struct Cooked_Texture final
+{
+    struct Level final
+    {
+        std::uint64_t offset{};     // from data()
+        std::uint64_t size{};
+        std::uint32_t width{};
+        std::uint32_t height{};
+    };
+
+    Texture_Format format{Texture_Format::rgba8};
+    std::uint32_t width{};
+    std::uint32_t height{};
+    std::vector<Level> levels{};    // largest first
+
+    std::vector<unsigned char> storage{};
+    Mapped_Bytes mapped{};
+
+    auto data() const -> unsigned char const* { return mapped.valid() ? reinterpret_cast<unsigned char const*>(mapped.data) : storage.data(); }
+    auto size() const -> std::size_t { return mapped.valid() ? mapped.size : storage.size(); }
+};
+
+struct Texture_Cook_Options final
+{
+    bool compress{true};                    // BC1, or BC3 when any texel is not opaque; rgba8 otherwise
+    bool build_mips{true};                  // the full chain down to 1x1, otherwise the top level only
+    Thread_Pool* thread_pool{nullptr};      // levels and block rows are encoded in parallel when set
+};
+
+// Bytes of one level in format; block formats round up to whole 4x4 blocks.
+auto texture_level_size(Texture_Format format, std::uint32_t width, std::uint32_t height) -> std::size_t;
+
+// Builds the mip chain with generate_mip_chain() and encodes every level with stb_dxt.
+// BC7 is not offered: stb_dxt only encodes BC1, BC3 and BC4/5.
+auto cook_texture(Texture_Pixels const& pixels, Texture_Cook_Options const& options = {}) -> Cooked_Texture;
+
+// Cooked texture files: a header with magic, version, key, format, size and level count, then
+// offset and size of every level (two uint64_t), then the levels, each aligned to 16 bytes.
+// Bump the version whenever the layout or the cooker's output changes.
+constexpr std::uint32_t cooked_texture_magic = 0x58455443; // "CTEX"
+constexpr std::uint32_t cooked_texture_version = 2;
+
+auto cooked_texture_key(void const* source, std::size_t source_size, Texture_Cook_Options const& options) -> std::uint64_t;
+auto cooked_texture_path(std::string const& cache_dir, std::string const& source_path) -> std::string;
+
+// Returns std::nullopt on a miss: no file, other version, other key or a truncated file. The
+// texture keeps the file mapped and its levels point into the mapping.
+auto load_cooked_texture(std::string const& cooked_path, std::uint64_t key) -> std::optional<Cooked_Texture>;
+auto save_cooked_texture(std::string const& cooked_path, std::uint64_t key, Cooked_Texture const& texture) -> void;
+
+struct Texture_Load_Options final
+{
+    std::string cache_dir{};                // cooked textures are read from and written to here, empty disables the cache
+    Texture_Cook_Options cook{};
+    Asset_Archive const* archive{nullptr};  // searched before the file system
+};
+
+// The cooked texture from the cache when its key matches, otherwise decoded, cooked and cached.
+auto load_texture(std::string const& path, Texture_Load_Options const& options = {}) -> Cooked_Texture;
@@ -0,0 +1,150 @@
+#include "texture_ingest.hpp"
+#include "loader.hpp"
+#include "thread_pool.hpp"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+inline namespace
+{
+    auto asset_exists(std::string const& path, Asset_Archive const* archive) -> bool
+    {
+        if (archive && archive->find(path).valid()) return true;
+        return std::filesystem::is_regular_file(std::filesystem::path{path});
+    }
+
+    // RGBA8 bytes of the image and its mip chain, from the header alone; 0 when it has none.
+    auto estimate_decoded_bytes(std::string const& path, Asset_Archive const* archive) -> std::size_t
+    {
+        auto source = map_asset(path, archive);
+        auto width = 0;
+        auto height = 0;
+        auto channels = 0;
+        if (!source.valid() || !stbi_info_from_memory(reinterpret_cast<stbi_uc const*>(source.data), int(source.size), &width, &height, &channels)) {
+            return 0;
+        }
+        return (size_t) width * height * 4 * 4 / 3;
+    }
+}
+
+auto resolve_texture_path(std::string const& model_path, std::string const& texture_path, Asset_Archive const* archive) -> std::string
+{
+    if (texture_path.empty() || texture_path[0] == '*') return {};
+
+    auto model_dir = std::filesystem::path{model_path}.parent_path();
+    auto relative = (model_dir / texture_path).lexically_normal().generic_string();
+    if (asset_exists(relative, archive)) return relative;
+
+    auto beside = (model_dir / std::filesystem::path{texture_path}.filename()).generic_string();
+    if (asset_exists(beside, archive)) return beside;
+    return {};
+}
+
+Texture_Ingest::Texture_Ingest(Thread_Pool& thread_pool, std::vector<std::string> paths, Texture_Load_Options const& options, std::size_t byte_budget)
+    : thread_pool{thread_pool}
+    , paths{std::move(paths)}
+    , options{options}
+    , byte_budget{byte_budget}
+{
+    start_jobs();
+}
+
+Texture_Ingest::~Texture_Ingest()
+{
+    for (auto& job: jobs) {
+        if (job.result.valid()) job.result.wait();
+    }
+}
+
+auto Texture_Ingest::start_jobs() -> void
+{
+    while (next < paths.size()) {
+        auto bytes = estimate_decoded_bytes(paths[next], options.archive);
+        if (!jobs.empty() && bytes_in_flight + bytes > byte_budget) return;
+
+        auto job = Job{};
+        job.index = next;
+        job.bytes = bytes;
+        job.result = thread_pool.submit([path = paths[next], options = options] () -> std::optional<Cooked_Texture> {
+            try {
+                return load_texture(path, options);
+            } catch (std::exception const& e) {
+                std::cout << e.what() << std::endl;
+                return std::nullopt;
+            }
+        });
+        jobs.emplace_back(std::move(job));
+
+        bytes_in_flight += bytes;
+        peak_bytes = std::max(peak_bytes, bytes_in_flight);
+        next++;
+    }
+}
+
+auto Texture_Ingest::take() -> std::optional<Texture>
+{
+    auto ready = std::find_if(jobs.begin(), jobs.end(), [] (Job const& job) {
+        return job.result.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+    });
+    if (ready == jobs.end()) return std::nullopt;
+
+    auto texture = Texture{};
+    texture.index = ready->index;
+    texture.path = paths[ready->index];
+    texture.texture = ready->result.get();
+    bytes_in_flight -= ready->bytes;
+    jobs.erase(ready);
+    taken++;
+
+    start_jobs();
+    return texture;
+}
+
+auto benchmark_texture_ingest(std::string const& model_path, Thread_Pool& thread_pool) -> void
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    auto model_options = Model_Load_Options{};
+    model_options.thread_pool = &thread_pool;
+    auto model = load_model(model_path, model_options);
+
+    auto paths = std::vector<std::string>{};
+    for (auto const& texture: model.textures) {
+        auto path = resolve_texture_path(model_path, texture);
+        if (path.empty()) {
+            std::cout << "Texture " << texture << " of " << model_path << " not found" << std::endl;
+            continue;
+        }
+        paths.emplace_back(path);
+    }
+
+    auto options = Texture_Load_Options{};
+    auto start = Clock::now();
+    auto serial_bytes = (size_t) 0;
+    for (auto const& path: paths) serial_bytes += load_texture(path, options).size();
+    auto serial_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    options.cook.thread_pool = &thread_pool;
+    start = Clock::now();
+    auto parallel_bytes = (size_t) 0;
+    auto ingest = Texture_Ingest{thread_pool, paths, options, std::size_t(256) << 20};
+    while (!ingest.done()) {
+        if (auto texture = ingest.take()) {
+            if (texture->texture) parallel_bytes += texture->texture->size();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    auto parallel_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::cout << "Texture ingest of " << paths.size() << " of " << model.textures.size() << " textures: "
+              << serial_ms << " ms serial (" << serial_bytes << " bytes), "
+              << parallel_ms << " ms on " << thread_pool.size() << " threads (" << parallel_bytes << " bytes, at most "
+              << ingest.peak_bytes_in_flight() << " decoded bytes in flight), "
+              << (parallel_ms > 0.0 ? serial_ms / parallel_ms : 0.0) << "x" << std::endl;
+}
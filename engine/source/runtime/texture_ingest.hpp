@@ -0,0 +1,68 @@
+#pragma once
+#include "texture_cooker.hpp"
+
+#include <cstddef>
+#include <future>
+#include <optional>
+#include <string>
+#include <vector>
+
+class Thread_Pool;
+
+// Where a texture path as a model stores it can be read: relative to the model, or else by its
+// file name next to the model, since exporters often keep absolute paths of the artist's machine.
+// Empty for embedded textures ("*0") and files that are nowhere to be found.
+auto resolve_texture_path(std::string const& model_path, std::string const& texture_path, Asset_Archive const* archive = nullptr) -> std::string;
+
+// Loads many textures with load_texture() on a thread pool. Decoded images are large, so only as
+// many are started as fit a budget of bytes that are decoded but not taken yet, counted from the
+// image headers before decoding; one always starts, however large. Whoever takes the textures
+// drives it: take() hands over finished ones in completion order and starts the next that fit.
+class Texture_Ingest final
+{
+public:
+    struct Texture final
+    {
+        std::size_t index{};                        // into the paths given
+        std::string path{};
+        std::optional<Cooked_Texture> texture{};    // empty when the file could not be read or decoded
+    };
+
+    Texture_Ingest(Thread_Pool& thread_pool, std::vector<std::string> paths, Texture_Load_Options const& options, std::size_t byte_budget);
+    ~Texture_Ingest();
+
+    Texture_Ingest(Texture_Ingest const&) = delete;
+    auto operator=(Texture_Ingest const&) -> Texture_Ingest& = delete;
+
+    // A finished texture, or nothing while none is; never blocks.
+    auto take() -> std::optional<Texture>;
+
+    auto done() const -> bool { return taken == paths.size(); }
+    auto size() const -> std::size_t { return paths.size(); }
+    auto peak_bytes_in_flight() const -> std::size_t { return peak_bytes; }
+
+private:
+    struct Job final
+    {
+        std::size_t index{};
+        std::size_t bytes{};
+        std::future<std::optional<Cooked_Texture>> result{};
+    };
+
+    auto start_jobs() -> void;
+
+    Thread_Pool& thread_pool;
+    std::vector<std::string> paths{};
+    Texture_Load_Options options{};
+    std::size_t byte_budget{};
+
+    std::vector<Job> jobs{};
+    std::size_t next{0};            // first path not started yet
+    std::size_t taken{0};
+    std::size_t bytes_in_flight{0};
+    std::size_t peak_bytes{0};
+};
+
+// Loads every texture of a model once one at a time and once through Texture_Ingest on the pool,
+// without a cache, and logs both wall times. Decoding and cooking only, there is no device here.
+auto benchmark_texture_ingest(std::string const& model_path, Thread_Pool& thread_pool) -> void;
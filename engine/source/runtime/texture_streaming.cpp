@@ -0,0 +1,146 @@
+#include "texture_streaming.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+auto wanted_mip_level(std::uint32_t width, std::uint32_t height, std::uint32_t level_count, float pixels) -> std::uint32_t
+{
+    if (level_count == 0) return 0;
+    auto coarsest = level_count - 1;
+    if (!(pixels > 0.0f)) return coarsest;
+
+    auto ratio = float(std::max(width, height)) / pixels;
+    if (ratio <= 1.0f) return 0;
+    return std::min(static_cast<std::uint32_t>(std::floor(std::log2(ratio))), coarsest);
+}
+
+Texture_Residency::Texture_Residency(std::uint64_t budget, std::uint32_t tail_size)
+    : budget_bytes{budget}
+    , tail_size{tail_size}
+{
+}
+
+auto Texture_Residency::add(Cooked_Texture const& texture) -> Handle
+{
+    auto entry = Entry{};
+    entry.live = true;
+    for (auto const& level: texture.levels) entry.level_bytes.emplace_back(level.size);
+
+    auto level_count = static_cast<std::uint32_t>(texture.levels.size());
+    entry.tail_level = level_count == 0 ? 0 : level_count - 1;
+    for (auto i = (std::uint32_t) 0; i < level_count; i++) {
+        if (std::max(texture.levels[i].width, texture.levels[i].height) <= tail_size) {
+            entry.tail_level = i;
+            break;
+        }
+    }
+    entry.first_level = entry.tail_level;
+    entry.wanted_level = entry.tail_level;
+    for (auto i = entry.tail_level; i < level_count; i++) resident += entry.level_bytes[i];
+
+    auto free_entry = std::find_if(entries.begin(), entries.end(), [] (Entry const& entry) { return !entry.live; });
+    if (free_entry != entries.end()) {
+        *free_entry = std::move(entry);
+        return static_cast<Handle>(free_entry - entries.begin());
+    }
+    entries.emplace_back(std::move(entry));
+    return entries.size() - 1;
+}
+
+auto Texture_Residency::remove(Handle texture) -> void
+{
+    auto& entry = entries[texture];
+    if (!entry.live) return;
+    for (auto i = entry.first_level; i < entry.level_bytes.size(); i++) resident -= entry.level_bytes[i];
+    entry = Entry{};
+}
+
+auto Texture_Residency::request(Handle texture, std::uint32_t level, std::uint64_t frame) -> void
+{
+    auto& entry = entries[texture];
+    entry.wanted_level = entry.last_used == frame ? std::min(entry.wanted_level, level) : level;
+    entry.last_used = frame;
+}
+
+// The least recently used texture with a level to give up, preferring the one whose finest level
+// frees the most; entries.size() when there is none. Textures used as recently as the growing one
+// only give up levels finer than they want.
+auto Texture_Residency::find_victim(Handle growing) const -> Handle
+{
+    auto const& grower = entries[growing];
+    auto victim = entries.size();
+    for (auto i = (size_t) 0; i < entries.size(); i++) {
+        auto const& entry = entries[i];
+        if (!entry.live || i == growing || entry.first_level >= entry.tail_level) continue;
+        if (entry.last_used >= grower.last_used && entry.first_level >= entry.wanted_level) continue;
+
+        if (victim == entries.size()) {
+            victim = i;
+            continue;
+        }
+        auto const& best = entries[victim];
+        if (entry.last_used < best.last_used ||
+            (entry.last_used == best.last_used && entry.level_bytes[entry.first_level] > best.level_bytes[best.first_level])) {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+auto Texture_Residency::update(std::uint64_t frame, std::size_t max_uploads) -> std::vector<Change>
+{
+    auto growing = std::vector<Handle>{};
+    for (auto i = (size_t) 0; i < entries.size(); i++) {
+        auto const& entry = entries[i];
+        if (entry.live && entry.last_used == frame && entry.wanted_level < entry.first_level) growing.emplace_back(i);
+    }
+    std::stable_sort(growing.begin(), growing.end(), [this] (Handle a, Handle b) {
+        return entries[a].first_level - entries[a].wanted_level > entries[b].first_level - entries[b].wanted_level;
+    });
+
+    auto touched = std::vector<Handle>{};
+    auto uploaded = (size_t) 0;
+    for (auto texture: growing) {
+        if (uploaded == max_uploads) break;
+
+        auto& entry = entries[texture];
+        auto bytes = entry.level_bytes[entry.first_level - 1];
+        auto evicted = std::vector<Handle>{};
+        while (resident + bytes > budget_bytes) {
+            auto victim = find_victim(texture);
+            if (victim == entries.size()) break;
+            auto& loser = entries[victim];
+            resident -= loser.level_bytes[loser.first_level];
+            loser.first_level++;
+            evicted.emplace_back(victim);
+        }
+        if (resident + bytes > budget_bytes) {
+            // Nothing more may go: put back what was taken for this texture and leave it as it is.
+            for (auto victim: evicted) {
+                auto& loser = entries[victim];
+                loser.first_level--;
+                resident += loser.level_bytes[loser.first_level];
+            }
+            continue;
+        }
+
+        evictions += evicted.size();
+        touched.insert(touched.end(), evicted.begin(), evicted.end());
+        entry.first_level--;
+        resident += bytes;
+        touched.emplace_back(texture);
+        uploads++;
+        uploaded++;
+    }
+
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    auto changes = std::vector<Change>{};
+    for (auto texture: touched) {
+        auto change = Change{};
+        change.texture = texture;
+        change.first_level = entries[texture].first_level;
+        changes.emplace_back(change);
+    }
+    return changes;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "texture_cooker.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The finest level worth having of a texture with level_count levels whose top level is width x
+// height, drawn about pixels wide on screen: any finer level would only be minified away. The
+// texture is assumed to span its surface once.
+auto wanted_mip_level(std::uint32_t width, std::uint32_t height, std::uint32_t level_count, float pixels) -> std::uint32_t;
+
+// Which mip levels of which textures are in VRAM, as the finest resident level of each: that level
+// and every coarser one are. A texture starts with its tail, the levels no larger than tail_size,
+// so it can be drawn right away, and the tail stays for as long as the texture does. Finer levels
+// come one per update as requests ask for them; to stay within the budget the textures least
+// recently requested give up their finest levels first. Only the bookkeeping lives here, the
+// caller makes the images match the changes update() returns.
+class Texture_Residency final
+{
+public:
+    using Handle = std::size_t;
+
+    struct Change final
+    {
+        Handle texture{};
+        std::uint32_t first_level{};    // finest level resident from now on
+    };
+
+    Texture_Residency() = default;
+    Texture_Residency(std::uint64_t budget, std::uint32_t tail_size);
+
+    // Starts tracking a texture with its tail resident; first_level() tells which that is.
+    auto add(Cooked_Texture const& texture) -> Handle;
+    auto remove(Handle texture) -> void;
+
+    // The texture is drawn this frame and wants level and coarser. The finest of a frame's requests counts.
+    auto request(Handle texture, std::uint32_t level, std::uint64_t frame) -> void;
+
+    // Brings at most max_uploads textures one level closer to what they want, those used most
+    // recently and missing the most levels first, and evicts what has to go for them to fit.
+    // Textures used no less recently than the one growing are never evicted below what they want.
+    auto update(std::uint64_t frame, std::size_t max_uploads) -> std::vector<Change>;
+
+    auto first_level(Handle texture) const -> std::uint32_t { return entries[texture].first_level; }
+    auto resident_bytes() const -> std::uint64_t { return resident; }
+    auto budget() const -> std::uint64_t { return budget_bytes; }
+    auto uploaded_levels() const -> std::size_t { return uploads; }
+    auto evicted_levels() const -> std::size_t { return evictions; }
+
+private:
+    struct Entry final
+    {
+        std::vector<std::uint64_t> level_bytes{};   // largest first
+        std::uint32_t tail_level{};                 // finest level of the tail
+        std::uint32_t first_level{};
+        std::uint32_t wanted_level{};               // finest requested in frame last_used
+        std::uint64_t last_used{};
+        bool live{false};
+    };
+
+    auto find_victim(Handle growing) const -> Handle;
+
+    std::uint64_t budget_bytes{std::uint64_t(256) << 20};
+    std::uint32_t tail_size{64};
+    std::vector<Entry> entries{};       // removed ones are reused by add()
+    std::uint64_t resident{0};
+    std::size_t uploads{0};
+    std::size_t evictions{0};
+};
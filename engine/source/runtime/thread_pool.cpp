@@ -0,0 +1,115 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+Thread_Pool::Thread_Pool(std::size_t thread_count)
+{
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(thread_count);
+    for (auto i = (size_t) 0; i < thread_count; i++) {
+        workers.emplace_back([this] { worker_loop(); });
+    }
+}
+
+Thread_Pool::~Thread_Pool()
+{
+    {
+        auto lock = std::lock_guard{tasks_mutex};
+        stopping = true;
+    }
+    tasks_available.notify_all();
+
+    for (auto& worker: workers) {
+        worker.join();
+    }
+}
+
+auto Thread_Pool::enqueue(std::function<void()> task) -> void
+{
+    {
+        auto lock = std::lock_guard{tasks_mutex};
+        tasks.emplace_back(std::move(task));
+    }
+    tasks_available.notify_one();
+}
+
+auto Thread_Pool::worker_loop() -> void
+{
+    while (true) {
+        auto task = std::function<void()>{};
+        {
+            auto lock = std::unique_lock{tasks_mutex};
+            tasks_available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+auto Thread_Pool::parallel_for(std::size_t count, std::function<void(std::size_t)> const& body) -> void
+{
+    if (count == 0) return;
+
+    // Helpers may only start after this call returned, so everything they touch is shared.
+    struct Shared_State final
+    {
+        std::function<void(std::size_t)> body;
+        std::size_t count{};
+        std::atomic<std::size_t> next_index{0};
+        std::atomic<std::size_t> finished{0};
+        std::mutex mutex{};
+        std::condition_variable all_finished{};
+        std::exception_ptr error{};
+    };
+
+    auto state = std::make_shared<Shared_State>();
+    state->body = body;
+    state->count = count;
+
+    auto run = [] (Shared_State& state) {
+        for (auto i = state.next_index++; i < state.count; i = state.next_index++) {
+            try {
+                state.body(i);
+            } catch (...) {
+                auto lock = std::lock_guard{state.mutex};
+                if (!state.error) state.error = std::current_exception();
+            }
+
+            if (++state.finished == state.count) {
+                auto lock = std::lock_guard{state.mutex};
+                state.all_finished.notify_all();
+            }
+        }
+    };
+
+    auto helper_count = std::min(workers.size(), count - 1);
+    for (auto i = (size_t) 0; i < helper_count; i++) {
+        enqueue([state, run] { run(*state); });
+    }
+
+    run(*state);
+
+    auto lock = std::unique_lock{state->mutex};
+    state->all_finished.wait(lock, [&] { return state->finished == state->count; });
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+auto for_each_index(Thread_Pool* thread_pool, std::size_t count, std::function<void(std::size_t)> const& body) -> void
+{
+    if (thread_pool) {
+        thread_pool->parallel_for(count, body);
+    } else {
+        for (auto i = (size_t) 0; i < count; i++) body(i);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class Thread_Pool final
+{
+public:
+    // Zero threads means one per hardware thread.
+    explicit Thread_Pool(std::size_t thread_count = 0);
+    ~Thread_Pool();
+
+    Thread_Pool(Thread_Pool const&) = delete;
+    auto operator=(Thread_Pool const&) -> Thread_Pool& = delete;
+
+    auto size() const -> std::size_t { return workers.size(); }
+
+    template <typename Function>
+    auto submit(Function&& function) -> std::future<std::invoke_result_t<std::decay_t<Function>>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<Function>>;
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        auto future = task->get_future();
+        enqueue([task] { (*task)(); });
+        return future;
+    }
+
+    // Runs body(i) for every i in [0, count) and blocks until all of them finished.
+    // Indices are handed out one at a time, so uneven work (one huge mesh, many small
+    // ones) still balances. The calling thread takes part, which keeps nested calls from
+    // a worker deadlock-free. The first exception thrown by body is rethrown here.
+    auto parallel_for(std::size_t count, std::function<void(std::size_t)> const& body) -> void;
+
+private:
+    auto enqueue(std::function<void()> task) -> void;
+    auto worker_loop() -> void;
+
+    std::vector<std::thread> workers{};
+    std::deque<std::function<void()>> tasks{};
+    std::mutex tasks_mutex{};
+    std::condition_variable tasks_available{};
+    bool stopping{false};
+};
+
+// Runs body(i) for i in [0, count), on the pool when one was given.
+// Every body writes only to its own slot, so the result matches the serial path.
+auto for_each_index(Thread_Pool* thread_pool, std::size_t count, std::function<void(std::size_t)> const& body) -> void;
@@ -0,0 +1,54 @@
+#include "transform_hierarchy.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+Transform_Hierarchy::Transform_Hierarchy(std::vector<Assimp_Model::Node> const& nodes)
+{
+    parents.reserve(nodes.size());
+    locals.reserve(nodes.size());
+    for (auto i = (size_t) 0; i < nodes.size(); i++) {
+        auto parent = nodes[i].parent;
+        if (parent >= Node_Index(i)) {
+            throw std::runtime_error("node hierarchy is not in level order!");
+        }
+        parents.emplace_back(parent);
+        locals.emplace_back(nodes[i].transformation);
+    }
+
+    worlds.resize(nodes.size(), glm::mat4{1.0f});
+    dirty.resize(nodes.size(), 1);
+    first_dirty = 0;
+    update();
+}
+
+auto Transform_Hierarchy::set_local(Node_Index node, glm::mat4 const& transformation) -> void
+{
+    locals[node] = transformation;
+    dirty[node] = 1;
+    first_dirty = std::min(first_dirty, std::size_t(node));
+}
+
+auto Transform_Hierarchy::update() -> std::size_t
+{
+    auto const count = size();
+    auto updated = (size_t) 0;
+
+    // Dirtiness flows down through the parent flags, which are always final by the time a
+    // child is visited. Clean nodes cost one flag test, so thousands of static nodes stay cheap.
+    for (auto i = first_dirty; i < count; i++) {
+        auto parent = parents[i];
+        auto parent_dirty = parent >= 0 && dirty[parent];
+        if (!dirty[i] && !parent_dirty) continue;
+
+        worlds[i] = parent >= 0 ? worlds[parent] * locals[i] : locals[i];
+        dirty[i] = 1;
+        updated++;
+    }
+
+    // Flags are only cleared once the pass is over, children read them above.
+    for (auto i = first_dirty; i < count; i++) dirty[i] = 0;
+    first_dirty = count;
+
+    return updated;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "loader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// World transforms of a model's nodes, kept as parallel arrays in the level order of
+// Assimp_Model::nodes. Parents always come before their children, so one forward pass
+// over the arrays updates every world matrix without recursion or lookups.
+class Transform_Hierarchy final
+{
+public:
+    using Node_Index = Assimp_Model::Array_Index;
+
+    Transform_Hierarchy() = default;
+    explicit Transform_Hierarchy(std::vector<Assimp_Model::Node> const& nodes);
+
+    auto size() const -> std::size_t { return parents.size(); }
+
+    auto local(Node_Index node) const -> glm::mat4 const& { return locals[node]; }
+    auto world(Node_Index node) const -> glm::mat4 const& { return worlds[node]; }
+    auto parent(Node_Index node) const -> Node_Index { return parents[node]; }
+
+    // Marks node and with it its whole subtree for the next update().
+    auto set_local(Node_Index node, glm::mat4 const& transformation) -> void;
+
+    // Recomputes the world matrices of dirty subtrees and returns how many were written.
+    auto update() -> std::size_t;
+
+private:
+    std::vector<Node_Index> parents{};
+    std::vector<glm::mat4> locals{};
+    std::vector<glm::mat4> worlds{};
+    std::vector<std::uint8_t> dirty{};
+    std::size_t first_dirty{};      // nothing before it needs an update, size() when clean
+};
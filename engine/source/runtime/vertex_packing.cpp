@@ -0,0 +1,143 @@
+#include "vertex_packing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+inline namespace
+{
+    constexpr auto unorm16_max = 65535.0f;
+    constexpr auto unorm8_max = 255.0f;
+
+    auto quantize(float value, float offset, float scale, float max) -> std::uint32_t
+    {
+        if (scale <= 0.0f) return 0;
+        return std::uint32_t(std::clamp((value - offset) / scale, 0.0f, max) + 0.5f);
+    }
+
+    // Folds the lower hemisphere over the diagonals, so the whole sphere maps onto [-1, 1]^2.
+    auto octahedral_wrap(glm::vec2 v) -> glm::vec2
+    {
+        return glm::vec2{
+            (1.0f - std::abs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::abs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f),
+        };
+    }
+}
+
+auto compute_vertex_quantization(Assimp_Model::Mesh const& mesh) -> Vertex_Quantization
+{
+    auto const& position = mesh.vertex_info.position;
+    auto const& tex_coord = mesh.vertex_info.texcoord;
+
+    auto quantization = Vertex_Quantization{};
+    quantization.tex_coord_transform = glm::vec4{0.0f, 0.0f, 1.0f, 1.0f};
+
+    if (!position.empty()) {
+        auto lower = glm::vec3{std::numeric_limits<float>::max()};
+        auto upper = glm::vec3{std::numeric_limits<float>::lowest()};
+        for (auto const& p: position) {
+            lower = glm::min(lower, p);
+            upper = glm::max(upper, p);
+        }
+        quantization.position_offset = glm::vec4{lower, 0.0f};
+        quantization.position_scale = glm::vec4{(upper - lower) / unorm16_max, 0.0f};
+    }
+
+    if (!tex_coord.empty()) {
+        auto lower = glm::vec2{std::numeric_limits<float>::max()};
+        auto upper = glm::vec2{std::numeric_limits<float>::lowest()};
+        for (auto const& uv: tex_coord) {
+            lower = glm::min(lower, uv);
+            upper = glm::max(upper, uv);
+        }
+        quantization.tex_coord_transform = glm::vec4{lower, upper - lower};
+    }
+
+    return quantization;
+}
+
+auto pack_position(Vertex_Quantization const& quantization, glm::vec3 position) -> glm::u16vec3
+{
+    auto const& offset = quantization.position_offset;
+    auto const& scale = quantization.position_scale;
+    return glm::u16vec3{
+        quantize(position.x, offset.x, scale.x, unorm16_max),
+        quantize(position.y, offset.y, scale.y, unorm16_max),
+        quantize(position.z, offset.z, scale.z, unorm16_max),
+    };
+}
+
+auto unpack_position(Vertex_Quantization const& quantization, glm::u16vec3 packed) -> glm::vec3
+{
+    return glm::vec3{quantization.position_offset} + glm::vec3{packed} * glm::vec3{quantization.position_scale};
+}
+
+auto pack_tex_coord(Vertex_Quantization const& quantization, glm::vec2 tex_coord) -> glm::u16vec2
+{
+    auto const& transform = quantization.tex_coord_transform;
+    return glm::u16vec2{
+        quantize(tex_coord.x, transform.x, transform.z / unorm16_max, unorm16_max),
+        quantize(tex_coord.y, transform.y, transform.w / unorm16_max, unorm16_max),
+    };
+}
+
+auto unpack_tex_coord(Vertex_Quantization const& quantization, glm::u16vec2 packed) -> glm::vec2
+{
+    auto const& transform = quantization.tex_coord_transform;
+    return glm::vec2{transform.x, transform.y} + glm::vec2{packed} / unorm16_max * glm::vec2{transform.z, transform.w};
+}
+
+auto pack_normal(glm::vec3 normal) -> std::uint16_t
+{
+    auto length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length <= 0.0f) return pack_normal(glm::vec3{0.0f, 0.0f, 1.0f});
+
+    auto v = glm::vec2{normal.x, normal.y} / length;
+    if (normal.z < 0.0f) v = octahedral_wrap(v);
+
+    auto x = quantize(v.x, -1.0f, 2.0f / unorm8_max, unorm8_max);
+    auto y = quantize(v.y, -1.0f, 2.0f / unorm8_max, unorm8_max);
+    return std::uint16_t(x | (y << 8));
+}
+
+auto unpack_normal(std::uint16_t packed) -> glm::vec3
+{
+    auto v = glm::vec2{float(packed & 0xff), float(packed >> 8)} / unorm8_max * 2.0f - 1.0f;
+    auto z = 1.0f - std::abs(v.x) - std::abs(v.y);
+    if (z < 0.0f) v = octahedral_wrap(v);
+    return glm::normalize(glm::vec3{v, z});
+}
+
+auto pack_color(glm::vec4 color) -> glm::u8vec4
+{
+    return glm::u8vec4{
+        quantize(color.r, 0.0f, 1.0f / unorm8_max, unorm8_max),
+        quantize(color.g, 0.0f, 1.0f / unorm8_max, unorm8_max),
+        quantize(color.b, 0.0f, 1.0f / unorm8_max, unorm8_max),
+        quantize(color.a, 0.0f, 1.0f / unorm8_max, unorm8_max),
+    };
+}
+
+auto measure_packing_error(Assimp_Model::Mesh const& mesh, Vertex_Quantization const& quantization) -> Vertex_Packing_Error
+{
+    auto error = Vertex_Packing_Error{};
+
+    for (auto const& p: mesh.vertex_info.position) {
+        error.position = std::max(error.position, glm::length(unpack_position(quantization, pack_position(quantization, p)) - p));
+    }
+
+    for (auto const& uv: mesh.vertex_info.texcoord) {
+        auto delta = glm::abs(unpack_tex_coord(quantization, pack_tex_coord(quantization, uv)) - uv);
+        error.tex_coord = std::max(error.tex_coord, std::max(delta.x, delta.y));
+    }
+
+    for (auto const& n: mesh.vertex_info.normal) {
+        auto length = glm::length(n);
+        if (length <= 0.0f) continue;
+        auto cosine = std::clamp(glm::dot(unpack_normal(pack_normal(n)), n / length), -1.0f, 1.0f);
+        error.normal_degrees = std::max(error.normal_degrees, glm::degrees(std::acos(cosine)));
+    }
+
+    return error;
+}
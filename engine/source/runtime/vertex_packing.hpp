@@ -0,0 +1,42 @@
+#pragma once
+#include "loader.hpp"
+
+#include <glm/gtc/type_precision.hpp>
+
+#include <cstdint>
+
+// Maps the positions and texture coordinates of one mesh onto 16 bit integers.
+// Laid out as the push constant block of triangle_packed.vert:
+//   position = position_offset + uint value * position_scale
+//   tex_coord = tex_coord_transform.xy + unorm value * tex_coord_transform.zw
+struct Vertex_Quantization final
+{
+    glm::vec4 position_offset{};        // xyz, mesh bounds minimum
+    glm::vec4 position_scale{};         // xyz, mesh bounds extent / 65535
+    glm::vec4 tex_coord_transform{};    // xy offset, zw scale
+};
+
+// Largest difference between the packed and the original attributes.
+struct Vertex_Packing_Error final
+{
+    float position{};           // object space distance
+    float tex_coord{};
+    float normal_degrees{};
+};
+
+auto compute_vertex_quantization(Assimp_Model::Mesh const& mesh) -> Vertex_Quantization;
+
+auto pack_position(Vertex_Quantization const& quantization, glm::vec3 position) -> glm::u16vec3;
+auto unpack_position(Vertex_Quantization const& quantization, glm::u16vec3 packed) -> glm::vec3;
+
+auto pack_tex_coord(Vertex_Quantization const& quantization, glm::vec2 tex_coord) -> glm::u16vec2;
+auto unpack_tex_coord(Vertex_Quantization const& quantization, glm::u16vec2 packed) -> glm::vec2;
+
+// Octahedral unit vector encoding (Cigolle et al. 2014), x in the low byte and y in the high byte, both unorm8.
+auto pack_normal(glm::vec3 normal) -> std::uint16_t;
+auto unpack_normal(std::uint16_t packed) -> glm::vec3;
+
+auto pack_color(glm::vec4 color) -> glm::u8vec4;
+
+// Round trips every vertex of mesh through the packed encoding.
+auto measure_packing_error(Assimp_Model::Mesh const& mesh, Vertex_Quantization const& quantization) -> Vertex_Packing_Error;